@@ -14,7 +14,7 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
-#include "miniScene/Scene.h"
+#include "miniScene/SceneWriter.h"
 #include <fstream>
 
 using namespace mini;
@@ -22,8 +22,9 @@ using namespace mini;
 void usage(const std::string &msg)
 {
   if (!msg.empty()) std::cerr << std::endl << "***Error***: " << msg << std::endl << std::endl;
-  std::cout << "Usage: ./binmesh2mini in.binmesh -o out.mini" << std::endl;
-  std::cout << "Imports a 'binmesh' formatted mesh into a mini scene.\n";
+  std::cout << "Usage: ./binmesh2mini in.binmesh [more.binmesh ...] -o out.mini" << std::endl;
+  std::cout << "Imports one or more 'binmesh' formatted meshes into a mini scene,\n";
+  std::cout << "as a single object with one mesh per input file.\n";
   std::cout << "Each binmesh is a binary file with the following structure:\n";
   std::cout << "  size_t numVertices\n";
   std::cout << "  vec3f  vertices[numVertices]\n";
@@ -32,24 +33,9 @@ void usage(const std::string &msg)
   exit(msg != "");
 }
 
-int main(int ac, char **av)
+/*! reads a single binmesh file */
+Mesh::SP loadBinMesh(const std::string &inFileName)
 {
-  std::string inFileName = "";
-  std::string outFileName = "";
-  
-  for (int i=1;i<ac;i++) {
-    const std::string arg = av[i];
-    if (arg == "-o") {
-      outFileName = av[++i];
-    } else if (arg[0] != '-')
-      inFileName = arg;
-    else
-      usage("unknown cmd line arg '"+arg+"'");
-  }
-    
-  if (inFileName.empty()) usage("no input file name specified");
-  if (outFileName.empty()) usage("no output file name base specified");
-  
   std::cout << MINI_TERMINAL_BLUE
             << "loading binmesh file from " << inFileName
             << MINI_TERMINAL_DEFAULT << std::endl;
@@ -57,6 +43,8 @@ int main(int ac, char **av)
   Mesh::SP mesh = Mesh::create();
   
   std::ifstream in(inFileName,std::ios::binary);
+  if (!in.good())
+    throw std::runtime_error("could not open '"+inFileName+"'");
   size_t numVertices;
   size_t numTriangles;
 
@@ -67,14 +55,45 @@ int main(int ac, char **av)
   in.read((char*)&numTriangles,sizeof(numTriangles));
   mesh->indices.resize(numTriangles);
   in.read((char*)mesh->indices.data(),numTriangles*sizeof(vec3i));
-  mesh->material = DisneyMaterial::create();
+  if (!in.good())
+    throw std::runtime_error("error reading '"+inFileName+"'");
+  return mesh;
+}
+
+int main(int ac, char **av)
+{
+  std::vector<std::string> inFileNames;
+  std::string outFileName = "";
   
-  Object::SP object = Object::create({mesh});
-  Scene::SP scene = Scene::create({Instance::create(object)});
+  for (int i=1;i<ac;i++) {
+    const std::string arg = av[i];
+    if (arg == "-o") {
+      outFileName = av[++i];
+    } else if (arg[0] != '-')
+      inFileNames.push_back(arg);
+    else
+      usage("unknown cmd line arg '"+arg+"'");
+  }
+    
+  if (inFileNames.empty()) usage("no input file name specified");
+  if (outFileName.empty()) usage("no output file name base specified");
+
+  // write each mesh as soon as it's read, so we never hold more than
+  // one of them in memory
+  SceneWriter::SP writer = SceneWriter::create(outFileName);
+  Material::SP material = DisneyMaterial::create();
+  writer->addMaterial(material);
+  writer->beginObject();
+  for (auto inFileName : inFileNames) {
+    Mesh::SP mesh = loadBinMesh(inFileName);
+    mesh->material = material;
+    writer->addMesh(mesh);
+  }
+  writer->addInstance(writer->endObject());
   std::cout << MINI_TERMINAL_DEFAULT
-            << "done importing; saving to " << outFileName
+            << "done importing; finalizing " << outFileName
             << MINI_TERMINAL_DEFAULT << std::endl;
-  scene->save(outFileName);
+  writer->finalize();
   std::cout << MINI_TERMINAL_LIGHT_GREEN
             << "scene saved"
             << MINI_TERMINAL_DEFAULT << std::endl;
@@ -62,8 +62,6 @@ int main(int ac, char **av)
             << MINI_TERMINAL_DEFAULT << std::endl;
   
   Object::SP object = Object::create();
-  Mesh::SP mesh = Mesh::create();
-  mesh->material = DisneyMaterial::create();
   
   std::ifstream in(inFileName,std::ios::binary);
 
@@ -77,6 +75,20 @@ int main(int ac, char **av)
   std::vector<vec3f> vertices(numVertices);
   in.read((char*)vertices.data(),numVertices*sizeof(vec3f));
 
+  // the current mesh's arrays get built in plain vectors, and only
+  // moved into a mesh once it's complete
+  std::vector<vec3f> meshVertices;
+  std::vector<vec3i> meshIndices;
+  auto emitMesh = [&]() {
+    Mesh::SP mesh = Mesh::create();
+    mesh->material = DisneyMaterial::create();
+    mesh->vertices = std::move(meshVertices);
+    mesh->indices  = std::move(meshIndices);
+    object->meshes.push_back(mesh);
+    meshVertices.clear();
+    meshIndices.clear();
+  };
+  
   std::map<size_t,int> currentVertices;
   for (size_t triID=0;triID<std::min(numTriangles,maxTriangles);triID++) {
     vec3ul inputTri;
@@ -86,26 +98,24 @@ int main(int ac, char **av)
       size_t idx = (&inputTri.x)[i];
       auto it = currentVertices.find(idx);
       if (it == currentVertices.end()) {
-        miniTri[i] = mesh->vertices.size();
-        mesh->vertices.push_back(vertices[idx]);
+        miniTri[i] = meshVertices.size();
+        meshVertices.push_back(vertices[idx]);
         currentVertices[idx] = miniTri[i];
       } else {
         miniTri[i] = it->second;
       }
     }
-    mesh->indices.push_back(miniTri);
-    if (mesh->vertices.size() >= maxMeshSize) {
-      object->meshes.push_back(mesh);
-      mesh = mini::Mesh::create();
-      mesh->material = mini::DisneyMaterial::create();
+    meshIndices.push_back(miniTri);
+    if (meshVertices.size() >= maxMeshSize) {
+      emitMesh();
       currentVertices.clear();
       std::cout << "[" << prettyNumber(triID+1) << "]" << std::flush;
     }
   }
   std::cout << "[" << prettyNumber(numTriangles) << "]" << std::flush;
   std::cout << std::endl;
-  if (!mesh->indices.empty())
-    object->meshes.push_back(mesh);
+  if (!meshIndices.empty())
+    emitMesh();
   
   Scene::SP scene = Scene::create({Instance::create(object)});
   std::cout << MINI_TERMINAL_DEFAULT
@@ -44,9 +44,11 @@ namespace mini {
   };
 
   /*! find vertex with given position, normal, texcoord, and return
-    its vertex ID, or, if it doesn't exit, add it to the mesh, and
-    its just-created index */
-  int addVertex(Mesh::SP mesh,
+    its vertex ID, or, if it doesn't exit, add it to the given (mesh)
+    arrays, and its just-created index */
+  int addVertex(std::vector<vec3f> &vertices,
+                std::vector<vec3f> &normals,
+                std::vector<vec2f> &texcoords,
                 tinyobj::attrib_t &attributes,
                 const tinyobj::index_t &idx,
                 std::map<tinyobj::index_t,int,index_less> &knownVertices)
@@ -58,17 +60,17 @@ namespace mini {
     const vec3f *normal_array   = (const vec3f*)attributes.normals.data();
     const vec2f *texcoord_array = (const vec2f*)attributes.texcoords.data();
     
-    int newID = (int)mesh->vertices.size();
+    int newID = (int)vertices.size();
     knownVertices[idx] = newID;
 
-    mesh->vertices.push_back(vertex_array[idx.vertex_index]);
+    vertices.push_back(vertex_array[idx.vertex_index]);
     if (idx.normal_index >= 0) {
-      while (mesh->normals.size() < mesh->vertices.size())
-        mesh->normals.push_back(normal_array[idx.normal_index]);
+      while (normals.size() < vertices.size())
+        normals.push_back(normal_array[idx.normal_index]);
     }
     if (idx.texcoord_index >= 0) {
-      while (mesh->texcoords.size() < mesh->vertices.size())
-        mesh->texcoords.push_back(texcoord_array[idx.texcoord_index]);
+      while (texcoords.size() < vertices.size())
+        texcoords.push_back(texcoord_array[idx.texcoord_index]);
     }
     
     return newID;
@@ -272,6 +274,11 @@ namespace mini {
       for (int materialID : materialIDs) {
         std::map<tinyobj::index_t,int,index_less> knownVertices;
         Mesh::SP mesh = std::make_shared<Mesh>();
+        // (get the arrays for writing once, rather than per vertex)
+        std::vector<vec3f> &vertices  = mesh->vertices.edit();
+        std::vector<vec3f> &normals   = mesh->normals.edit();
+        std::vector<vec2f> &texcoords = mesh->texcoords.edit();
+        std::vector<vec3i> &indices   = mesh->indices.edit();
           
         for (size_t faceID=0;faceID<shape.mesh.material_ids.size();faceID++) {
           if (shape.mesh.material_ids[faceID] != materialID) continue;
@@ -281,10 +288,10 @@ namespace mini {
           tinyobj::index_t idx1 = shape.mesh.indices[3*faceID+1];
           tinyobj::index_t idx2 = shape.mesh.indices[3*faceID+2];
           
-          vec3i idx(addVertex(mesh, attributes, idx0, knownVertices),
-                    addVertex(mesh, attributes, idx1, knownVertices),
-                    addVertex(mesh, attributes, idx2, knownVertices));
-          mesh->indices.push_back(idx);
+          vec3i idx(addVertex(vertices, normals, texcoords, attributes, idx0, knownVertices),
+                    addVertex(vertices, normals, texcoords, attributes, idx1, knownVertices),
+                    addVertex(vertices, normals, texcoords, attributes, idx2, knownVertices));
+          indices.push_back(idx);
         }
         Texture::SP diffuseTexture = {};
         DisneyMaterial::SP baseMaterial  = {};
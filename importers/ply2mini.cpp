@@ -14,7 +14,7 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
-#include "miniScene/Scene.h"
+#include "miniScene/SceneWriter.h"
 //std
 #include <set>
 #include "happly.h"
@@ -37,20 +37,24 @@ namespace mini {
     Mesh::SP mesh = std::make_shared<Mesh>();
     mesh->material = dummyMaterial;
     
+    // (get the arrays for writing once, rather than per element)
+    std::vector<vec3f> &vertices = mesh->vertices.edit();
+    std::vector<vec3i> &indices  = mesh->indices.edit();
+    vertices.reserve(vPos.size());
     for (auto v : vPos)
-      mesh->vertices.push_back({(float)v[0],(float)v[1],(float)v[2]});
+      vertices.push_back({(float)v[0],(float)v[1],(float)v[2]});
     for (auto idx : fInd) {
       for (int i=2;i<3;i++) {
         const vec3i tri = {(int)idx[0],(int)idx[i-1],(int)idx[i]};
         bool dropThis = false;
         for (int d=0;d<3;d++) 
-          if (tri[d] < 0 || tri[d] >= mesh->vertices.size()) 
+          if (tri[d] < 0 || tri[d] >= vertices.size()) 
             dropThis = true;
         
         if (dropThis) 
           numDropped++;
         else
-          mesh->indices.push_back(tri);
+          indices.push_back(tri);
       }
     }
     std::cout
@@ -68,30 +72,39 @@ namespace mini {
     return scene;
   }
 
-  Scene::SP stitchStanford(const std::string &baseFileName, int numParts)
+  /*! stitches the parts of a stanford scan into a single object, and
+      writes that to the given file. Parts get written as soon as
+      they're stitched, so at any time we only hold two of them in
+      memory */
+  void stitchStanford(const std::string &baseFileName, int numParts,
+                      const std::string &outFileName)
   {
-    std::vector<Mesh::SP> meshes;
+    SceneWriter::SP writer = SceneWriter::create(outFileName);
+    DisneyMaterial::SP material = std::make_shared<DisneyMaterial>();
+    material->baseColor = vec3f(.7f);
+    writer->addMaterial(material);
+    writer->beginObject();
+    
+    Mesh::SP prev;
     for (int i=0;i<numParts;i++) {
       std::stringstream ss;
       ss << baseFileName << "_" << (i+1) << ".ply";
       Scene::SP part = loadPLY(ss.str());
-      meshes.push_back(part->instances[0]->object->meshes[0]);
-    }
-    // the stanford models come with a "matches" file that specifies
-    // which vertices in one mesh *should* be the same as those in the
-    // previous one (but due to numerical issues, are not)
-    std::cout << "read all parts ... doing overlaps" << std::endl;
-    for (int i=1;i<numParts;i++) {
-      std::stringstream ss;
+      Mesh::SP curr = part->instances[0]->object->meshes[0];
+      curr->material = material;
+      if (!prev) { prev = curr; continue; }
+      
+      // the stanford models come with a "matches" file that specifies
+      // which vertices in one mesh *should* be the same as those in the
+      // previous one (but due to numerical issues, are not)
+      ss.str("");
       ss << baseFileName << "_" << i << "_" << (i+1) << ".matches";
       std::cout << "reading matches from " << ss.str() << std::endl;
       std::ifstream in(ss.str());
       if (!in.good())
         throw std::runtime_error("could not read "+ss.str());
 
-      Mesh::SP prev = meshes[i-1];
-      Mesh::SP curr = meshes[i];
-      
+      std::vector<vec3f> &currVertices = curr->vertices.edit();
       std::string line;
       while (std::getline(in,line)) {
         int match[2];
@@ -106,17 +119,19 @@ namespace mini {
         //           << std::endl;
         assert(match[1] <= curr->vertices.size());
         assert(match[0] <= prev->vertices.size());
-        curr->vertices[match[1]] = prev->vertices[match[0]];
+        currVertices[match[1]] = prev->vertices[match[0]];
       }
-    }
 
-    Object::SP model = std::make_shared<Object>();
-    model->meshes = meshes;
+      // 'prev' won't get touched any more
+      writer->addMesh(prev);
+      prev = curr;
+    }
+    writer->addMesh(prev);
+    prev = nullptr;
     
-    Scene::SP scene = std::make_shared<Scene>();
-    scene->instances.push_back(std::make_shared<Instance>(model));
-
-    return scene;
+    int objectID = writer->endObject();
+    writer->addInstance(objectID);
+    writer->finalize();
   }
   
 } // ::mini
@@ -161,15 +176,18 @@ int main(int ac, char **av)
             << "loading PLY model from " << inFileName
             << MINI_TERMINAL_DEFAULT << std::endl;
   
-  mini::Scene::SP scene
-    = standordStitchParts
-    ? mini::stitchStanford(inFileName,standordStitchParts)
-    : mini::loadPLY(inFileName);
-  
-  std::cout << MINI_TERMINAL_DEFAULT
-            << "done importing; saving to " << outFileName
-            << MINI_TERMINAL_DEFAULT << std::endl;
-  scene->save(outFileName);
+  if (standordStitchParts) {
+    std::cout << MINI_TERMINAL_DEFAULT
+              << "stitching parts, and writing them to " << outFileName
+              << MINI_TERMINAL_DEFAULT << std::endl;
+    mini::stitchStanford(inFileName,standordStitchParts,outFileName);
+  } else {
+    mini::Scene::SP scene = mini::loadPLY(inFileName);
+    std::cout << MINI_TERMINAL_DEFAULT
+              << "done importing; saving to " << outFileName
+              << MINI_TERMINAL_DEFAULT << std::endl;
+    scene->save(outFileName);
+  }
   std::cout << MINI_TERMINAL_LIGHT_GREEN
             << "scene saved"
             << MINI_TERMINAL_DEFAULT << std::endl;
@@ -41,6 +41,9 @@ namespace mini {
       if (!in) throw std::runtime_error("could not read STL tri count!?");
 
       Mesh::SP mesh = Mesh::create();
+      // (get the arrays for writing once, rather than per element)
+      std::vector<vec3f> &vertices  = mesh->vertices.edit();
+      std::vector<vec3i> &triangles = mesh->indices.edit();
       for (int triID=0;triID<numTris;triID++) {
         struct { vec3f n, v[3]; } tri;
         in.read((char*)&tri,sizeof(tri));
@@ -54,12 +57,12 @@ namespace mini {
         for (int i=0;i<3;i++) {
           auto thisVtx = tri.v[i];
           if (knownVertices.find(thisVtx) == knownVertices.end()) {
-            knownVertices[thisVtx] = mesh->vertices.size();
-            mesh->vertices.push_back(thisVtx);
+            knownVertices[thisVtx] = vertices.size();
+            vertices.push_back(thisVtx);
           }
           indices[i] = knownVertices[thisVtx];
         }
-        mesh->indices.push_back(indices);
+        triangles.push_back(indices);
       }
       // fclose(out);
       Object::SP object = Object::create({mesh});
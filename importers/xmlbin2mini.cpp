@@ -1,4 +1,5 @@
 #include "miniScene/Scene.h"
+#include "miniScene/SceneBuilder.h"
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <fstream>
@@ -7,8 +8,11 @@ using namespace mini;
 
 #define BAKE_TRANSFORMS 1
 
-Scene::SP g_scene;
-affine3f g_xfm;
+/*! a mesh node to be converted, with the transform it's under */
+struct MeshJob {
+  xmlNode *node;
+  affine3f xfm;
+};
 
 void parse_Other(xmlNode * a_node)
 {
@@ -23,7 +27,8 @@ void parse_Other(xmlNode * a_node)
     }
 }
 
-void parse_AffineSpace(xmlNode *root, const std::vector<uint8_t> &binData)
+void parse_AffineSpace(xmlNode *root, const std::vector<uint8_t> &binData,
+                       affine3f &curXfm)
 {
   const std::string value = (const char *)xmlNodeListGetString(root->doc, root, 1);
   affine3f xfm;
@@ -41,7 +46,7 @@ void parse_AffineSpace(xmlNode *root, const std::vector<uint8_t> &binData)
          &xfm.l.vy.z,
          &xfm.l.vz.z,
          &xfm.p.z);
-  g_xfm = g_xfm * xfm;
+  curXfm = curXfm * xfm;
 }
 
 // TriangleMesh/positions
@@ -524,7 +529,9 @@ Material::SP parse_material(xmlNode *root, const std::vector<uint8_t> &binData)
   // return mat;
 }
 
-void parse_TriangleMesh(xmlNode *root, const std::vector<uint8_t> &binData)
+void parse_TriangleMesh(xmlNode *root, const std::vector<uint8_t> &binData,
+                        const affine3f &curXfm, uint64_t key,
+                        SceneBuilder &builder)
 {
   Mesh::SP mesh = Mesh::create();
   
@@ -551,76 +558,90 @@ void parse_TriangleMesh(xmlNode *root, const std::vector<uint8_t> &binData)
 
 #if BAKE_TRANSFORMS
   for (auto &v : mesh->vertices)
-    v = xfmPoint(g_xfm,v);
+    v = xfmPoint(curXfm,v);
   for (auto &n : mesh->normals)
-    n = xfmNormal(g_xfm,n);
-  g_scene->instances.push_back(Instance::create(Object::create({mesh})));
+    n = xfmNormal(curXfm,n);
+  builder.addInstance(key,Object::create({mesh}));
 #else
-  g_scene->instances.push_back(Instance::create(Object::create({mesh}),g_xfm));
+  builder.addInstance(key,Object::create({mesh}),curXfm);
 #endif
 }
 
-void parse_Group(xmlNode *root, const std::vector<uint8_t> &binData);
-void parse_Transform(xmlNode *root, const std::vector<uint8_t> &binData)
+void parse_Group(xmlNode *root, const std::vector<uint8_t> &binData,
+                 affine3f curXfm, std::vector<MeshJob> &jobs);
+void parse_Transform(xmlNode *root, const std::vector<uint8_t> &binData,
+                     affine3f curXfm, std::vector<MeshJob> &jobs)
 {
-  affine3f saved_xfm = g_xfm;
-
   for (xmlNode *node = root; node; node = node->next) {
     if (node->type != XML_ELEMENT_NODE)
       continue;
     const std::string type = (const char *)node->name;
     if (type == "Transform") {
-      parse_Transform(node->children, binData);
+      parse_Transform(node->children, binData, curXfm, jobs);
     } else if (type == "AffineSpace") {
-      parse_AffineSpace(node->children, binData);
+      parse_AffineSpace(node->children, binData, curXfm);
     } else if (type == "TriangleMesh") {
-      parse_TriangleMesh(node->children, binData);
+      jobs.push_back({node->children,curXfm});
     } else if (type == "Group") {
-      parse_Group(node->children, binData);
+      parse_Group(node->children, binData, curXfm, jobs);
     } else
       throw std::runtime_error("unknown Transform node type '"+type+"'");
   }
-  
-  g_xfm = saved_xfm;
 }
 
 
-void parse_Group(xmlNode *root, const std::vector<uint8_t> &binData)
+void parse_Group(xmlNode *root, const std::vector<uint8_t> &binData,
+                 affine3f curXfm, std::vector<MeshJob> &jobs)
 {
   for (xmlNode *node = root; node; node = node->next) {
     if (node->type != XML_ELEMENT_NODE)
       continue;
     const std::string type = (const char *)node->name;
     if (type == "Group") {
-      parse_Group(node->children, binData);
+      parse_Group(node->children, binData, curXfm, jobs);
     } else if (type == "Transform") {
-      parse_Transform(node->children, binData);
+      parse_Transform(node->children, binData, curXfm, jobs);
     } else if (type == "TriangleMesh") {
-      parse_TriangleMesh(node->children, binData);
+      jobs.push_back({node->children,curXfm});
     } else
       throw std::runtime_error("unknown scene node type '"+type+"'");
   }
 }
 
-void parse_scene(xmlNode *root, const std::vector<uint8_t> &binData)
+void parse_scene(xmlNode *root, const std::vector<uint8_t> &binData,
+                 std::vector<MeshJob> &jobs)
 {
   for (xmlNode *node = root; node; node = node->next) {
     if (node->type != XML_ELEMENT_NODE)
       continue;
     const std::string type = (const char *)node->name;
     if (type == "Group") {
-      parse_Group(node->children,binData);
+      parse_Group(node->children,binData,affine3f(),jobs);
     } else
       throw std::runtime_error("unknown scene node type '"+type+"'");
   }
 }
 
-void parse_root(xmlNode *root, const std::vector<uint8_t> &binData)
+Scene::SP parse_root(xmlNode *root, const std::vector<uint8_t> &binData)
 {
-  if (std::string((const char *)root->name) == "scene")
-    parse_scene(root->children,binData);
-  else
+  if (std::string((const char *)root->name) != "scene")
     throw std::runtime_error("not a BGFScene!?");
+
+  // first, walk the scene graph to find all meshes and their
+  // transforms (cheap) ...
+  std::vector<MeshJob> jobs;
+  parse_scene(root->children,binData,jobs);
+
+  // ... then convert them in parallel, using the mesh's index in the
+  // file as key, so we get the same scene as a serial import
+  SceneBuilder builder;
+  parallel_for
+    (jobs.size(),
+     [&](size_t jobID) {
+       parse_TriangleMesh(jobs[jobID].node,binData,jobs[jobID].xfm,
+                          jobID,builder);
+     });
+  return builder.finalize();
 }
 
 int main(int ac, char **av)
@@ -637,8 +658,6 @@ int main(int ac, char **av)
     else throw std::runtime_error("unknown cmdline arg "+arg);
   }
 
-  g_scene = Scene::create();
-  
   const std::string binFileName = inFileName.substr(0,inFileName.size()-3)+"bin";
   std::ifstream in(binFileName.c_str(),std::ios::binary);
   in.seekg(0, in.end);
@@ -650,10 +669,10 @@ int main(int ac, char **av)
   LIBXML_TEST_VERSION;
   xmlDoc *doc = xmlReadFile(inFileName.c_str(), NULL, 0);
   xmlNode *root = xmlDocGetRootElement(doc);
-  parse_root(root,binData);
+  Scene::SP scene = parse_root(root,binData);
   xmlFreeDoc(doc);
   xmlCleanupParser();
 
-  g_scene->save(outFileName.c_str());
+  scene->save(outFileName.c_str());
   return 0;
 }
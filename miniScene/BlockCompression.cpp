@@ -0,0 +1,430 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/BlockCompression.h"
+#include "miniScene/Codecs.h"
+#include "miniScene/Checksum.h"
+#include "miniScene/IO.h"
+#include <thread>
+#ifndef MINI_HAVE_ZSTD
+# define MINI_HAVE_ZSTD 0
+#endif
+#if MINI_HAVE_ZSTD
+# include <zstd.h>
+#endif
+
+namespace mini {
+
+  bool isBlockCompressionAvailable(BlockCompression compression)
+  {
+    switch (compression) {
+    case BLOCK_COMPRESSION_NONE:
+    case BLOCK_COMPRESSION_LZ:
+      return true;
+    case BLOCK_COMPRESSION_ZSTD:
+      return MINI_HAVE_ZSTD;
+    default:
+      return false;
+    }
+  }
+
+  namespace io {
+
+    /*! number of blocks that get compressed (or decompressed) in
+        parallel; enough to keep all threads busy, but not so many
+        that the batch takes lots of memory */
+    inline size_t blocksPerBatch()
+    { return std::max(4u,2*std::thread::hardware_concurrency()); }
+
+    std::vector<uint8_t> compressBlock(const uint8_t *data, size_t numBytes,
+                                       BlockCompression &compression)
+    {
+      std::vector<uint8_t> stored;
+      switch (compression) {
+      case BLOCK_COMPRESSION_NONE:
+        break;
+      case BLOCK_COMPRESSION_LZ:
+        codecs::lzCompress(stored,data,numBytes);
+        break;
+#if MINI_HAVE_ZSTD
+      case BLOCK_COMPRESSION_ZSTD: {
+        stored.resize(ZSTD_compressBound(numBytes));
+        const size_t size = ZSTD_compress(stored.data(),stored.size(),
+                                          data,numBytes,ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(size))
+          throw std::runtime_error(std::string("zstd compression failed: ")
+                                   +ZSTD_getErrorName(size));
+        stored.resize(size);
+      } break;
+#endif
+      default:
+        throw std::runtime_error("block compression "+std::to_string((int)compression)
+                                 +" is not available in this build");
+      }
+      if (compression == BLOCK_COMPRESSION_NONE || stored.size() >= numBytes) {
+        compression = BLOCK_COMPRESSION_NONE;
+        stored.assign(data,data+numBytes);
+      }
+      return stored;
+    }
+
+    void decompressBlock(uint8_t *out, size_t rawSize,
+                         const uint8_t *stored, size_t storedSize,
+                         BlockCompression compression)
+    {
+      switch (compression) {
+      case BLOCK_COMPRESSION_NONE:
+        if (storedSize != rawSize)
+          throw std::runtime_error("invalid uncompressed block");
+        memcpy(out,stored,rawSize);
+        break;
+      case BLOCK_COMPRESSION_LZ:
+        codecs::lzDecompress(out,rawSize,stored,stored+storedSize);
+        break;
+#if MINI_HAVE_ZSTD
+      case BLOCK_COMPRESSION_ZSTD: {
+        const size_t size = ZSTD_decompress(out,rawSize,stored,storedSize);
+        if (ZSTD_isError(size) || size != rawSize)
+          throw std::runtime_error("corrupt zstd-compressed block");
+      } break;
+#endif
+      default:
+        throw std::runtime_error("block uses compression "+std::to_string((int)compression)
+                                 +", which is not available in this build");
+      }
+    }
+
+    std::vector<BlockInfo> readBlockIndex(std::istream &in)
+    {
+      in.clear();
+      const std::streampos containerBegin = in.tellg();
+      if (readElement<size_t>(in) != block_container_magic)
+        throw std::runtime_error("not a block-compressed file");
+      readElement<uint32_t>(in);
+      const bool checksums = readElement<uint32_t>(in) & BLOCK_FLAG_CHECKSUMS;
+      
+      in.seekg(-std::streamoff((checksums?2:1)*sizeof(uint64_t)+sizeof(size_t)),std::ios::end);
+      const uint64_t indexHash   = checksums ? readElement<uint64_t>(in) : 0;
+      const uint64_t indexOffset = readElement<uint64_t>(in);
+      if (readElement<size_t>(in) != block_container_magic)
+        throw std::runtime_error("not a (complete) block-compressed file");
+      in.seekg(containerBegin+std::streamoff(indexOffset));
+      const uint64_t numBlocks = readElement<uint64_t>(in);
+      if (numBlocks > indexOffset/sizeof(BlockHeader))
+        throw std::runtime_error("corrupt block index in block-compressed file");
+      std::vector<BlockInfo> index(numBlocks);
+      readArray(in,index.data(),index.size());
+      if (checksums
+          && indexHash != XXHash64::hash(index.data(),index.size()*sizeof(index[0])))
+        throw std::runtime_error("corrupt block index in block-compressed file");
+      return index;
+    }
+
+    // ------------------------------------------------------------------
+    // writing
+    // ------------------------------------------------------------------
+
+    BlockWriteBuffer::BlockWriteBuffer(std::ostream &out,
+                                       BlockCompression compression,
+                                       size_t blockSize,
+                                       bool checksums)
+      : out(out),
+        compression(compression),
+        blockSize(blockSize),
+        checksums(checksums)
+    {
+      if (!isBlockCompressionAvailable(compression))
+        throw std::runtime_error("block compression "+std::to_string((int)compression)
+                                 +" is not available in this build");
+      if (blockSize < 4096 || blockSize > (1ull<<30))
+        throw std::runtime_error("invalid block size "+std::to_string(blockSize));
+
+      writeElement(out,block_container_magic);
+      writeElement(out,uint32_t(compression));
+      writeElement(out,uint32_t(checksums ? BLOCK_FLAG_CHECKSUMS : 0));
+      writeElement(out,uint64_t(blockSize));
+      fileOffset = sizeof(size_t)+2*sizeof(uint32_t)+sizeof(uint64_t);
+
+      batch.emplace_back(blockSize);
+      setp((char*)batch.back().data(),(char*)batch.back().data()+blockSize);
+    }
+
+    BlockWriteBuffer::int_type BlockWriteBuffer::overflow(int_type c)
+    {
+      if (finished)
+        return traits_type::eof();
+      // the current block is full
+      if (batch.size() >= blocksPerBatch())
+        writeBatch();
+      batch.emplace_back(blockSize);
+      setp((char*)batch.back().data(),(char*)batch.back().data()+blockSize);
+      if (!traits_type::eq_int_type(c,traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+      }
+      return traits_type::not_eof(c);
+    }
+
+    int BlockWriteBuffer::sync()
+    {
+      // can't write the current block before it's full (or we're
+      // done), but can at least pass on the flush
+      out.flush();
+      return out.good() ? 0 : -1;
+    }
+
+    void BlockWriteBuffer::writeBatch()
+    {
+      // all blocks but the last one are full; the last one may not be
+      batch.back().resize(pptr()-pbase());
+      setp(nullptr,nullptr);
+      if (batch.back().empty())
+        batch.pop_back();
+
+      std::vector<std::vector<uint8_t>> stored(batch.size());
+      std::vector<BlockCompression> storedAs(batch.size(),compression);
+      std::vector<uint64_t> hashes(batch.size());
+      parallel_for
+        (batch.size(),
+         [&](size_t i) {
+           stored[i] = compressBlock(batch[i].data(),batch[i].size(),storedAs[i]);
+           if (checksums)
+             hashes[i] = XXHash64::hash(stored[i].data(),stored[i].size());
+         });
+
+      for (size_t i=0;i<batch.size();i++) {
+        BlockHeader header;
+        header.compression = storedAs[i];
+        header.rawSize     = uint32_t(batch[i].size());
+        header.storedSize  = stored[i].size();
+        writeElement(out,header);
+        writeArray(out,stored[i].data(),stored[i].size());
+        if (checksums)
+          writeElement(out,hashes[i]);
+
+        BlockInfo info;
+        info.fileOffset  = fileOffset;
+        info.rawOffset   = rawOffset;
+        info.rawSize     = header.rawSize;
+        info.compression = header.compression;
+        info.storedSize  = header.storedSize;
+        index.push_back(info);
+
+        fileOffset += sizeof(header)+stored[i].size()+(checksums ? sizeof(uint64_t) : 0);
+        rawOffset  += batch[i].size();
+      }
+      batch.clear();
+      if (!out.good())
+        throw std::runtime_error("error writing block-compressed data");
+    }
+
+    void BlockWriteBuffer::finish()
+    {
+      if (finished) return;
+      writeBatch();
+      finished = true;
+
+      BlockHeader end = { 0, 0, 0 };
+      writeElement(out,end);
+      fileOffset += sizeof(end);
+
+      const uint64_t indexOffset = fileOffset;
+      writeElement(out,uint64_t(index.size()));
+      writeArray(out,index.data(),index.size());
+      if (checksums)
+        writeElement(out,XXHash64::hash(index.data(),index.size()*sizeof(index[0])));
+      writeElement(out,indexOffset);
+      writeElement(out,block_container_magic);
+      out.flush();
+      if (!out.good())
+        throw std::runtime_error("error writing block-compressed data");
+    }
+
+    // ------------------------------------------------------------------
+    // reading
+    // ------------------------------------------------------------------
+
+    BlockReadBuffer::BlockReadBuffer(std::istream &in, bool magicAlreadyRead)
+      : in(in),
+        containerBegin(in.tellg())
+    {
+      if (containerBegin >= 0 && magicAlreadyRead)
+        containerBegin -= sizeof(size_t);
+      if (!magicAlreadyRead && readElement<size_t>(in) != block_container_magic)
+        throw std::runtime_error("not a block-compressed file");
+      readElement<uint32_t>(in);
+      flags = readElement<uint32_t>(in);
+      if (flags & ~BLOCK_FLAG_CHECKSUMS)
+        throw std::runtime_error("block-compressed file uses features this version of miniScene does not support");
+      blockSize = readElement<uint64_t>(in);
+      if (blockSize == 0 || blockSize > (1ull<<30))
+        throw std::runtime_error("invalid block size in block-compressed file");
+      setg(nullptr,nullptr,nullptr);
+    }
+
+    bool BlockReadBuffer::readBatch()
+    {
+      batch.clear();
+      nextBlock = 0;
+      if (atEnd) return false;
+
+      std::vector<BlockHeader>          headers;
+      std::vector<std::vector<uint8_t>> stored;
+      std::vector<uint64_t>             hashes;
+      while (headers.size() < blocksPerBatch()) {
+        BlockHeader header = readElement<BlockHeader>(in);
+        if (header.rawSize == 0 && header.storedSize == 0) {
+          atEnd = true;
+          break;
+        }
+        if (header.rawSize > blockSize || header.storedSize > 2*blockSize+1024)
+          throw std::runtime_error("corrupt block header in block-compressed file");
+        headers.push_back(header);
+        stored.emplace_back(header.storedSize);
+        readArray(in,stored.back().data(),stored.back().size());
+        if (flags & BLOCK_FLAG_CHECKSUMS)
+          hashes.push_back(readElement<uint64_t>(in));
+      }
+
+      batch.resize(headers.size());
+      batchErrors.assign(headers.size(),std::string());
+      parallel_for
+        (headers.size(),
+         [&](size_t i) {
+           // (the batch starts where the current block ends)
+           uint64_t rawOffset = blockRawOffset;
+           for (size_t j=0;j<i;j++) rawOffset += headers[j].rawSize;
+           const std::string where
+             = " at (uncompressed) offset "+std::to_string(rawOffset);
+           if (!hashes.empty()
+               && hashes[i] != XXHash64::hash(stored[i].data(),stored[i].size())) {
+             batchErrors[i] = "checksum mismatch in compressed block"+where;
+             return;
+           }
+           batch[i].resize(headers[i].rawSize);
+           try {
+             decompressBlock(batch[i].data(),headers[i].rawSize,
+                             stored[i].data(),stored[i].size(),
+                             (BlockCompression)headers[i].compression);
+           } catch (const std::exception &e) {
+             batchErrors[i] = std::string(e.what())+where;
+           }
+         });
+      return !batch.empty();
+    }
+
+    BlockReadBuffer::int_type BlockReadBuffer::underflow()
+    {
+      if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+      // done with the current block
+      blockRawOffset += egptr()-eback();
+      setg(nullptr,nullptr,nullptr);
+      while (true) {
+        if (nextBlock == batch.size() && !readBatch())
+          return traits_type::eof();
+        if (!batchErrors[nextBlock].empty())
+          throw std::runtime_error(batchErrors[nextBlock]);
+        std::vector<uint8_t> &block = batch[nextBlock++];
+        if (block.empty()) continue;
+        setg((char*)block.data(),(char*)block.data(),(char*)block.data()+block.size());
+        return traits_type::to_int_type(*gptr());
+      }
+    }
+
+    BlockReadBuffer::pos_type BlockReadBuffer::seekoff(off_type off,
+                                                       std::ios_base::seekdir dir,
+                                                       std::ios_base::openmode which)
+    {
+      const uint64_t current = blockRawOffset+(gptr()-eback());
+      if (dir == std::ios_base::cur) {
+        if (off == 0)
+          // tellg()
+          return pos_type(off_type(current));
+        return seekpos(pos_type(off_type(current)+off),which);
+      }
+      if (dir == std::ios_base::beg)
+        return seekpos(pos_type(off),which);
+      // relative to the end: needs the index
+      if (index.empty() && !loadIndex())
+        return pos_type(off_type(-1));
+      const BlockInfo &last = index.back();
+      return seekpos(pos_type(off_type(last.rawOffset+last.rawSize)+off),which);
+    }
+
+    BlockReadBuffer::pos_type BlockReadBuffer::seekpos(pos_type pos,
+                                                       std::ios_base::openmode which)
+    {
+      const pos_type error = pos_type(off_type(-1));
+      if (!(which & std::ios_base::in) || off_type(pos) < 0)
+        return error;
+      const uint64_t target = uint64_t(off_type(pos));
+
+      // within the current block?
+      if (target >= blockRawOffset && target <= blockRawOffset+(egptr()-eback())) {
+        setg(eback(),eback()+(target-blockRawOffset),egptr());
+        return pos;
+      }
+
+      if (index.empty() && !loadIndex())
+        return error;
+      // the first block that ends after the target
+      auto it = std::upper_bound(index.begin(),index.end(),target,
+                                 [](uint64_t t, const BlockInfo &info)
+                                 { return t < info.rawOffset+info.rawSize; });
+      in.clear();
+      batch.clear();
+      nextBlock = 0;
+      setg(nullptr,nullptr,nullptr);
+      if (it == index.end()) {
+        // at (or beyond) the end; nothing left to read
+        const BlockInfo &last = index.back();
+        if (target > last.rawOffset+last.rawSize)
+          return error;
+        blockRawOffset = target;
+        atEnd = true;
+        return pos;
+      }
+      in.seekg(containerBegin+std::streamoff(it->fileOffset));
+      atEnd = false;
+      blockRawOffset = it->rawOffset;
+      if (!readBatch())
+        return error;
+      if (!batchErrors[nextBlock].empty())
+        throw std::runtime_error(batchErrors[nextBlock]);
+      std::vector<uint8_t> &block = batch[nextBlock++];
+      setg((char*)block.data(),
+           (char*)block.data()+(target-blockRawOffset),
+           (char*)block.data()+block.size());
+      return pos;
+    }
+
+    bool BlockReadBuffer::loadIndex()
+    {
+      if (containerBegin < 0)
+        // not seekable
+        return false;
+      in.clear();
+      const std::streampos current = in.tellg();
+      in.seekg(containerBegin);
+      index = readBlockIndex(in);
+      in.clear();
+      in.seekg(current);
+      return !index.empty();
+    }
+
+  } // ::mini::io
+} // ::mini
@@ -0,0 +1,204 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/common.h"
+#include <streambuf>
+
+namespace mini {
+
+  /*! how the blocks of a block-compressed file get compressed (see
+      SaveOptions::blockCompression) */
+  typedef enum {
+    /*! blocks are stored as they are; for the block container,
+        this also means 'no container at all' */
+    BLOCK_COMPRESSION_NONE=0,
+    /*! the library's own LZ codec (see codecs::lzCompress()) */
+    BLOCK_COMPRESSION_LZ,
+    /*! zstd; only available if the library was built with
+        MINI_USE_ZSTD */
+    BLOCK_COMPRESSION_ZSTD
+  } BlockCompression;
+
+  /*! whether this build of the library can read and write blocks
+      with given compression */
+  bool isBlockCompressionAvailable(BlockCompression compression);
+
+  namespace io {
+
+    /* A block-compressed file is a 'container' around another file
+       (e.g., a .mini file): the inner file's bytes get split into
+       blocks of a fixed (uncompressed) size, each of which gets
+       compressed independently. The container starts with
+
+         size_t   block_container_magic
+         uint32_t default compression
+         uint32_t flags (BLOCK_FLAG_*)
+         uint64_t block size
+
+       followed by all blocks, each one as a BlockHeader and the
+       block's stored bytes (plus, with BLOCK_FLAG_CHECKSUMS, a
+       uint64 XXH64 of those stored bytes), and a final BlockHeader
+       with rawSize 0. Then follows the block index - a uint64 with
+       the number of blocks, and a BlockInfo for every block - and
+       finally (with BLOCK_FLAG_CHECKSUMS) a uint64 XXH64 of the
+       index's BlockInfos, a uint64 with the file offset of the
+       index, and the magic again.
+
+       Since every block has its own header, a container can be read
+       sequentially, from any stream; the index at the end allows
+       random access (for seekable streams). */
+
+    /*! the magic that block-compressed files start (and end) with */
+    const size_t block_container_magic = 4321000101ULL;
+
+    /*! every block's stored bytes are followed by their checksum */
+    const uint32_t BLOCK_FLAG_CHECKSUMS = (1<<0);
+
+    struct BlockHeader {
+      /*! how this block is stored; a BlockCompression */
+      uint32_t compression;
+      /*! the block's uncompressed size */
+      uint32_t rawSize;
+      /*! number of bytes stored for this block */
+      uint64_t storedSize;
+    };
+
+    /*! an entry in a container's block index */
+    struct BlockInfo {
+      /*! offset of the block's BlockHeader in the container */
+      uint64_t fileOffset;
+      /*! offset of the block's data in the inner (uncompressed) file */
+      uint64_t rawOffset;
+      uint32_t rawSize;
+      uint32_t compression;
+      uint64_t storedSize;
+    };
+
+    /*! reads the block index of the block-compressed file that
+        starts at the stream's current position (and extends to its
+        end); the stream has to be seekable. Leaves the stream at an
+        undefined position */
+    std::vector<BlockInfo> readBlockIndex(std::istream &in);
+
+    /*! compresses the given block with given compression, and
+        returns what to store for it; incompressible blocks get
+        returned as they are (with 'compression' set to
+        BLOCK_COMPRESSION_NONE) */
+    std::vector<uint8_t> compressBlock(const uint8_t *data, size_t numBytes,
+                                       BlockCompression &compression);
+
+    /*! decompresses a block's stored data into 'out', which has to
+        have space for rawSize bytes. Throws on invalid data */
+    void decompressBlock(uint8_t *out, size_t rawSize,
+                         const uint8_t *stored, size_t storedSize,
+                         BlockCompression compression);
+
+    /*! a std::streambuf that writes everything written into it as a
+        block-compressed container to another stream. Blocks get
+        compressed in batches, in parallel. finish() has to get
+        called after all data was written, else the container is
+        incomplete. With 'checksums', every block gets stored with
+        its checksum */
+    struct BlockWriteBuffer : public std::streambuf {
+      BlockWriteBuffer(std::ostream &out,
+                       BlockCompression compression=BLOCK_COMPRESSION_LZ,
+                       size_t blockSize=(2<<20),
+                       bool checksums=false);
+
+      /*! writes all remaining blocks, and the block index */
+      void finish();
+
+    protected:
+      int_type overflow(int_type c) override;
+      int sync() override;
+
+      /*! compresses and writes all pending blocks */
+      void writeBatch();
+
+      std::ostream                     &out;
+      const BlockCompression            compression;
+      const size_t                      blockSize;
+      const bool                        checksums;
+      /*! full blocks that haven't been written yet, plus the one
+          currently being filled (always the last one) */
+      std::vector<std::vector<uint8_t>> batch;
+      std::vector<BlockInfo>            index;
+      uint64_t                          fileOffset = 0;
+      uint64_t                          rawOffset  = 0;
+      bool                              finished   = false;
+    };
+
+    /*! a std::streambuf that reads the inner file of a
+        block-compressed container from another stream. Blocks get
+        read (sequentially) in batches, and each batch gets
+        decompressed in parallel. If the underlying stream is
+        seekable, this supports seeking to any (uncompressed)
+        position, which only decompresses the blocks that actually
+        get read. Blocks that have checksums always get verified */
+    struct BlockReadBuffer : public std::streambuf {
+      /*! creates a reader for the container at the current position
+          of 'in'; if the magic was already read from the stream (to
+          check which kind of file it is), set magicAlreadyRead */
+      BlockReadBuffer(std::istream &in, bool magicAlreadyRead=false);
+
+      /*! the container's block size */
+      size_t getBlockSize() const { return blockSize; }
+
+      /*! whether the container's blocks have checksums (which then
+          always get verified before any of a block's data gets
+          read) */
+      bool hasChecksums() const { return flags & BLOCK_FLAG_CHECKSUMS; }
+
+    protected:
+      int_type underflow() override;
+      pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                       std::ios_base::openmode which) override;
+      pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+      /*! reads and decompresses the next batch of blocks, starting
+          at the current position in the underlying stream; returns
+          false at the end of the container */
+      bool readBatch();
+      /*! reads the block index (without changing the position in
+          the underlying stream); returns false if that's not
+          seekable */
+      bool loadIndex();
+
+      std::istream                     &in;
+      /*! where in the underlying stream the container starts; -1 if
+          that stream isn't seekable */
+      std::streampos                    containerBegin;
+      size_t                            blockSize = 0;
+      uint32_t                          flags = 0;
+      /*! the current batch's decompressed blocks */
+      std::vector<std::vector<uint8_t>> batch;
+      /*! per block of the current batch: what's wrong with it, if
+          anything; only reported once the block actually gets read */
+      std::vector<std::string>          batchErrors;
+      /*! the batch's block to read from after the current one */
+      size_t                            nextBlock = 0;
+      /*! (uncompressed) offset of the start of the current block */
+      uint64_t                          blockRawOffset = 0;
+      bool                              atEnd = false;
+      /*! the block index; only read upon the first seek that needs
+          it */
+      std::vector<BlockInfo>            index;
+    };
+
+  } // ::mini::io
+} // ::mini
@@ -0,0 +1,288 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Checksum.h"
+#include "miniScene/IO.h"
+
+namespace mini {
+
+  // ------------------------------------------------------------------
+  // XXH64
+  // ------------------------------------------------------------------
+
+  static const uint64_t XXH_P1 = 11400714785074694791ULL;
+  static const uint64_t XXH_P2 = 14029467366897019727ULL;
+  static const uint64_t XXH_P3 =  1609587929392839161ULL;
+  static const uint64_t XXH_P4 =  9650029242287828579ULL;
+  static const uint64_t XXH_P5 =  2870177450012600261ULL;
+
+  inline uint64_t xxhRotl(uint64_t x, int r)
+  { return (x << r) | (x >> (64-r)); }
+
+  inline uint64_t xxhRead64(const uint8_t *p)
+  { uint64_t v; memcpy(&v,p,sizeof(v)); return v; }
+
+  inline uint32_t xxhRead32(const uint8_t *p)
+  { uint32_t v; memcpy(&v,p,sizeof(v)); return v; }
+
+  inline uint64_t xxhRound(uint64_t acc, uint64_t input)
+  {
+    acc += input * XXH_P2;
+    acc  = xxhRotl(acc,31);
+    return acc * XXH_P1;
+  }
+
+  inline uint64_t xxhMergeRound(uint64_t acc, uint64_t val)
+  {
+    acc ^= xxhRound(0,val);
+    return acc * XXH_P1 + XXH_P4;
+  }
+
+  void XXHash64::reset(uint64_t seed)
+  {
+    this->seed = seed;
+    acc[0] = seed + XXH_P1 + XXH_P2;
+    acc[1] = seed + XXH_P2;
+    acc[2] = seed;
+    acc[3] = seed - XXH_P1;
+    totalBytes = 0;
+    numPending = 0;
+  }
+
+  void XXHash64::update(const void *data, size_t numBytes)
+  {
+    const uint8_t *p   = (const uint8_t *)data;
+    const uint8_t *end = p+numBytes;
+    totalBytes += numBytes;
+
+    if (numPending+numBytes < 32) {
+      memcpy(pending+numPending,p,numBytes);
+      numPending += numBytes;
+      return;
+    }
+    if (numPending) {
+      const size_t fill = 32-numPending;
+      memcpy(pending+numPending,p,fill);
+      p += fill;
+      for (int i=0;i<4;i++)
+        acc[i] = xxhRound(acc[i],xxhRead64(pending+8*i));
+      numPending = 0;
+    }
+    // (the four lanes in locals, so they can stay in registers)
+    uint64_t v0 = acc[0], v1 = acc[1], v2 = acc[2], v3 = acc[3];
+    for (;p+32 <= end;p+=32) {
+      v0 = xxhRound(v0,xxhRead64(p));
+      v1 = xxhRound(v1,xxhRead64(p+8));
+      v2 = xxhRound(v2,xxhRead64(p+16));
+      v3 = xxhRound(v3,xxhRead64(p+24));
+    }
+    acc[0] = v0; acc[1] = v1; acc[2] = v2; acc[3] = v3;
+    numPending = end-p;
+    memcpy(pending,p,numPending);
+  }
+
+  uint64_t XXHash64::digest() const
+  {
+    uint64_t h;
+    if (totalBytes >= 32) {
+      h = xxhRotl(acc[0],1) + xxhRotl(acc[1],7)
+        + xxhRotl(acc[2],12) + xxhRotl(acc[3],18);
+      for (int i=0;i<4;i++)
+        h = xxhMergeRound(h,acc[i]);
+    } else
+      h = seed + XXH_P5;
+    h += totalBytes;
+
+    const uint8_t *p   = pending;
+    const uint8_t *end = pending+numPending;
+    for (;p+8 <= end;p+=8) {
+      h ^= xxhRound(0,xxhRead64(p));
+      h  = xxhRotl(h,27) * XXH_P1 + XXH_P4;
+    }
+    if (p+4 <= end) {
+      h ^= uint64_t(xxhRead32(p)) * XXH_P1;
+      h  = xxhRotl(h,23) * XXH_P2 + XXH_P3;
+      p += 4;
+    }
+    for (;p<end;p++) {
+      h ^= (*p) * XXH_P5;
+      h  = xxhRotl(h,11) * XXH_P1;
+    }
+    h ^= h >> 33;
+    h *= XXH_P2;
+    h ^= h >> 29;
+    h *= XXH_P3;
+    h ^= h >> 32;
+    return h;
+  }
+
+  uint64_t XXHash64::hash(const void *data, size_t numBytes, uint64_t seed)
+  {
+    XXHash64 hash(seed);
+    hash.update(data,numBytes);
+    return hash.digest();
+  }
+
+  std::string ChecksumRecord::describe() const
+  {
+    switch (kind) {
+    case RECORD_HEADER:
+      return "file header";
+    case RECORD_TEXTURE:
+      return "texture #"+std::to_string(index);
+    case RECORD_LIGHTS:
+      return "lights";
+    case RECORD_MATERIALS:
+      return "materials";
+    case RECORD_MESH:
+      return "mesh #"+std::to_string(index)+" of object #"+std::to_string(object);
+    case RECORD_INSTANCES:
+      return "instances";
+    default:
+      return "unknown record";
+    }
+  }
+
+  namespace io {
+
+    // ------------------------------------------------------------------
+    // writing
+    // ------------------------------------------------------------------
+
+    ChecksumWriteBuffer::ChecksumWriteBuffer(std::ostream &out, size_t bufferSize)
+      : out(out), buffer(bufferSize)
+    { setp(buffer.data(),buffer.data()+buffer.size()); }
+
+    void ChecksumWriteBuffer::flushBuffer()
+    {
+      const size_t numBytes = pptr()-pbase();
+      if (inRecord)
+        hash.update(pbase(),numBytes);
+      out.write(pbase(),numBytes);
+      offset += numBytes;
+      setp(buffer.data(),buffer.data()+buffer.size());
+    }
+
+    ChecksumWriteBuffer::int_type ChecksumWriteBuffer::overflow(int_type c)
+    {
+      flushBuffer();
+      if (!traits_type::eq_int_type(c,traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+      }
+      return traits_type::not_eof(c);
+    }
+
+    int ChecksumWriteBuffer::sync()
+    {
+      flushBuffer();
+      out.flush();
+      return out.good() ? 0 : -1;
+    }
+
+    void ChecksumWriteBuffer::endRecord()
+    {
+      if (!inRecord) return;
+      flushBuffer();
+      ChecksumRecord &record = records.back();
+      record.size = offset-record.offset;
+      record.hash = hash.digest();
+      // the hash itself doesn't belong to any record
+      inRecord = false;
+      writeElement(out,record.hash);
+      offset += sizeof(record.hash);
+    }
+
+    void ChecksumWriteBuffer::beginRecord(RecordKind kind, int object, int index)
+    {
+      endRecord();
+      flushBuffer();
+      ChecksumRecord record;
+      record.offset  = offset;
+      record.size    = 0;
+      record.hash    = 0;
+      record.kind    = kind;
+      record.object  = object;
+      record.index   = index;
+      record.padding = 0;
+      records.push_back(record);
+      hash.reset();
+      inRecord = true;
+    }
+
+    // ------------------------------------------------------------------
+    // reading
+    // ------------------------------------------------------------------
+
+    ChecksumReadBuffer::ChecksumReadBuffer(std::istream &in, size_t bufferSize)
+      : in(in), buffer(bufferSize)
+    {
+      setg(buffer.data(),buffer.data(),buffer.data());
+      hashedUpTo = buffer.data();
+      current.kind   = RECORD_HEADER;
+      current.object = -1;
+      current.index  = -1;
+    }
+
+    void ChecksumReadBuffer::hashConsumed()
+    {
+      if (inRecord && verify)
+        hash.update(hashedUpTo,gptr()-hashedUpTo);
+      hashedUpTo = gptr();
+    }
+
+    ChecksumReadBuffer::int_type ChecksumReadBuffer::underflow()
+    {
+      if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+      hashConsumed();
+      in.read(buffer.data(),buffer.size());
+      const size_t numRead = (size_t)in.gcount();
+      setg(buffer.data(),buffer.data(),buffer.data()+numRead);
+      hashedUpTo = buffer.data();
+      return numRead
+        ? traits_type::to_int_type(*gptr())
+        : traits_type::eof();
+    }
+
+    void ChecksumReadBuffer::endRecord()
+    {
+      if (!inRecord) return;
+      hashConsumed();
+      inRecord = false;
+      // read the stored hash through ourselves (it may already be in
+      // the buffer), but without hashing it
+      uint64_t stored;
+      if (sgetn((char*)&stored,sizeof(stored)) != sizeof(stored))
+        throw std::runtime_error("partial read");
+      hashedUpTo = gptr();
+      if (verify && stored != hash.digest())
+        throw std::runtime_error("checksum mismatch in "+current.describe());
+    }
+
+    void ChecksumReadBuffer::beginRecord(RecordKind kind, int object, int index)
+    {
+      endRecord();
+      hashConsumed();
+      current.kind   = kind;
+      current.object = object;
+      current.index  = index;
+      hash.reset();
+      inRecord = true;
+    }
+
+  } // ::mini::io
+} // ::mini
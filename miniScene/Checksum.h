@@ -0,0 +1,163 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/common.h"
+#include <streambuf>
+
+namespace mini {
+
+  /*! incremental XXH64 hash (same results as the reference xxHash
+      implementation); fast enough that hashing data as it gets read
+      or written costs far less than the I/O itself */
+  struct XXHash64 {
+    XXHash64(uint64_t seed=0) { reset(seed); }
+
+    void reset(uint64_t seed=0);
+    void update(const void *data, size_t numBytes);
+    uint64_t digest() const;
+
+    /*! hash of the given data, in one go */
+    static uint64_t hash(const void *data, size_t numBytes, uint64_t seed=0);
+
+  private:
+    uint64_t acc[4];
+    uint64_t seed;
+    uint64_t totalBytes;
+    /*! bytes that didn't fill a whole 32-byte stripe yet */
+    uint8_t  pending[32];
+    size_t   numPending;
+  };
+
+  /*! the parts of a .mini file that get checksummed separately (see
+      SaveOptions::checksums) */
+  typedef enum : int32_t {
+    /*! the texture count, preceded by the stripe count and token
+        of a striped scene's manifest (records start right after the
+        file's magic and features, so readers know whether there are
+        any before they start reading them). A stripe file has two of
+        these: its token, ID, and texture count, and (after its
+        textures) its mesh count */
+    RECORD_HEADER=0,
+    /*! one texture ('index' is its ID) */
+    RECORD_TEXTURE,
+    /*! all lights */
+    RECORD_LIGHTS,
+    /*! all materials, and the object count */
+    RECORD_MATERIALS,
+    /*! one mesh ('object' and 'index' are the IDs of its object
+        and of the mesh within that); the first mesh's record also
+        includes the object's mesh count (so objects without meshes
+        still have a record for mesh #0, with just that count) */
+    RECORD_MESH,
+    /*! all instances */
+    RECORD_INSTANCES
+  } RecordKind;
+
+  /*! one checksummed part of a .mini file */
+  struct ChecksumRecord {
+    /*! where the record starts, and how many bytes it has; for a
+        block-compressed file, relative to the inner (uncompressed)
+        file */
+    uint64_t offset;
+    uint64_t size;
+    uint64_t hash;
+    int32_t  kind;
+    int32_t  object;
+    int32_t  index;
+    int32_t  padding;
+
+    /*! e.g., "mesh #3 of object #12" */
+    std::string describe() const;
+  };
+
+  namespace io {
+
+    /*! a std::streambuf that passes everything written to it on to
+        another stream, and checksums it, record by record: every
+        call to beginRecord() ends the current record, writes its
+        hash (which is not part of any record), and starts a new
+        record. */
+    struct ChecksumWriteBuffer : public std::streambuf {
+      ChecksumWriteBuffer(std::ostream &out, size_t bufferSize=(1<<20));
+
+      /*! ends the current record (if any), writes its hash, and
+          starts a new one */
+      void beginRecord(RecordKind kind, int object=-1, int index=-1);
+      /*! ends the current record, and writes its hash */
+      void endRecord();
+
+      /*! number of bytes written so far */
+      uint64_t tell() const { return offset+(pptr()-pbase()); }
+
+      /*! all records written so far */
+      std::vector<ChecksumRecord> records;
+
+    protected:
+      int_type overflow(int_type c) override;
+      int sync() override;
+      /*! hashes and passes on all buffered bytes */
+      void flushBuffer();
+
+      std::ostream      &out;
+      std::vector<char>  buffer;
+      XXHash64           hash;
+      bool               inRecord = false;
+      /*! number of bytes written to 'out' so far */
+      uint64_t           offset = 0;
+    };
+
+    /*! the counterpart to ChecksumWriteBuffer: reads from another
+        stream, and checksums all data read, record by record; every
+        call to beginRecord() ends the current record, reads its
+        stored hash, and (if verifying) throws if the two don't
+        match */
+    struct ChecksumReadBuffer : public std::streambuf {
+      ChecksumReadBuffer(std::istream &in, size_t bufferSize=(1<<20));
+
+      /*! if not set, records' stored hashes get read, but not
+          checked (and nothing gets hashed) */
+      void setVerify(bool verify) { this->verify = verify; }
+
+      /*! ends the current record (if any), and starts a new one */
+      void beginRecord(RecordKind kind, int object=-1, int index=-1);
+      /*! ends the current record */
+      void endRecord();
+
+      /*! the record currently being read */
+      const ChecksumRecord &currentRecord() const { return current; }
+      /*! whether we're inside a record (ie, between beginRecord() and
+          endRecord()) */
+      bool isInRecord() const { return inRecord; }
+
+    protected:
+      int_type underflow() override;
+      /*! hashes everything that was read since the last call */
+      void hashConsumed();
+
+      std::istream      &in;
+      std::vector<char>  buffer;
+      XXHash64           hash;
+      bool               verify = true;
+      bool               inRecord = false;
+      ChecksumRecord     current;
+      /*! the first byte in the buffer that wasn't hashed yet */
+      char              *hashedUpTo = nullptr;
+    };
+
+  } // ::mini::io
+} // ::mini
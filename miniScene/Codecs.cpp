@@ -0,0 +1,631 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Codecs.h"
+#include <memory>
+
+namespace mini {
+  namespace codecs {
+
+    CompressedIndices CompressedIndices::encode(const vec3i *indices,
+                                                size_t numTriangles)
+    {
+      const size_t numBlocks
+        = divRoundUp(numTriangles,(size_t)TRIANGLES_PER_BLOCK);
+
+      // each block's high-water mark is one more than the largest
+      // index in all blocks before it
+      std::vector<uint32_t> blockMax(numBlocks);
+      parallel_for
+        (numBlocks,
+         [&](size_t blockID) {
+           const size_t begin = blockID*TRIANGLES_PER_BLOCK;
+           const size_t end   = std::min(begin+TRIANGLES_PER_BLOCK,numTriangles);
+           int maxIndex = -1;
+           for (size_t i=begin;i<end;i++) {
+             if (indices[i].x < 0 || indices[i].y < 0 || indices[i].z < 0)
+               throw std::runtime_error("CompressedIndices: negative vertex index");
+             maxIndex = std::max(maxIndex,indices[i].x);
+             maxIndex = std::max(maxIndex,indices[i].y);
+             maxIndex = std::max(maxIndex,indices[i].z);
+           }
+           blockMax[blockID] = uint32_t(maxIndex+1);
+         });
+
+      CompressedIndices result;
+      result.numTriangles = numTriangles;
+      result.blockBases.resize(numBlocks);
+      uint32_t highWater = 0;
+      for (size_t blockID=0;blockID<numBlocks;blockID++) {
+        result.blockBases[blockID] = highWater;
+        highWater = std::max(highWater,blockMax[blockID]);
+      }
+
+      std::vector<std::vector<uint8_t>> blockBytes(numBlocks);
+      parallel_for
+        (numBlocks,
+         [&](size_t blockID) {
+           const size_t begin = blockID*TRIANGLES_PER_BLOCK;
+           const size_t end   = std::min(begin+TRIANGLES_PER_BLOCK,numTriangles);
+           std::vector<uint8_t> &out = blockBytes[blockID];
+           out.reserve(3*(end-begin)+16);
+           int32_t highWater = (int32_t)result.blockBases[blockID];
+           for (size_t i=begin;i<end;i++)
+             for (int j=0;j<3;j++) {
+               const int32_t index = (&indices[i].x)[j];
+               writeVarint(out,zigzagEncode(highWater-index));
+               highWater = std::max(highWater,index+1);
+             }
+         });
+
+      result.blockOffsets.resize(numBlocks+1);
+      std::vector<uint64_t> blockSizes(numBlocks);
+      for (size_t blockID=0;blockID<numBlocks;blockID++)
+        blockSizes[blockID] = blockBytes[blockID].size();
+      result.blockOffsets[numBlocks]
+        = parallel_exclusive_scan(blockSizes.data(),result.blockOffsets.data(),
+                                  numBlocks,(uint64_t)0);
+
+      result.bytes.resize(result.blockOffsets[numBlocks]);
+      parallel_for
+        (numBlocks,
+         [&](size_t blockID) {
+           std::copy(blockBytes[blockID].begin(),blockBytes[blockID].end(),
+                     result.bytes.begin()+result.blockOffsets[blockID]);
+         });
+      return result;
+    }
+
+    void CompressedIndices::decode(vec3i *indices) const
+    {
+      const size_t numBlocks
+        = divRoundUp(numTriangles,(size_t)TRIANGLES_PER_BLOCK);
+      if (blockBases.size() != numBlocks ||
+          blockOffsets.size() != numBlocks+1 ||
+          blockOffsets[numBlocks] != bytes.size())
+        throw std::runtime_error("CompressedIndices: inconsistent block tables");
+
+      parallel_for
+        (numBlocks,
+         [&](size_t blockID) {
+           const size_t begin = blockID*TRIANGLES_PER_BLOCK;
+           const size_t end   = std::min(begin+TRIANGLES_PER_BLOCK,numTriangles);
+           if (blockOffsets[blockID] > blockOffsets[blockID+1])
+             throw std::runtime_error("CompressedIndices: inconsistent block tables");
+           const uint8_t *in     = bytes.data()+blockOffsets[blockID];
+           const uint8_t *in_end = bytes.data()+blockOffsets[blockID+1];
+           // a varint is at most 5 bytes, so as long as there are at
+           // least 15 bytes left we can decode a triangle without
+           // checking each byte
+           const uint8_t *in_safe_end = in_end-std::min<size_t>(15,in_end-in);
+           int32_t highWater = (int32_t)blockBases[blockID];
+           for (size_t i=begin;i<end;i++) {
+             if (in >= in_safe_end) {
+               // near the end of the block: make sure all three
+               // varints end before it does
+               int numComplete = 0;
+               for (const uint8_t *p=in;p<in_end && numComplete<3;p++)
+                 if (*p < 0x80) numComplete++;
+               if (numComplete < 3)
+                 throw std::runtime_error("CompressedIndices: truncated data");
+             }
+             int32_t tri[3];
+             for (int j=0;j<3;j++) {
+               tri[j] = highWater-zigzagDecode(readVarint(in));
+               highWater = std::max(highWater,tri[j]+1);
+             }
+             indices[i] = vec3i(tri[0],tri[1],tri[2]);
+           }
+           if (in != in_end)
+             throw std::runtime_error("CompressedIndices: corrupt data");
+         });
+    }
+
+    // ------------------------------------------------------------------
+    // entropy coding
+    // ------------------------------------------------------------------
+
+    /*! how entropyEncode() stored a stream */
+    typedef enum : uint8_t {
+      STREAM_RAW=0,
+      /*! all bytes the same; stored as that one byte */
+      STREAM_CONSTANT,
+      /*! a 256-bit mask of which symbols occur, their 16-bit
+          frequencies, a 32-bit payload size, and the rANS payload */
+      STREAM_RANS
+    } StreamMode;
+
+    enum { RANS_SCALE_BITS = 12, RANS_SCALE = (1<<RANS_SCALE_BITS) };
+    /*! lower bound of the rANS state. Renormalization is in 16-bit
+        words, so every symbol needs at most one of them */
+    static const uint32_t RANS_L = (1u<<16);
+    /*! number of interleaved rANS states */
+    enum { RANS_STATES = 4 };
+
+    /*! everything the rANS decoder needs to know about a slot */
+    struct RansSlot {
+      uint16_t freq;
+      /*! the slot's offset relative to its symbol's first slot */
+      uint16_t bias;
+      uint8_t  symbol;
+    };
+
+    /*! decodes one symbol, renormalizing from 'in' if required.
+        Always reads the next word, even if it doesn't consume it */
+    inline uint8_t ransDecode(uint32_t &state, const RansSlot *slots,
+                              const uint8_t *&in)
+    {
+      const RansSlot slot = slots[state & (RANS_SCALE-1)];
+      state = slot.freq * (state >> RANS_SCALE_BITS) + slot.bias;
+      uint16_t word;
+      memcpy(&word,in,sizeof(word));
+      const bool renorm = state < RANS_L;
+      state = renorm ? ((state << 16) | word) : state;
+      in += renorm ? sizeof(word) : 0;
+      return slot.symbol;
+    }
+
+    template<typename T>
+    inline void appendRaw(std::vector<uint8_t> &out, const T &t)
+    {
+      const uint8_t *bytes = (const uint8_t *)&t;
+      out.insert(out.end(),bytes,bytes+sizeof(T));
+    }
+
+    template<typename T>
+    inline T readRaw(const uint8_t *&in, const uint8_t *in_end)
+    {
+      if (in_end-in < (ptrdiff_t)sizeof(T))
+        throw std::runtime_error("entropyDecode: truncated data");
+      T t;
+      memcpy(&t,in,sizeof(T));
+      in += sizeof(T);
+      return t;
+    }
+
+    /*! scales the (non-zero) symbol counts of a stream to frequencies
+        that sum up to exactly RANS_SCALE, keeping every symbol that
+        occurs at a frequency of at least 1 */
+    void normalizeFrequencies(const size_t counts[256], size_t numBytes,
+                              uint32_t freqs[256])
+    {
+      int64_t sum = 0;
+      int largest = 0;
+      for (int s=0;s<256;s++) {
+        freqs[s] = counts[s]
+          ? std::max<uint32_t>(1,uint32_t(counts[s]*RANS_SCALE/numBytes))
+          : 0;
+        sum += freqs[s];
+        if (freqs[s] > freqs[largest]) largest = s;
+      }
+      if (sum < RANS_SCALE) {
+        freqs[largest] += uint32_t(RANS_SCALE-sum);
+        return;
+      }
+      // rounding up rare symbols to 1 may have overshot: take the
+      // excess from the most frequent symbols
+      while (sum > RANS_SCALE) {
+        largest = 0;
+        for (int s=1;s<256;s++)
+          if (freqs[s] > freqs[largest]) largest = s;
+        const uint32_t take
+          = (uint32_t)std::min<int64_t>(sum-RANS_SCALE,(freqs[largest]+1)/2);
+        freqs[largest] -= take;
+        sum -= take;
+      }
+    }
+
+    void entropyEncode(std::vector<uint8_t> &out,
+                       const uint8_t *in, size_t numBytes)
+    {
+      size_t counts[256] = { 0 };
+      for (size_t i=0;i<numBytes;i++)
+        counts[in[i]]++;
+
+      int numSymbols = 0;
+      for (int s=0;s<256;s++)
+        if (counts[s]) numSymbols++;
+      if (numBytes > 0 && numSymbols == 1) {
+        out.push_back(STREAM_CONSTANT);
+        out.push_back(in[0]);
+        return;
+      }
+      
+      // (the payload size gets stored as 32 bits)
+      const size_t header = 1+32+2*numSymbols+sizeof(uint32_t);
+      if (numBytes <= header || numBytes > (1ull<<30)) {
+        out.push_back(STREAM_RAW);
+        out.insert(out.end(),in,in+numBytes);
+        return;
+      }
+
+      uint32_t freqs[256], cum[257];
+      normalizeFrequencies(counts,numBytes,freqs);
+      cum[0] = 0;
+      for (int s=0;s<256;s++)
+        cum[s+1] = cum[s]+freqs[s];
+
+      // rANS encodes in reverse, so the decoder can run forward.
+      // Consecutive bytes use RANS_STATES different states, which
+      // share one output stream; that way the decoder has that many
+      // independent dependency chains. No symbol takes more than
+      // RANS_SCALE_BITS bits.
+      std::vector<uint16_t> payload(numBytes*RANS_SCALE_BITS/16+2*RANS_STATES+8);
+      uint16_t *ptr = payload.data()+payload.size();
+      uint32_t x[RANS_STATES];
+      for (int k=0;k<RANS_STATES;k++)
+        x[k] = RANS_L;
+      for (size_t i=numBytes;i>0;--i) {
+        const uint8_t s = in[i-1];
+        uint32_t &state = x[(i-1)%RANS_STATES];
+        const uint32_t x_max = ((RANS_L >> RANS_SCALE_BITS) << 16) * freqs[s];
+        if (state >= x_max) {
+          *--ptr = uint16_t(state);
+          state >>= 16;
+        }
+        state = ((state / freqs[s]) << RANS_SCALE_BITS) + (state % freqs[s]) + cum[s];
+      }
+      // (the final states, as pairs of 16-bit words)
+      ptr -= 2*RANS_STATES;
+      memcpy(ptr,x,sizeof(x));
+      const size_t payloadSize
+        = (payload.data()+payload.size()-ptr)*sizeof(uint16_t);
+
+      if (header+payloadSize >= numBytes) {
+        out.push_back(STREAM_RAW);
+        out.insert(out.end(),in,in+numBytes);
+        return;
+      }
+      out.push_back(STREAM_RANS);
+      uint8_t mask[32] = { 0 };
+      for (int s=0;s<256;s++)
+        if (freqs[s]) mask[s/8] |= (1<<(s%8));
+      out.insert(out.end(),mask,mask+32);
+      for (int s=0;s<256;s++)
+        if (freqs[s]) appendRaw(out,uint16_t(freqs[s]));
+      appendRaw(out,uint32_t(payloadSize));
+      out.insert(out.end(),(const uint8_t *)ptr,(const uint8_t *)ptr+payloadSize);
+    }
+
+    const uint8_t *entropyDecode(uint8_t *out, size_t numBytes,
+                                 const uint8_t *in, const uint8_t *in_end)
+    {
+      const uint8_t mode = readRaw<uint8_t>(in,in_end);
+      if (mode == STREAM_RAW) {
+        if ((size_t)(in_end-in) < numBytes)
+          throw std::runtime_error("entropyDecode: truncated data");
+        std::copy(in,in+numBytes,out);
+        return in+numBytes;
+      }
+      if (mode == STREAM_CONSTANT) {
+        std::fill(out,out+numBytes,readRaw<uint8_t>(in,in_end));
+        return in;
+      }
+      if (mode != STREAM_RANS)
+        throw std::runtime_error("entropyDecode: invalid stream mode");
+
+      uint8_t mask[32];
+      for (int i=0;i<32;i++)
+        mask[i] = readRaw<uint8_t>(in,in_end);
+      RansSlot slots[RANS_SCALE];
+      uint32_t cum = 0;
+      for (int s=0;s<256;s++) {
+        if (!(mask[s/8] & (1<<(s%8)))) continue;
+        const uint32_t freq = readRaw<uint16_t>(in,in_end);
+        if (cum+freq > RANS_SCALE)
+          throw std::runtime_error("entropyDecode: invalid symbol frequencies");
+        for (uint32_t j=0;j<freq;j++)
+          slots[cum+j] = { uint16_t(freq), uint16_t(j), uint8_t(s) };
+        cum += freq;
+      }
+      if (cum != RANS_SCALE)
+        throw std::runtime_error("entropyDecode: invalid symbol frequencies");
+
+      const uint32_t payloadSize = readRaw<uint32_t>(in,in_end);
+      if ((size_t)(in_end-in) < payloadSize || (payloadSize % sizeof(uint16_t)))
+        throw std::runtime_error("entropyDecode: truncated data");
+      in_end = in+payloadSize;
+      uint32_t x[RANS_STATES];
+      for (int k=0;k<RANS_STATES;k++)
+        x[k] = readRaw<uint32_t>(in,in_end);
+
+      // (everything the loops use is in locals, since the compiler
+      // would otherwise have to assume that writing a byte to 'out'
+      // may change it)
+      const RansSlot *slotTable = slots;
+      const uint8_t *ptr = in;
+      size_t i = 0;
+      while (i < numBytes) {
+        // no symbol consumes more than one word, so as long as
+        // there's enough data left, we can decode without checking
+        const size_t numSafe
+          = std::min(numBytes-i,size_t(in_end-ptr)/sizeof(uint16_t));
+        if (numSafe == 0) {
+          // out of data: fine only as long as the remaining symbols
+          // don't need any more of it
+          uint32_t &state = x[i%RANS_STATES];
+          const RansSlot slot = slotTable[state & (RANS_SCALE-1)];
+          state = slot.freq * (state >> RANS_SCALE_BITS) + slot.bias;
+          if (state < RANS_L)
+            throw std::runtime_error("entropyDecode: truncated data");
+          out[i++] = slot.symbol;
+          continue;
+        }
+        const size_t end = i+numSafe;
+        for (;i<end && (i%RANS_STATES);i++)
+          out[i] = ransDecode(x[i%RANS_STATES],slotTable,ptr);
+        for (;i+RANS_STATES<=end;i+=RANS_STATES)
+          for (int k=0;k<RANS_STATES;k++)
+            out[i+k] = ransDecode(x[k],slotTable,ptr);
+        for (;i<end;i++)
+          out[i] = ransDecode(x[i%RANS_STATES],slotTable,ptr);
+      }
+      if (ptr != in_end)
+        throw std::runtime_error("entropyDecode: corrupt data");
+      return in_end;
+    }
+
+    // ------------------------------------------------------------------
+    // LZ
+    // ------------------------------------------------------------------
+
+    enum { LZ_MIN_MATCH = 4, LZ_HASH_BITS = 16, LZ_MAX_OFFSET = 0xffff };
+
+    inline uint32_t lzLoad32(const uint8_t *p)
+    {
+      uint32_t v;
+      memcpy(&v,p,sizeof(v));
+      return v;
+    }
+
+    inline uint32_t lzHash(uint32_t v)
+    { return (v * 2654435761u) >> (32-LZ_HASH_BITS); }
+
+    /*! writes the part of a length that didn't fit into the token's
+        4 bits, as a sequence of bytes that add up to it */
+    inline void lzWriteLength(std::vector<uint8_t> &out, size_t length)
+    {
+      for (;length >= 255;length -= 255)
+        out.push_back(255);
+      out.push_back(uint8_t(length));
+    }
+
+    inline size_t lzReadLength(const uint8_t *&in, const uint8_t *in_end)
+    {
+      size_t length = 0;
+      while (true) {
+        const uint8_t byte = readRaw<uint8_t>(in,in_end);
+        length += byte;
+        if (byte != 255) return length;
+      }
+    }
+
+    /*! writes a sequence of 'numLiterals' literals, followed by a
+        match of given length and offset (unless matchLength is 0,
+        which marks the last sequence) */
+    void lzWriteSequence(std::vector<uint8_t> &out,
+                         const uint8_t *literals, size_t numLiterals,
+                         size_t matchOffset, size_t matchLength)
+    {
+      const size_t matchCode = matchLength ? matchLength-LZ_MIN_MATCH : 0;
+      out.push_back(uint8_t((std::min<size_t>(numLiterals,15) << 4)
+                            | std::min<size_t>(matchCode,15)));
+      if (numLiterals >= 15)
+        lzWriteLength(out,numLiterals-15);
+      out.insert(out.end(),literals,literals+numLiterals);
+      if (!matchLength) return;
+      out.push_back(uint8_t(matchOffset));
+      out.push_back(uint8_t(matchOffset >> 8));
+      if (matchCode >= 15)
+        lzWriteLength(out,matchCode-15);
+    }
+
+    void lzCompress(std::vector<uint8_t> &out,
+                    const uint8_t *in, size_t numBytes)
+    {
+      // most recent position (plus one, so 0 means 'none') of each
+      // hashed 4-byte sequence
+      std::vector<uint32_t> table(1<<LZ_HASH_BITS,0);
+      size_t anchor = 0;
+      size_t i = 0;
+      while (i+LZ_MIN_MATCH <= numBytes) {
+        const uint32_t v = lzLoad32(in+i);
+        uint32_t &entry = table[lzHash(v)];
+        const size_t candidate = entry;
+        entry = uint32_t(i+1);
+        if (candidate && i-(candidate-1) <= LZ_MAX_OFFSET
+            && lzLoad32(in+candidate-1) == v) {
+          const size_t ref = candidate-1;
+          size_t length = LZ_MIN_MATCH;
+          while (i+length < numBytes && in[ref+length] == in[i+length])
+            length++;
+          lzWriteSequence(out,in+anchor,i-anchor,i-ref,length);
+          i += length;
+          anchor = i;
+        } else
+          // the longer we don't find anything, the faster we skip
+          // ahead (incompressible data is common enough)
+          i += 1+((i-anchor) >> 6);
+      }
+      lzWriteSequence(out,in+anchor,numBytes-anchor,0,0);
+    }
+
+    void lzDecompress(uint8_t *out, size_t numBytes,
+                      const uint8_t *in, const uint8_t *in_end)
+    {
+      size_t pos = 0;
+      while (true) {
+        const uint8_t token = readRaw<uint8_t>(in,in_end);
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15)
+          numLiterals += lzReadLength(in,in_end);
+        if (numLiterals > size_t(in_end-in) || numLiterals > numBytes-pos)
+          throw std::runtime_error("lzDecompress: corrupt data");
+        memcpy(out+pos,in,numLiterals);
+        in  += numLiterals;
+        pos += numLiterals;
+        if (in == in_end)
+          // last sequence has no match
+          break;
+
+        size_t offset = readRaw<uint8_t>(in,in_end);
+        offset |= size_t(readRaw<uint8_t>(in,in_end)) << 8;
+        size_t length = token & 15;
+        if (length == 15)
+          length += lzReadLength(in,in_end);
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > pos || length > numBytes-pos)
+          throw std::runtime_error("lzDecompress: corrupt data");
+        const uint8_t *ref = out+pos-offset;
+        if (offset >= length)
+          memcpy(out+pos,ref,length);
+        else
+          // overlapping: repeats the last 'offset' bytes
+          for (size_t j=0;j<length;j++)
+            out[pos+j] = ref[j];
+        pos += length;
+      }
+      if (pos != numBytes)
+        throw std::runtime_error("lzDecompress: corrupt data");
+    }
+
+    // ------------------------------------------------------------------
+    // floats
+    // ------------------------------------------------------------------
+
+    /*! how the floats of one CompressedFloats chunk were predicted */
+    typedef enum : uint8_t {
+      PREDICT_NONE=0,
+      /*! by the same component of the previous element */
+      PREDICT_PREVIOUS
+    } FloatPredictor;
+
+    /*! encodes one chunk of floats with given predictor */
+    void encodeFloatChunk(std::vector<uint8_t> &out,
+                          const uint32_t *bits, size_t numValues,
+                          int numComponents, FloatPredictor predictor)
+    {
+      std::vector<uint8_t> planes(4*numValues);
+      for (size_t i=0;i<numValues;i++) {
+        uint32_t v = bits[i];
+        if (predictor == PREDICT_PREVIOUS && i >= (size_t)numComponents)
+          v = zigzagEncode(int32_t(v-bits[i-numComponents]));
+        for (int p=0;p<4;p++)
+          planes[p*numValues+i] = uint8_t(v >> (8*p));
+      }
+      out.push_back(predictor);
+      for (int p=0;p<4;p++)
+        entropyEncode(out,planes.data()+p*numValues,numValues);
+    }
+
+    CompressedFloats CompressedFloats::encode(const float *values,
+                                              size_t numElements,
+                                              int numComponents)
+    {
+      assert(numComponents > 0);
+      const size_t numChunks
+        = divRoundUp(numElements,(size_t)ELEMENTS_PER_CHUNK);
+      const uint32_t *bits = (const uint32_t *)values;
+
+      std::vector<std::vector<uint8_t>> chunkBytes(numChunks);
+      parallel_for
+        (numChunks,
+         [&](size_t chunkID) {
+           const size_t begin = chunkID*ELEMENTS_PER_CHUNK;
+           const size_t end   = std::min(begin+ELEMENTS_PER_CHUNK,numElements);
+           const uint32_t *chunk = bits+begin*numComponents;
+           const size_t numValues = (end-begin)*numComponents;
+           // whether neighboring elements are similar enough to be
+           // worth predicting depends on the data, so try both
+           std::vector<uint8_t> plain, predicted;
+           encodeFloatChunk(plain,chunk,numValues,numComponents,PREDICT_NONE);
+           encodeFloatChunk(predicted,chunk,numValues,numComponents,PREDICT_PREVIOUS);
+           chunkBytes[chunkID]
+             = std::move(predicted.size() < plain.size() ? predicted : plain);
+         });
+
+      CompressedFloats result;
+      result.numComponents = numComponents;
+      result.numElements   = numElements;
+      result.chunkOffsets.resize(numChunks+1);
+      std::vector<uint64_t> chunkSizes(numChunks);
+      for (size_t chunkID=0;chunkID<numChunks;chunkID++)
+        chunkSizes[chunkID] = chunkBytes[chunkID].size();
+      result.chunkOffsets[numChunks]
+        = parallel_exclusive_scan(chunkSizes.data(),result.chunkOffsets.data(),
+                                  numChunks,(uint64_t)0);
+
+      result.bytes.resize(result.chunkOffsets[numChunks]);
+      parallel_for
+        (numChunks,
+         [&](size_t chunkID) {
+           std::copy(chunkBytes[chunkID].begin(),chunkBytes[chunkID].end(),
+                     result.bytes.begin()+result.chunkOffsets[chunkID]);
+         });
+      return result;
+    }
+
+    void CompressedFloats::decode(float *values) const
+    {
+      const size_t numChunks
+        = divRoundUp(numElements,(size_t)ELEMENTS_PER_CHUNK);
+      if (numComponents <= 0 ||
+          chunkOffsets.size() != numChunks+1 ||
+          chunkOffsets[numChunks] != bytes.size())
+        throw std::runtime_error("CompressedFloats: inconsistent chunk tables");
+      uint32_t *bits = (uint32_t *)values;
+
+      parallel_for
+        (numChunks,
+         [&](size_t chunkID) {
+           const size_t begin = chunkID*ELEMENTS_PER_CHUNK;
+           const size_t end   = std::min(begin+ELEMENTS_PER_CHUNK,numElements);
+           if (chunkOffsets[chunkID] > chunkOffsets[chunkID+1])
+             throw std::runtime_error("CompressedFloats: inconsistent chunk tables");
+           const uint8_t *in     = bytes.data()+chunkOffsets[chunkID];
+           const uint8_t *in_end = bytes.data()+chunkOffsets[chunkID+1];
+           const size_t numValues = (end-begin)*numComponents;
+           uint32_t *chunk = bits+begin*numComponents;
+
+           const uint8_t predictor = readRaw<uint8_t>(in,in_end);
+           if (predictor != PREDICT_NONE && predictor != PREDICT_PREVIOUS)
+             throw std::runtime_error("CompressedFloats: invalid predictor");
+           std::unique_ptr<uint8_t[]> planes(new uint8_t[4*numValues]);
+           for (int p=0;p<4;p++)
+             in = entropyDecode(planes.get()+p*numValues,numValues,in,in_end);
+           if (in != in_end)
+             throw std::runtime_error("CompressedFloats: corrupt data");
+
+           const uint8_t *p0 = planes.get();
+           const uint8_t *p1 = p0+numValues;
+           const uint8_t *p2 = p1+numValues;
+           const uint8_t *p3 = p2+numValues;
+           for (size_t i=0;i<numValues;i++) {
+             const uint32_t v
+               = uint32_t(p0[i])
+               | (uint32_t(p1[i]) << 8)
+               | (uint32_t(p2[i]) << 16)
+               | (uint32_t(p3[i]) << 24);
+             chunk[i]
+               = (predictor == PREDICT_PREVIOUS && i >= (size_t)numComponents)
+               ? chunk[i-numComponents]+uint32_t(zigzagDecode(v))
+               : v;
+           }
+         });
+    }
+
+  } // ::mini::codecs
+} // ::mini
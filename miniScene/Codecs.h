@@ -0,0 +1,166 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/common.h"
+
+/*! lossless codecs for the (large) arrays in .mini files */
+namespace mini {
+  namespace codecs {
+
+    /*! appends 'value' to 'out' as LEB128 varint (7 bits per byte,
+        lowest bits first, high bit set on all but the last byte) */
+    inline void writeVarint(std::vector<uint8_t> &out, uint32_t value)
+    {
+      while (value >= 0x80) {
+        out.push_back(uint8_t(value | 0x80));
+        value >>= 7;
+      }
+      out.push_back(uint8_t(value));
+    }
+
+    /*! reads a varint written by writeVarint(), and advances 'in';
+        reads at most 5 bytes, even for invalid data */
+    inline uint32_t readVarint(const uint8_t *&in)
+    {
+      uint32_t value = *in++;
+      if (value < 0x80) return value;
+      value &= 0x7f;
+      for (int shift=7;shift<35;shift+=7) {
+        const uint32_t byte = *in++;
+        value |= (byte & 0x7f) << shift;
+        if (byte < 0x80) break;
+      }
+      return value;
+    }
+
+    /*! maps signed to unsigned values such that small magnitudes
+        (of either sign) give small values */
+    inline uint32_t zigzagEncode(int32_t v)
+    { return (uint32_t(v) << 1) ^ uint32_t(v >> 31); }
+
+    inline int32_t zigzagDecode(uint32_t u)
+    { return int32_t(u >> 1) ^ -int32_t(u & 1); }
+
+    /*! a lossless encoding of a triangle list's indices. Each index
+        gets stored as a (zigzagged) varint of its distance to the
+        'high-water mark', the largest index seen so far plus
+        one. For meshes whose triangles and vertices are in
+        vertex-cache order (as most exporters and mesh optimizers
+        produce them), new vertices mostly show up in order - which
+        encodes as a single zero byte - and re-used ones are
+        mostly among the last few, which typically gives 1-1.5 bytes
+        per index, instead of 4 (or 2).
+
+        Triangles get encoded in blocks of TRIANGLES_PER_BLOCK, each
+        of which starts with its own high-water mark, so blocks can
+        get encoded and decoded in parallel. */
+    struct CompressedIndices {
+      enum { TRIANGLES_PER_BLOCK = 16*1024 };
+
+      /*! encodes given triangles; indices must not be negative */
+      static CompressedIndices encode(const vec3i *indices, size_t numTriangles);
+
+      /*! decodes all triangles into 'indices', which has to have
+          space for numTriangles of them; blocks get decoded in
+          parallel */
+      void decode(vec3i *indices) const;
+
+      /*! size of the encoded data, in bytes (not counting the few
+          bytes for numTriangles) */
+      size_t sizeInBytes() const
+      {
+        return bytes.size()
+          + blockOffsets.size()*sizeof(blockOffsets[0])
+          + blockBases.size()*sizeof(blockBases[0]);
+      }
+
+      size_t                numTriangles = 0;
+      /*! per block: the high-water mark it starts with */
+      std::vector<uint32_t> blockBases;
+      /*! per block: where its data starts in 'bytes'; plus one
+          final entry with the total size */
+      std::vector<uint64_t> blockOffsets;
+      std::vector<uint8_t>  bytes;
+    };
+
+    /*! order-0 entropy coding (static rANS, with 12-bit symbol
+        frequencies) of a stream of bytes: appends the encoding of
+        the 'numBytes' bytes at 'in' to 'out'. Streams that wouldn't
+        get any smaller get stored as they are, so the encoding is
+        never more than one byte larger than the input */
+    void entropyEncode(std::vector<uint8_t> &out,
+                       const uint8_t *in, size_t numBytes);
+
+    /*! decodes 'numBytes' bytes encoded with entropyEncode() into
+        'out', reading no further than 'in_end'; returns where the
+        encoded data ended. Throws on invalid data */
+    const uint8_t *entropyDecode(uint8_t *out, size_t numBytes,
+                                 const uint8_t *in, const uint8_t *in_end);
+
+    /*! general-purpose LZ77 compression (similar to LZ4's block
+        format: sequences of literals followed by a match of at least
+        four bytes, within the last 64K): appends the compressed
+        'numBytes' bytes at 'in' to 'out'. Fast to decode, but
+        doesn't get anywhere near an entropy coder's ratio on
+        non-repetitive data */
+    void lzCompress(std::vector<uint8_t> &out,
+                    const uint8_t *in, size_t numBytes);
+
+    /*! decompresses exactly the data lzCompress() produced from
+        'numBytes' bytes (i.e., everything up to 'in_end') into
+        'out'. Throws on invalid data */
+    void lzDecompress(uint8_t *out, size_t numBytes,
+                      const uint8_t *in, const uint8_t *in_end);
+
+    /*! a lossless encoding of an array of (vectors of) floats, such
+        as a mesh's vertices or normals. The array gets split into
+        chunks of ELEMENTS_PER_CHUNK elements, which get encoded (and
+        decoded) independently, in parallel. Within a chunk, each
+        float's bit pattern gets (optionally) predicted by the same
+        component of the previous element, the differences get split
+        into four byte planes, and each plane gets entropy-coded. The
+        high planes (sign, exponent, and top mantissa bits) of
+        spatially coherent data are highly redundant, while the
+        lowest ones typically end up stored as they are. */
+    struct CompressedFloats {
+      enum { ELEMENTS_PER_CHUNK = 16*1024 };
+
+      /*! encodes 'numElements' elements of 'numComponents' floats
+          each */
+      static CompressedFloats encode(const float *values,
+                                     size_t numElements,
+                                     int numComponents);
+
+      /*! decodes all values into 'values', which has to have space
+          for numElements*numComponents floats */
+      void decode(float *values) const;
+
+      /*! size of the encoded data, in bytes */
+      size_t sizeInBytes() const
+      { return bytes.size()+chunkOffsets.size()*sizeof(chunkOffsets[0]); }
+
+      int                   numComponents = 1;
+      size_t                numElements   = 0;
+      /*! per chunk: where its data starts in 'bytes'; plus one
+          final entry with the total size */
+      std::vector<uint64_t> chunkOffsets;
+      std::vector<uint8_t>  bytes;
+    };
+
+  } // ::mini::codecs
+} // ::mini
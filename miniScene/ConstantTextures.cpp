@@ -0,0 +1,163 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/ConstantTextures.h"
+#include "miniScene/Serialized.h"
+#include <algorithm>
+#include <atomic>
+
+namespace mini {
+
+  bool isUniformTexture(const Texture &texture, vec4f &value)
+  {
+    size_t texelSize;
+    switch (texture.format) {
+    case Texture::FLOAT4:     texelSize = sizeof(vec4f);    break;
+    case Texture::FLOAT1:     texelSize = sizeof(float);    break;
+    case Texture::RGBA_UINT8: texelSize = sizeof(uint32_t); break;
+    default:
+      return false;
+    }
+    const size_t numTexels = size_t(texture.size.x)*size_t(texture.size.y);
+    if (texture.size.x <= 0 || texture.size.y <= 0
+        || texture.data.size() < numTexels*texelSize)
+      return false;
+
+    const uint8_t *texels = texture.data.data();
+    for (size_t i=1;i<numTexels;i++)
+      if (memcmp(texels+i*texelSize,texels,texelSize))
+        return false;
+
+    switch (texture.format) {
+    case Texture::FLOAT4:
+      memcpy(&value,texels,sizeof(value));
+      break;
+    case Texture::FLOAT1: {
+      float f;
+      memcpy(&f,texels,sizeof(f));
+      value = vec4f(f);
+    } break;
+    default:
+      value = vec4f(texels[0],texels[1],texels[2],texels[3])*(1.f/255.f);
+    }
+    return true;
+  }
+
+  /*! a material texture that can get folded into a parameter of the
+      same material */
+  struct FoldRule {
+    Material::Tag tag;
+    /*! name of the texture field */
+    const char   *texture;
+    /*! name of the (float or vec3f) field the texture's value
+        replaces; null if there's no such field, in which case the
+        texture can only get dropped if it's fully opaque */
+    const char   *parameter;
+    /*! whether the texture is an alpha texture (or else a color
+        texture) */
+    bool          isAlpha;
+  };
+
+  static const FoldRule foldRules[] = {
+    { Material::DISNEY,         "colorTexture",      "baseColor", false },
+    { Material::DISNEY,         "alphaTexture",      nullptr,     true  },
+    { Material::BLENDER,        "baseColorTexture",  "baseColor", false },
+    { Material::BLENDER,        "alphaTexture",      "alpha",     true  },
+    { Material::ANARI_MATERIAL, "baseColor_texture", "baseColor", false },
+    { Material::ANARI_MATERIAL, "opacity_texture",   "opacity",   true  },
+  };
+
+  static const MaterialField *findField(const Material &material, const char *name)
+  {
+    for (auto &field : material.getFields())
+      if (!strcmp(field.name,name))
+        return &field;
+    return nullptr;
+  }
+
+  /*! folds those of the material's textures that are uniform (as
+      given by 'isUniform' and 'values', per texture ID); returns the number of
+      texture references that got folded */
+  static size_t foldMaterial(Material &material,
+                             const Serialized<Texture::SP> &textures,
+                             const std::vector<uint8_t> &isUniform,
+                             const std::vector<vec4f> &values)
+  {
+    size_t numFolded = 0;
+    for (auto &rule : foldRules) {
+      if (rule.tag != material.tag()) continue;
+      const MaterialField *textureField = findField(material,rule.texture);
+      Texture::SP &texture = material.get<Texture::SP>(*textureField);
+      const int textureID = textures.getID(texture);
+      if (!texture || textureID < 0 || !isUniform[textureID]) continue;
+
+      const vec4f value = values[textureID];
+      if (rule.isAlpha) {
+        const float alpha = texture->format == Texture::FLOAT1 ? value.x : value.w;
+        if (rule.parameter)
+          material.get<float>(*findField(material,rule.parameter)) = alpha;
+        else if (alpha != 1.f)
+          continue;
+      } else {
+        if (texture->format == Texture::FLOAT1) continue;
+        material.get<vec3f>(*findField(material,rule.parameter))
+          = vec3f(value.x,value.y,value.z);
+      }
+      texture = nullptr;
+      numFolded++;
+    }
+    return numFolded;
+  }
+  
+  FoldTexturesStats foldConstantTextures(Scene::SP scene,
+                                         const Progress &progress)
+  {
+    SerializedScene serialized(scene.get());
+    const Serialized<Texture::SP>   &textures  = serialized.textures;
+    const std::vector<Material::SP> &materials = serialized.materials.list;
+    
+    std::vector<uint8_t> isUniform(textures.size());
+    std::vector<vec4f>   values(textures.size());
+    parallel_for_blocked
+      (progress,"checking textures",(size_t)0,textures.size(),1,
+       [&](size_t begin, size_t end) {
+         for (size_t texID=begin;texID<end;texID++) {
+           const Texture::SP &texture = textures.list[texID];
+           isUniform[texID] = texture && isUniformTexture(*texture,values[texID]);
+         }
+       });
+
+    std::atomic<size_t> numReferencesFolded { 0 };
+    parallel_for_blocked
+      (progress,"folding textures",(size_t)0,materials.size(),1024,
+       [&](size_t begin, size_t end) {
+         size_t numFolded = 0;
+         for (size_t matID=begin;matID<end;matID++)
+           if (materials[matID])
+             numFolded += foldMaterial(*materials[matID],textures,isUniform,values);
+         numReferencesFolded += numFolded;
+       });
+
+    FoldTexturesStats stats;
+    // (the serialized textures include a null texture as ID 0)
+    stats.numTexturesBefore   = textures.size()-1;
+    stats.numUniformTextures  = std::count(isUniform.begin(),isUniform.end(),1);
+    stats.numReferencesFolded = numReferencesFolded;
+    stats.numTexturesAfter    = SerializedScene(scene.get()).textures.size()-1;
+    return stats;
+  }
+  
+} // ::mini
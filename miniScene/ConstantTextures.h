@@ -0,0 +1,60 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/Scene.h"
+
+namespace mini {
+
+  /*! if all texels of the given texture are the same (which
+      includes all 1x1 textures), returns true, and that texel's
+      value - with RGBA_UINT8 values normalized to [0,1], and the
+      single channel of FLOAT1 textures in all four components.
+      Returns false for non-uniform textures, and for formats whose
+      texels it can't look at (e.g., embedded ptex) */
+  bool isUniformTexture(const Texture &texture, vec4f &value);
+
+  /*! what foldConstantTextures() did */
+  struct FoldTexturesStats {
+    /*! number of distinct textures the scene's materials used
+        before and after */
+    size_t numTexturesBefore   = 0;
+    size_t numTexturesAfter    = 0;
+    /*! number of those that were uniform */
+    size_t numUniformTextures  = 0;
+    /*! number of material texture references that got folded into
+        the material's parameters (or dropped) */
+    size_t numReferencesFolded = 0;
+  };
+
+  /*! replaces the color and alpha textures of DisneyMaterials,
+      BlenderMaterials, and ANARIMaterials whose texels are all the
+      same by the corresponding material parameter (see
+      isUniformTexture()): color textures get folded into the base
+      color, and alpha (or opacity) textures into alpha (or opacity)
+      - or, for DisneyMaterials, which have no such parameter, get
+      dropped if fully opaque. Alpha is the fourth channel of RGBA
+      textures, and the only one of FLOAT1 textures; FLOAT1 color
+      textures are left alone.
+
+      Textures are checked for being uniform, and materials
+      rewritten, in parallel. Textures that no material references
+      any more are released along with their last reference */
+  FoldTexturesStats foldConstantTextures(Scene::SP scene,
+                                         const Progress &progress=Progress());
+
+} // ::mini
@@ -0,0 +1,155 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/common.h"
+#include <atomic>
+#include <memory>
+
+namespace mini {
+
+  /*! a copy-on-write array, used for the (potentially large) arrays
+      in a mesh. Copying a CowVector (eg, when copying a mesh) does
+      not copy the array, but only makes both copies share the same
+      buffer; only once one of the copies gets modified does that
+      one get its own copy of the data ("detach").
+
+      The interface is a subset of std::vector's. Element access
+      (operator[], data(), begin(), end(), ...) is always read-only,
+      and never copies; to write to the elements, first get the
+      array's own buffer via edit() (which is where the copy happens,
+      if the buffer is shared):
+
+        std::vector<vec3f> &vertices = mesh->vertices.edit();
+        for (auto &v : vertices) v = xfmPoint(xfm,v);
+
+      Methods that change the array as a whole (push_back(),
+      resize(), ...) detach implicitly.
+
+      As with std::vector, different threads may read the same
+      CowVector, and may modify _different_ CowVectors (even if they
+      share a buffer), but not modify the same one. */
+  template<typename T>
+  struct CowVector {
+    typedef T value_type;
+    typedef typename std::vector<T>::const_iterator const_iterator;
+    typedef typename std::vector<T>::iterator       iterator;
+
+    CowVector() = default;
+    CowVector(const CowVector &) = default;
+    CowVector(CowVector &&) = default;
+    CowVector(const std::vector<T> &vec)
+      : buffer(std::make_shared<std::vector<T>>(vec))
+    {}
+    CowVector(std::vector<T> &&vec)
+      : buffer(std::make_shared<std::vector<T>>(std::move(vec)))
+    {}
+    CowVector(std::initializer_list<T> init)
+      : buffer(std::make_shared<std::vector<T>>(init))
+    {}
+
+    CowVector &operator=(const CowVector &) = default;
+    CowVector &operator=(CowVector &&) = default;
+    CowVector &operator=(const std::vector<T> &vec)
+    { buffer = std::make_shared<std::vector<T>>(vec); return *this; }
+    CowVector &operator=(std::vector<T> &&vec)
+    { buffer = std::make_shared<std::vector<T>>(std::move(vec)); return *this; }
+
+    // ------------------------------------------------------------------
+    // read-only access; never copies
+    // ------------------------------------------------------------------
+
+    /*! returns the (possibly shared) array */
+    inline const std::vector<T> &get() const
+    { return buffer ? *buffer : empty_vector(); }
+    inline operator const std::vector<T> &() const { return get(); }
+
+    inline size_t   size()  const { return buffer ? buffer->size() : 0; }
+    inline bool     empty() const { return size() == 0; }
+    inline const T *data()  const { return get().data(); }
+    inline const T &operator[](size_t i) const { return (*buffer)[i]; }
+    inline const T &front() const { return buffer->front(); }
+    inline const T &back()  const { return buffer->back(); }
+    inline const_iterator begin()  const { return get().begin(); }
+    inline const_iterator end()    const { return get().end(); }
+    inline const_iterator cbegin() const { return get().begin(); }
+    inline const_iterator cend()   const { return get().end(); }
+
+    /*! whether this array currently shares its buffer with another one */
+    inline bool isShared() const { return buffer && buffer.use_count() > 1; }
+
+    // ------------------------------------------------------------------
+    // write access; detaches from other copies first
+    // ------------------------------------------------------------------
+
+    /*! returns a reference to this array's own (not shared) buffer;
+        this is where the actual copy happens, if any */
+    std::vector<T> &edit()
+    {
+      if (!buffer)
+        buffer = std::make_shared<std::vector<T>>();
+      else if (buffer.use_count() > 1)
+        buffer = std::make_shared<std::vector<T>>(*buffer);
+      else
+        // make sure whatever another copy did with this buffer before
+        // it let go of it is visible to us
+        std::atomic_thread_fence(std::memory_order_acquire);
+      return *buffer;
+    }
+
+    inline void push_back(const T &t) { edit().push_back(t); }
+    template<typename... Args>
+    inline void emplace_back(Args&&... args) { edit().emplace_back(std::forward<Args>(args)...); }
+    inline void resize(size_t n) { edit().resize(n); }
+    inline void resize(size_t n, const T &t) { edit().resize(n,t); }
+    inline void reserve(size_t n) { edit().reserve(n); }
+    template<typename It>
+    inline iterator insert(const_iterator pos, It first, It last)
+    {
+      // 'pos' may point into the shared buffer, so convert to an
+      // index before detaching
+      const size_t ofs = pos - begin_const();
+      std::vector<T> &vec = edit();
+      return vec.insert(vec.begin()+ofs,first,last);
+    }
+
+    /*! empties this array (without affecting other copies) */
+    inline void clear() { buffer.reset(); }
+    inline void swap(CowVector &other) { buffer.swap(other.buffer); }
+
+    /*! moves the array out of this one (copying it if shared), and
+        leaves this one empty */
+    std::vector<T> release()
+    {
+      std::vector<T> result;
+      if (buffer) {
+        result = std::move(edit());
+        buffer.reset();
+      }
+      return result;
+    }
+
+  private:
+    inline const_iterator begin_const() const { return get().begin(); }
+
+    static const std::vector<T> &empty_vector()
+    { static const std::vector<T> empty; return empty; }
+
+    std::shared_ptr<std::vector<T>> buffer;
+  };
+
+} // ::mini
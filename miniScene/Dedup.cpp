@@ -0,0 +1,110 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Dedup.h"
+#include "miniScene/Serialized.h"
+#include <atomic>
+#include <unordered_map>
+
+namespace mini {
+
+  uint64_t hashMaterial(const Material &material)
+  {
+    XXHash64 hash;
+    const int32_t tag = material.tag();
+    hash.update(&tag,sizeof(tag));
+    for (auto &field : material.getFields()) {
+      if (field.type == MaterialField::TEXTURE) {
+        const Texture *texture = material.get<Texture::SP>(field).get();
+        hash.update(&texture,sizeof(texture));
+      } else
+        hash.update((const char *)&material+field.offset,field.fileSize());
+    }
+    return hash.digest();
+  }
+
+  bool sameMaterial(const Material &a, const Material &b)
+  {
+    if (a.tag() != b.tag())
+      return false;
+    for (auto &field : a.getFields()) {
+      if (field.type == MaterialField::TEXTURE) {
+        if (a.get<Texture::SP>(field) != b.get<Texture::SP>(field))
+          return false;
+      } else if (memcmp((const char *)&a+field.offset,
+                        (const char *)&b+field.offset,
+                        field.fileSize()))
+        return false;
+    }
+    return true;
+  }
+
+  DedupMaterialsStats dedupMaterials(Scene::SP scene,
+                                     const Progress &progress)
+  {
+    SerializedScene serialized(scene.get());
+    const std::vector<Material::SP> &materials = serialized.materials.list;
+    const std::vector<Mesh::SP>     &meshes    = serialized.meshes.list;
+    
+    std::vector<uint64_t> hashes(materials.size());
+    parallel_for_blocked
+      (progress,"hashing materials",(size_t)0,materials.size(),1024,
+       [&](size_t begin, size_t end) {
+         for (size_t matID=begin;matID<end;matID++)
+           hashes[matID] = hashMaterial(*materials[matID]);
+       });
+
+    // every material's replacement: the first one (in scene order)
+    // that's the same as it; hash collisions are rare, so the lists
+    // of materials per hash are (almost) always of length one
+    std::vector<Material::SP> replacements(materials.size());
+    std::unordered_map<uint64_t,std::vector<int>> unique;
+    DedupMaterialsStats stats;
+    stats.numMaterialsBefore = materials.size();
+    for (size_t matID=0;matID<materials.size();matID++) {
+      std::vector<int> &candidates = unique[hashes[matID]];
+      for (int otherID : candidates)
+        if (sameMaterial(*materials[otherID],*materials[matID])) {
+          replacements[matID] = materials[otherID];
+          break;
+        }
+      if (!replacements[matID]) {
+        replacements[matID] = materials[matID];
+        candidates.push_back((int)matID);
+        stats.numMaterialsAfter++;
+      }
+    }
+
+    std::atomic<size_t> numMeshesRewired { 0 };
+    parallel_for_blocked
+      (progress,"rewiring meshes",(size_t)0,meshes.size(),1024,
+       [&](size_t begin, size_t end) {
+         size_t numRewired = 0;
+         for (size_t meshID=begin;meshID<end;meshID++) {
+           const Mesh::SP &mesh = meshes[meshID];
+           const int matID = serialized.materials.getID(mesh->material);
+           if (matID < 0 || replacements[matID] == mesh->material)
+             continue;
+           mesh->material = replacements[matID];
+           numRewired++;
+         }
+         numMeshesRewired += numRewired;
+       });
+    stats.numMeshesRewired = numMeshesRewired;
+    return stats;
+  }
+  
+} // ::mini
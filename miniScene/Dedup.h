@@ -0,0 +1,50 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/Scene.h"
+
+namespace mini {
+
+  /*! hash of a material's type and all of its parameters (see
+      Material::getFields()), with textures by identity; equal
+      materials (see sameMaterial()) have equal hashes */
+  uint64_t hashMaterial(const Material &material);
+
+  /*! whether two materials are interchangeable: same type, bitwise
+      the same parameters, and the very same textures */
+  bool sameMaterial(const Material &a, const Material &b);
+
+  /*! what dedupMaterials() did */
+  struct DedupMaterialsStats {
+    /*! number of distinct materials the scene's meshes used before
+        and after */
+    size_t numMaterialsBefore = 0;
+    size_t numMaterialsAfter  = 0;
+    /*! number of meshes that got a different (but equal) material */
+    size_t numMeshesRewired   = 0;
+  };
+
+  /*! merges all materials of the scene that are the same (see
+      sameMaterial()) - as importers often create, e.g., one material
+      object per mesh - by pointing all meshes that use any of them
+      to the first one (in scene order). Materials get hashed, and
+      meshes rewired, in parallel */
+  DedupMaterialsStats dedupMaterials(Scene::SP scene,
+                                     const Progress &progress=Progress());
+
+} // ::mini
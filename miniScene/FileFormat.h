@@ -0,0 +1,168 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+/*! internal header, shared by the parts of the library that read or
+    write .mini files (Scene::save/load, SceneWriter); not meant to be
+    used by apps */
+
+#include "miniScene/Scene.h"
+#include "miniScene/IO.h"
+
+namespace mini {
+  namespace format {
+
+    enum { FORMAT_VERSION = 13 };
+    /* VERSION HISTORY
+       12: embree-style materials, with virtual material read/write
+       13: same as 12, but with a 64-bit 'features' mask right after
+           the magic, which says which (optional) encodings the file
+           uses. Files that don't use any of these still get written
+           as version 12.
+    */
+
+    /*! optional encodings a version-13 file may use */
+    enum : uint64_t {
+      /*! instance transforms are stored as CompactTransforms */
+      FEATURE_COMPACT_XFMS = (1ull<<0),
+      /*! every mesh stores a flag that says whether its indices are
+          stored as vec3i or vec3us */
+      FEATURE_INDEX16      = (1ull<<1),
+      /*! every mesh stores, for its positions, normals, and
+          texcoords, how they're encoded (see writeMesh()) */
+      FEATURE_QUANTIZED_GEOMETRY = (1ull<<2),
+      /*! like FEATURE_INDEX16, every mesh stores an IndexEncoding,
+          which may also be INDICES_COMPRESSED */
+      FEATURE_COMPRESSED_INDICES = (1ull<<3),
+      /*! every (unquantized) vertex, normal, and texcoord array is
+          preceded by its FloatEncoding */
+      FEATURE_COMPRESSED_FLOATS  = (1ull<<4),
+      /*! everything after the features mask is split into
+          ChecksumRecords (see RecordKind for which), each of which is
+          followed by its (uint64) hash; the end-of-file magic is
+          preceded by a vector of all ChecksumRecords, that vector's
+          hash, and a uint64 with its file offset (see
+          readChecksumTable()) */
+      FEATURE_CHECKSUMS          = (1ull<<5),
+      /*! the file is only the 'manifest' of a striped scene, whose
+          textures and meshes are in separate stripe files (see
+          stripe_magic) */
+      FEATURE_STRIPED            = (1ull<<6),
+
+      KNOWN_FEATURES
+      = FEATURE_COMPACT_XFMS
+      | FEATURE_INDEX16
+      | FEATURE_QUANTIZED_GEOMETRY
+      | FEATURE_COMPRESSED_INDICES
+      | FEATURE_COMPRESSED_FLOATS
+      | FEATURE_CHECKSUMS
+      | FEATURE_STRIPED
+    };
+
+    /*! how a mesh's indices are stored under FEATURE_INDEX16 and/or
+        FEATURE_COMPRESSED_INDICES */
+    typedef enum {
+      INDICES_VEC3I=0,
+      INDICES_VEC3US,
+      /*! as codecs::CompressedIndices: numTriangles, then its
+          blockBases, blockOffsets, and bytes */
+      INDICES_COMPRESSED
+    } IndexEncoding;
+
+    /*! how a mesh's normals or texcoords are stored under
+        FEATURE_QUANTIZED_GEOMETRY */
+    typedef enum {
+      /*! as vec3f/vec2f */
+      ATTRIBUTES_RAW=0,
+      /*! normals as octahedral uint32s, texcoords as vec2us (followed
+          by an int with the vertex_formats::TexcoordFormat) */
+      ATTRIBUTES_COMPACT
+    } AttributeEncoding;
+
+    /*! how an array of floats is stored under
+        FEATURE_COMPRESSED_FLOATS */
+    typedef enum {
+      FLOATS_RAW=0,
+      /*! as codecs::CompressedFloats: numComponents, numElements,
+          then its chunkOffsets and bytes */
+      FLOATS_COMPRESSED
+    } FloatEncoding;
+
+    const size_t expected_magic = 4321000000ULL+FORMAT_VERSION;
+    const size_t magic_v12      = expected_magic-1;
+    const size_t magic_v11      = expected_magic-2;
+
+    /* A striped scene (see SaveOptions::numStripes) is a manifest
+       file - a FEATURE_STRIPED .mini file whose features mask is
+       followed by an int with the number of stripes and a uint64
+       token, and in which every valid texture and mesh is stored as
+       just an int with the ID of the stripe it's in - plus one
+       stripe file per stripe, each of which is
+
+         size_t   stripe_magic
+         uint64_t features (the manifest's)
+         uint64_t token (the manifest's)
+         int      stripe ID
+         size_t   number of textures, then each one as by writeTexture()
+         size_t   number of meshes, then each one as by writeMesh()
+         size_t   stripe_magic
+
+       with its textures and meshes in the order the manifest
+       references them. Under FEATURE_CHECKSUMS every stripe file is
+       split into records of its own, and ends with its own checksum
+       table, just like a .mini file (with the texture and mesh
+       records referring to the IDs in the manifest). Every stripe
+       file may also be a block-compressed container around the
+       above. */
+
+    /*! the magic that stripe files start (and end) with */
+    const size_t stripe_magic   = 4321000201ULL;
+
+    /*! how .mini files identify material types */
+    typedef Material::Tag MaterialTag;
+
+    Material::SP createMaterialFromTag(MaterialTag tag);
+
+    /*! writes a (non-null) texture's data - everything but the
+        'valid' flag */
+    void writeTexture(std::ostream &out, const Texture &tex);
+
+    /*! reads what writeTexture() wrote */
+    void readTexture(std::istream &in, Texture &tex);
+
+    /*! writes a (non-null) mesh - everything but the 'valid' flag -
+        using given features and options. Under FEATURE_INDEX16 or
+        FEATURE_COMPRESSED_INDICES the indices are preceded by their
+        IndexEncoding. Under
+        FEATURE_QUANTIZED_GEOMETRY the positions are preceded by an
+        int with the number of bits per quantized component (0 for
+        plain vec3fs; else followed by the quantization's origin and
+        scale), and normals and texcoords each by their
+        AttributeEncoding */
+    void writeMesh(std::ostream &out, const Mesh &mesh, int materialID,
+                   uint64_t features, const SaveOptions &options);
+
+    /*! reads the table of ChecksumRecords of the (FEATURE_CHECKSUMS)
+        .mini or stripe file that starts at the stream's current
+        position (and
+        extends to its end); the stream has to be seekable. Throws if
+        the file doesn't have checksums, or if the table itself is
+        corrupt. Leaves the stream at an undefined position */
+    std::vector<ChecksumRecord> readChecksumTable(std::istream &in);
+
+  } // ::mini::format
+} // ::mini
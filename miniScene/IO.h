@@ -17,8 +17,12 @@
 #pragma once
 
 #include "miniScene/common.h"
+#include "miniScene/Memory.h"
+#include "miniScene/CowVector.h"
 // std
 #include <fstream>
+#include <functional>
+#include <streambuf>
 
 namespace mini {
     namespace io {
@@ -58,7 +62,7 @@ namespace mini {
       {
         size_t N;
         readElement(in,N);
-        t.resize(N);
+        memory::resizeBulk(t,N);
         if (safe_to_copy_binary<T>())
           in.read((char*)t.data(),N*sizeof(t[0]));
         else
@@ -98,6 +102,20 @@ namespace mini {
         assert(out.good());
       }
 
+      template<typename T>
+      void writeVector(std::ostream &out, const CowVector<T> &vt)
+      { writeVector(out,vt.get()); }
+
+      template<typename T>
+      inline void readVector(std::istream &in,
+                             CowVector<T> &t,
+                             const std::string &description="<no description>")
+      {
+        std::vector<T> vec;
+        readVector(in,vec,description);
+        t = std::move(vec);
+      }
+
       template<typename T>
       inline T readElement(std::istream &in)
       {
@@ -128,5 +146,141 @@ namespace mini {
         return s;
       }
 
+
+      /*! a std::streambuf that reads from a user-provided memory
+          region, without copying it (and supports seeking within
+          it). The memory has to stay valid for as long as the stream
+          is being read from */
+      struct MemoryReadBuffer : public std::streambuf {
+        MemoryReadBuffer(const void *data, size_t numBytes)
+        {
+          char *begin = (char*)data;
+          setg(begin,begin,begin+numBytes);
+        }
+
+      protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                         std::ios_base::openmode which) override
+        {
+          const char *base
+            = (dir == std::ios_base::beg) ? eback()
+            : (dir == std::ios_base::cur) ? gptr()
+            : egptr();
+          return seekpos(pos_type(off_type(base-eback())+off),which);
+        }
+        
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+        {
+          if (!(which & std::ios_base::in)
+              || off_type(pos) < 0 || off_type(pos) > egptr()-eback())
+            return pos_type(off_type(-1));
+          setg(eback(),eback()+off_type(pos),egptr());
+          return pos;
+        }
+      };
+
+      /*! a std::streambuf that pulls its data from a user-provided
+          read callback. Small reads go through an internal buffer;
+          large (bulk) reads go directly to the destination. The
+          callback returns the number of bytes actually read, with 0
+          meaning end of data */
+      struct CallbackReadBuffer : public std::streambuf {
+        typedef std::function<size_t(void *dst, size_t maxBytes)> ReadCallback;
+        
+        CallbackReadBuffer(const ReadCallback &read, size_t bufferSize=1<<20)
+          : read(read), buffer(bufferSize)
+        { setg(buffer.data(),buffer.data(),buffer.data()); }
+        
+      protected:
+        int_type underflow() override
+        {
+          if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+          size_t numRead = read(buffer.data(),buffer.size());
+          setg(buffer.data(),buffer.data(),buffer.data()+numRead);
+          return numRead
+            ? traits_type::to_int_type(*gptr())
+            : traits_type::eof();
+        }
+        
+        std::streamsize xsgetn(char *dst, std::streamsize count) override
+        {
+          std::streamsize numCopied = 0;
+          const std::streamsize numBuffered = std::min(count,std::streamsize(egptr()-gptr()));
+          memcpy(dst,gptr(),numBuffered);
+          gbump((int)numBuffered);
+          numCopied += numBuffered;
+          if (numCopied < count && size_t(count-numCopied) >= buffer.size()) {
+            // large read - bypass the buffer
+            while (numCopied < count) {
+              size_t numRead = read(dst+numCopied,size_t(count-numCopied));
+              if (numRead == 0) break;
+              numCopied += numRead;
+            }
+            return numCopied;
+          }
+          while (numCopied < count) {
+            if (underflow() == traits_type::eof()) break;
+            const std::streamsize numNow = std::min(count-numCopied,std::streamsize(egptr()-gptr()));
+            memcpy(dst+numCopied,gptr(),numNow);
+            gbump((int)numNow);
+            numCopied += numNow;
+          }
+          return numCopied;
+        }
+        
+        ReadCallback      read;
+        std::vector<char> buffer;
+      };
+
+      /*! a std::streambuf that pushes its data into a user-provided
+          write callback. Small writes go through an internal buffer;
+          large (bulk) writes go directly to the callback */
+      struct CallbackWriteBuffer : public std::streambuf {
+        typedef std::function<void(const void *src, size_t numBytes)> WriteCallback;
+        
+        CallbackWriteBuffer(const WriteCallback &write, size_t bufferSize=1<<20)
+          : write(write), buffer(bufferSize)
+        { setp(buffer.data(),buffer.data()+buffer.size()); }
+
+        /*! pushes all currently buffered bytes to the callback. Note
+            this does _not_ get called automatically upon destruction
+            (the callback might throw); call this (or the stream's
+            flush()) when done writing */
+        void flush()
+        {
+          if (pptr() > pbase()) write(pbase(),size_t(pptr()-pbase()));
+          setp(buffer.data(),buffer.data()+buffer.size());
+        }
+        
+      protected:
+        int_type overflow(int_type c) override
+        {
+          flush();
+          if (!traits_type::eq_int_type(c,traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+          }
+          return traits_type::not_eof(c);
+        }
+        
+        std::streamsize xsputn(const char *src, std::streamsize count) override
+        {
+          if (size_t(count) >= buffer.size()) {
+            flush();
+            write(src,size_t(count));
+            return count;
+          }
+          if (count > epptr()-pptr()) flush();
+          memcpy(pptr(),src,size_t(count));
+          pbump((int)count);
+          return count;
+        }
+        
+        int sync() override { flush(); return 0; }
+        
+        WriteCallback     write;
+        std::vector<char> buffer;
+      };
+
     } // ::mini::io
 } // ::mini
@@ -0,0 +1,155 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/IndexedScene.h"
+#include "miniScene/Serialized.h"
+
+namespace mini {
+
+  const uint32_t IndexedScene::INVALID_ID;
+  
+  IndexedScene::SP IndexedScene::create(Scene::SP scene,
+                                        const Progress &progress)
+  {
+    IndexedScene::SP indexed = std::make_shared<IndexedScene>();
+    indexed->quadLights  = scene->quadLights;
+    indexed->dirLights   = scene->dirLights;
+    indexed->envMapLight = scene->envMapLight;
+
+    SerializedScene serialized(scene.get());
+    indexed->textures  = serialized.textures.list;
+    indexed->materials = serialized.materials.list;
+    indexed->meshes    = serialized.meshes.list;
+
+    indexed->meshMaterialIDs.resize(indexed->meshes.size());
+    parallel_for
+      (progress,"indexing meshes",indexed->meshes.size(),
+       [&](size_t meshID) {
+         indexed->meshMaterialIDs[meshID]
+           = (uint32_t)serialized.materials.getID(indexed->meshes[meshID]->material);
+       });
+
+    const size_t numObjects = serialized.objects.size();
+    indexed->objectMeshBegin.resize(numObjects+1);
+    uint32_t numObjectMeshes = 0;
+    for (size_t objID=0;objID<numObjects;objID++) {
+      indexed->objectMeshBegin[objID] = numObjectMeshes;
+      numObjectMeshes += (uint32_t)serialized.objects.list[objID]->meshes.size();
+    }
+    indexed->objectMeshBegin[numObjects] = numObjectMeshes;
+    indexed->objectMeshIDs.resize(numObjectMeshes);
+    parallel_for
+      (progress,"indexing objects",numObjects,
+       [&](size_t objID) {
+         const Object &object = *serialized.objects.list[objID];
+         uint32_t *meshIDs = indexed->objectMeshIDs.data()+indexed->objectMeshBegin[objID];
+         for (size_t i=0;i<object.meshes.size();i++)
+           // null meshes aren't in the registry, and thus get -1
+           meshIDs[i] = (uint32_t)serialized.meshes.getID(object.meshes[i]);
+       });
+
+    const size_t numInstances = scene->instances.size();
+    indexed->instanceXfms.resize(numInstances);
+    indexed->instanceObjectIDs.resize(numInstances);
+    parallel_for_blocked
+      (progress,"indexing instances",(size_t)0,numInstances,16*1024,
+       [&](size_t begin, size_t end) {
+         for (size_t instID=begin;instID<end;instID++) {
+           const Instance::SP &inst = scene->instances[instID];
+           indexed->instanceXfms[instID]
+             = inst ? inst->xfm : affine3f();
+           indexed->instanceObjectIDs[instID]
+             = inst ? (uint32_t)serialized.objects.getID(inst->object) : INVALID_ID;
+         }
+       });
+    return indexed;
+  }
+
+  Scene::SP IndexedScene::toScene() const
+  {
+    Scene::SP scene = Scene::create();
+    scene->quadLights  = quadLights;
+    scene->dirLights   = dirLights;
+    scene->envMapLight = envMapLight;
+
+    std::vector<Object::SP> objects(numObjects());
+    parallel_for
+      (objects.size(),
+       [&](size_t objID) {
+         Object::SP object = Object::create();
+         object->meshes.resize(numMeshesIn((uint32_t)objID));
+         for (uint32_t i=0;i<object->meshes.size();i++) {
+           uint32_t meshID = meshIDOf((uint32_t)objID,i);
+           if (meshID != INVALID_ID)
+             object->meshes[i] = meshes[meshID];
+         }
+         objects[objID] = object;
+       });
+
+    scene->instances.resize(numInstances());
+    parallel_for_blocked
+      ((size_t)0,numInstances(),16*1024,
+       [&](size_t begin, size_t end) {
+         for (size_t instID=begin;instID<end;instID++) {
+           uint32_t objID = instanceObjectIDs[instID];
+           if (objID == INVALID_ID) continue;
+           scene->instances[instID]
+             = Instance::create(objects[objID],instanceXfms[instID]);
+         }
+       });
+    return scene;
+  }
+
+  box3f IndexedScene::getBounds() const
+  {
+    std::vector<box3f> meshBounds(meshes.size());
+    parallel_for
+      (meshes.size(),
+       [&](size_t meshID) {
+         meshBounds[meshID] = meshes[meshID]->getBounds();
+       });
+
+    std::vector<box3f> objectBounds(numObjects());
+    parallel_for
+      (objectBounds.size(),
+       [&](size_t objID) {
+         box3f bounds;
+         for (uint32_t i=0;i<numMeshesIn((uint32_t)objID);i++) {
+           uint32_t meshID = meshIDOf((uint32_t)objID,i);
+           if (meshID != INVALID_ID)
+             bounds.extend(meshBounds[meshID]);
+         }
+         objectBounds[objID] = bounds;
+       });
+
+    box3f bounds;
+    std::mutex mutex;
+    parallel_for_blocked
+      ((size_t)0,numInstances(),16*1024,
+       [&](size_t begin, size_t end) {
+         box3f blockBounds;
+         for (size_t instID=begin;instID<end;instID++) {
+           uint32_t objID = instanceObjectIDs[instID];
+           if (objID == INVALID_ID || objectBounds[objID].empty()) continue;
+           blockBounds.extend(xfmBox(instanceXfms[instID],objectBounds[objID]));
+         }
+         std::lock_guard<std::mutex> lock(mutex);
+         bounds.extend(blockBounds);
+       });
+    return bounds;
+  }
+
+} // ::mini
@@ -0,0 +1,96 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/Scene.h"
+
+namespace mini {
+
+  /*! a "frozen", index-based view of a mini::Scene: all unique
+      textures, materials, meshes, and objects get stored exactly once
+      in dense arrays, and everything that refers to them (objects to
+      meshes, meshes to materials, instances to objects) does so
+      through 32-bit indices into these arrays rather than through
+      shared pointers. This allows parallel passes over the scene
+      (with potentially millions of instances) to run without any
+      atomic reference count traffic on the (few, heavily shared)
+      objects and meshes.
+
+      The view does _not_ copy any meshes, materials, or textures; it
+      shares them with the scene it was created from. It is meant to
+      be read, not edited: changing IDs in here does not affect the
+      meshes or scene it was created from (but toScene() will use the
+      modified object and instance IDs). */
+  struct IndexedScene {
+    typedef std::shared_ptr<IndexedScene> SP;
+
+    /*! ID used for null meshes, instances, and textures */
+    static const uint32_t INVALID_ID = uint32_t(-1);
+
+    /*! creates an indexed view of the given scene, in parallel;
+        reports its progress to, and can be cancelled through, the
+        given Progress (throwing Cancelled) */
+    static SP create(Scene::SP scene,
+                     const Progress &progress=Progress());
+
+    /*! creates a new mini::Scene from this view; the new scene shares
+        all meshes (and thus, materials and textures) with this
+        view, but gets new objects and instances */
+    Scene::SP toScene() const;
+
+    inline size_t numObjects()   const { return objectMeshBegin.empty() ? 0 : objectMeshBegin.size()-1; }
+    inline size_t numInstances() const { return instanceObjectIDs.size(); }
+
+    /*! number of meshes in the given object */
+    inline uint32_t numMeshesIn(uint32_t objectID) const
+    { return objectMeshBegin[objectID+1]-objectMeshBegin[objectID]; }
+
+    /*! returns ID of the i'th mesh in given object */
+    inline uint32_t meshIDOf(uint32_t objectID, uint32_t i) const
+    { return objectMeshIDs[objectMeshBegin[objectID]+i]; }
+
+    /*! computes and returns the world space bounding box of this
+        scene, in parallel, and without touching any reference
+        counts */
+    box3f getBounds() const;
+
+    /*! the unique textures used by the scene's materials; ID 0 is
+        always a null texture (as in the file format) */
+    std::vector<Texture::SP>  textures;
+    std::vector<Material::SP> materials;
+    std::vector<Mesh::SP>     meshes;
+
+    /*! for each mesh, the ID of its material */
+    std::vector<uint32_t>     meshMaterialIDs;
+
+    /*! the meshes of object i are objectMeshIDs[objectMeshBegin[i]]
+        ... objectMeshIDs[objectMeshBegin[i+1]-1]; a null mesh has
+        INVALID_ID */
+    std::vector<uint32_t>     objectMeshBegin;
+    std::vector<uint32_t>     objectMeshIDs;
+
+    /*! for each instance, its transform and the ID of the object it
+        instantiates (INVALID_ID for null instances) */
+    std::vector<affine3f>     instanceXfms;
+    std::vector<uint32_t>     instanceObjectIDs;
+
+    std::vector<QuadLight>    quadLights;
+    std::vector<DirLight>     dirLights;
+    EnvMapLight::SP           envMapLight;
+  };
+
+} // ::mini
@@ -0,0 +1,126 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/MaterialTable.h"
+#include "miniScene/Serialized.h"
+#include "miniScene/FileFormat.h"
+
+namespace mini {
+
+  /*! the entry layouts of all material types, indexed by tag
+      (INVALID's is empty) */
+  static const std::vector<std::vector<MaterialField>> &allLayouts()
+  {
+    static const std::vector<std::vector<MaterialField>> layouts = [] {
+      std::vector<std::vector<MaterialField>> layouts(Material::ANARI_MATERIAL+1);
+      for (int tag=Material::INVALID+1;tag<=Material::ANARI_MATERIAL;tag++) {
+        Material::SP prototype = format::createMaterialFromTag((Material::Tag)tag);
+        size_t offset = sizeof(int32_t);
+        for (auto field : prototype->getFields()) {
+          field.offset = offset;
+          offset += field.fileSize();
+          layouts[tag].push_back(field);
+        }
+      }
+      return layouts;
+    }();
+    return layouts;
+  }
+  
+  const std::vector<MaterialField> &MaterialTable::getLayout(Material::Tag tag)
+  {
+    const std::vector<std::vector<MaterialField>> &layouts = allLayouts();
+    if ((size_t)tag >= layouts.size())
+      throw std::runtime_error("MaterialTable::getLayout(): invalid material tag "
+                               +std::to_string((int)tag));
+    return layouts[tag];
+  }
+  
+  size_t MaterialTable::getStride()
+  {
+    static const size_t stride = [] {
+      size_t maxSize = 0;
+      for (auto &layout : allLayouts())
+        if (!layout.empty())
+          maxSize = std::max(maxSize,layout.back().offset+layout.back().fileSize());
+      return (maxSize+15) & ~size_t(15);
+    }();
+    return stride;
+  }
+
+  MaterialTable::SP MaterialTable::create(Scene::SP scene,
+                                          const Progress &progress)
+  {
+    SerializedScene serialized(scene.get());
+    MaterialTable::SP table = create(serialized.materials.list,progress);
+    table->meshMaterialIDs.resize(serialized.meshes.size());
+    for (size_t meshID=0;meshID<serialized.meshes.size();meshID++) {
+      const Material::SP &material = serialized.meshes.list[meshID]->material;
+      table->meshMaterialIDs[meshID]
+        = material ? serialized.materials.getID(material) : -1;
+    }
+    return table;
+  }
+  
+  MaterialTable::SP MaterialTable::create(const std::vector<Material::SP> &materials,
+                                          const Progress &progress)
+  {
+    MaterialTable::SP table = std::make_shared<MaterialTable>();
+
+    // assign texture IDs (serially, so they're in order of first use)
+    Serialized<Texture::SP> textures;
+    for (auto &material : materials) {
+      if (!material) continue;
+      for (auto &field : material->getFields())
+        if (field.type == MaterialField::TEXTURE) {
+          const Texture::SP &texture = material->get<Texture::SP>(field);
+          if (texture) textures.add(texture);
+        }
+    }
+    table->textures = textures.list;
+
+    const size_t stride = table->stride;
+    table->numMaterials = materials.size();
+    table->data.resize(materials.size()*stride);
+    parallel_for_blocked
+      (progress,"packing materials",(size_t)0,materials.size(),1024,
+       [&](size_t begin, size_t end) {
+         for (size_t matID=begin;matID<end;matID++) {
+           uint8_t *entry = table->data.data()+matID*stride;
+           memset(entry,0,stride);
+           const Material::SP &material = materials[matID];
+           const int32_t tag = material ? material->tag() : Material::INVALID;
+           memcpy(entry,&tag,sizeof(tag));
+           if (!material) continue;
+
+           const std::vector<MaterialField> &fields = material->getFields();
+           const std::vector<MaterialField> &layout = getLayout(material->tag());
+           for (size_t i=0;i<fields.size();i++) {
+             if (fields[i].type == MaterialField::TEXTURE) {
+               const Texture::SP &texture = material->get<Texture::SP>(fields[i]);
+               const int32_t textureID = texture ? textures.getID(texture) : -1;
+               memcpy(entry+layout[i].offset,&textureID,sizeof(textureID));
+             } else
+               memcpy(entry+layout[i].offset,
+                      (const char *)material.get()+fields[i].offset,
+                      fields[i].fileSize());
+           }
+         }
+       });
+    return table;
+  }
+  
+} // ::mini
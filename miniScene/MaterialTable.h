@@ -0,0 +1,91 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/Scene.h"
+
+namespace mini {
+
+  /*! a "flat", GPU-ready table of a scene's materials: every
+      material is stored as a fixed-size entry - a tagged union of
+      all material types - in one contiguous byte array, with
+      textures referenced by their index in a (dense) texture table
+      rather than by shared pointer. The whole table can thus get
+      uploaded with a single memcpy, and be indexed on the device as
+      'data + materialID * stride'.
+
+      Every entry starts with the material's Material::Tag (as an
+      int32), followed by the material's parameters in the order of
+      its Material::getFields() - that is, the same layout in which
+      .mini files store materials - with floats and ints taking four
+      bytes, vec3fs twelve bytes, and textures an int32 index into
+      'textures' (-1 for no texture). getLayout() returns where in an
+      entry each of a given material type's parameters is. The
+      remainder of each entry is zero. */
+  struct MaterialTable {
+    typedef std::shared_ptr<MaterialTable> SP;
+
+    /*! builds the table for all materials used by the scene's
+        meshes, in parallel. Materials get the same IDs as in
+        PackedScene and IndexedScene, and 'meshMaterialIDs' says
+        which one each (unique) mesh uses */
+    static SP create(Scene::SP scene,
+                     const Progress &progress=Progress());
+
+    /*! builds the table for the given list of materials (e.g.,
+        PackedScene::materials), in parallel; leaves
+        meshMaterialIDs empty. Null materials get an entry with tag
+        Material::INVALID */
+    static SP create(const std::vector<Material::SP> &materials,
+                     const Progress &progress=Progress());
+
+    /*! the size of every entry, in bytes: large enough for the
+        largest material type, and a multiple of 16. This is the
+        same for all tables */
+    static size_t getStride();
+
+    /*! where in an entry each parameter of given material type is:
+        the same fields as that type's Material::getFields(), but
+        with offsets relative to the entry's start, and with TEXTURE
+        fields meaning an int32 index into 'textures' */
+    static const std::vector<MaterialField> &getLayout(Material::Tag tag);
+
+    /*! the entry for given material */
+    inline const uint8_t *getEntry(int materialID) const
+    { return data.data()+materialID*stride; }
+    
+    /*! the material type of given entry */
+    inline Material::Tag getTag(int materialID) const
+    { return (Material::Tag)*(const int32_t *)getEntry(materialID); }
+
+    /*! size of 'data', in bytes */
+    inline size_t sizeInBytes() const { return data.size(); }
+    
+    size_t               stride       = getStride();
+    size_t               numMaterials = 0;
+    /*! all entries, numMaterials*stride bytes */
+    std::vector<uint8_t> data;
+    /*! all (non-null) textures referenced by any material, in order
+        of first use */
+    std::vector<Texture::SP> textures;
+    /*! index into the table for every unique mesh (in the same
+        order as PackedScene::meshes); -1 for meshes without a
+        material */
+    std::vector<int>     meshMaterialIDs;
+  };
+
+} // ::mini
@@ -0,0 +1,280 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Memory.h"
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+# include <dirent.h>
+#endif
+
+namespace mini {
+  namespace memory {
+
+    /*! anything smaller than a few huge pages isn't worth it - we'd
+        lose up to two (partial) pages at the boundaries anyway */
+    std::atomic<size_t> hugePageThreshold { 4*HUGE_PAGE_SIZE };
+
+    std::atomic<size_t> numHugePageArrays { 0 };
+    std::atomic<size_t> hugePageAdvisedBytes { 0 };
+
+    void setHugePageThreshold(size_t numBytes)
+    { hugePageThreshold = numBytes; }
+
+    size_t getHugePageThreshold()
+    { return hugePageThreshold; }
+
+    void adviseHugePages(void *ptr, size_t numBytes)
+    {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+      if (!ptr || numBytes < hugePageThreshold) return;
+
+      const size_t begin = ((size_t)ptr + HUGE_PAGE_SIZE - 1) & ~size_t(HUGE_PAGE_SIZE-1);
+      const size_t end   = ((size_t)ptr + numBytes) & ~size_t(HUGE_PAGE_SIZE-1);
+      if (end <= begin) return;
+
+      if (madvise((void*)begin,end-begin,MADV_HUGEPAGE) != 0)
+        // not an error - the kernel may simply not have THP enabled
+        return;
+      numHugePageArrays++;
+      hugePageAdvisedBytes += (end-begin);
+#endif
+    }
+
+    // ------------------------------------------------------------------
+    // NUMA placement
+    // ------------------------------------------------------------------
+
+    /*! smaller arrays aren't worth spreading over multiple pages,
+        let alone nodes */
+    std::atomic<size_t> numaThreshold { 1024*1024 };
+    std::atomic<int>    numaPlacement { NUMA_DEFAULT };
+    /*! per-thread override set by ScopedNumaPlacement; -1 for none */
+    thread_local int    threadNumaPlacement = -1;
+    /*! next node for NUMA_ROUND_ROBIN */
+    std::atomic<size_t> nextRoundRobinNode { 0 };
+
+    std::atomic<size_t> numNumaPlacedArrays { 0 };
+    std::atomic<size_t> numaPlacedBytes { 0 };
+
+    /*! finds the nodes with memory, via sysfs */
+    std::vector<int> queryNumaNodes()
+    {
+      std::vector<int> nodes;
+#ifdef __linux__
+      if (DIR *dir = opendir("/sys/devices/system/node")) {
+        while (struct dirent *entry = readdir(dir)) {
+          int nodeID;
+          if (sscanf(entry->d_name,"node%i",&nodeID) == 1)
+            nodes.push_back(nodeID);
+        }
+        closedir(dir);
+      }
+#endif
+      if (nodes.empty())
+        nodes.push_back(0);
+      std::sort(nodes.begin(),nodes.end());
+      return nodes;
+    }
+
+    const std::vector<int> &getNumaNodes()
+    {
+      static const std::vector<int> nodes = queryNumaNodes();
+      return nodes;
+    }
+
+    void setNumaPlacement(NumaPlacement placement)
+    { numaPlacement = placement; }
+
+    NumaPlacement getNumaPlacement()
+    {
+      return (NumaPlacement)(threadNumaPlacement >= 0
+                             ? threadNumaPlacement
+                             : numaPlacement.load());
+    }
+
+    ScopedNumaPlacement::ScopedNumaPlacement(NumaPlacement placement)
+      : saved(threadNumaPlacement)
+    {
+      if (placement != NUMA_DEFAULT)
+        threadNumaPlacement = placement;
+    }
+
+    ScopedNumaPlacement::~ScopedNumaPlacement()
+    { threadNumaPlacement = saved; }
+
+    void setNumaThreshold(size_t numBytes)
+    { numaThreshold = numBytes; }
+
+    size_t getNumaThreshold()
+    { return numaThreshold; }
+
+#if defined(__linux__) && defined(SYS_mbind)
+    /* from linux/mempolicy.h; we call mbind directly rather than
+       through libnuma, so we don't need that as a dependency */
+    enum { MINI_MPOL_PREFERRED = 1, MINI_MPOL_INTERLEAVE = 3 };
+    enum { MAX_NUMA_NODES = 1024 };
+
+    /*! sets the memory policy of all whole pages in [begin,end) */
+    bool bindPages(size_t begin, size_t end, int mode,
+                   const std::vector<int> &nodes)
+    {
+      const size_t pageSize = sysconf(_SC_PAGESIZE);
+      begin = (begin + pageSize - 1) & ~(pageSize-1);
+      end   = end & ~(pageSize-1);
+      if (end <= begin) return false;
+
+      const int bitsPerLong = 8*sizeof(unsigned long);
+      unsigned long mask[MAX_NUMA_NODES/bitsPerLong] = { 0 };
+      for (auto node : nodes)
+        if (node >= 0 && node < MAX_NUMA_NODES)
+          mask[node/bitsPerLong] |= 1ul << (node%bitsPerLong);
+      // not an error if this fails - we're only giving hints
+      return syscall(SYS_mbind,(void*)begin,end-begin,mode,
+                     mask,(unsigned long)MAX_NUMA_NODES+1,0u) == 0;
+    }
+#endif
+
+    void placeOnNumaNodes(void *ptr, size_t numBytes)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+      const NumaPlacement placement = getNumaPlacement();
+      const std::vector<int> &nodes = getNumaNodes();
+      if (!ptr || placement == NUMA_DEFAULT || nodes.size() < 2
+          || numBytes < numaThreshold)
+        return;
+
+      const size_t begin = (size_t)ptr;
+      const size_t end   = begin+numBytes;
+      bool placed = false;
+      switch (placement) {
+      case NUMA_INTERLEAVE:
+        placed = bindPages(begin,end,MINI_MPOL_INTERLEAVE,nodes);
+        break;
+      case NUMA_ROUND_ROBIN: {
+        const int node = nodes[nextRoundRobinNode++ % nodes.size()];
+        placed = bindPages(begin,end,MINI_MPOL_PREFERRED,{node});
+      } break;
+      case NUMA_PARTITIONED:
+        for (size_t i=0;i<nodes.size();i++)
+          placed |= bindPages(begin+(numBytes*i)/nodes.size(),
+                              begin+(numBytes*(i+1))/nodes.size(),
+                              MINI_MPOL_PREFERRED,{nodes[i]});
+        break;
+      default:
+        break;
+      }
+      if (!placed) return;
+      numNumaPlacedArrays++;
+      numaPlacedBytes += numBytes;
+#endif
+    }
+
+    /*! reads how many bytes of this process' memory currently reside
+        on each NUMA node; returns an empty vector if this can't be
+        determined */
+    std::vector<size_t> queryBytesOnNumaNodes()
+    {
+      std::vector<size_t> bytesOnNode;
+#ifdef __linux__
+      std::ifstream numaMaps("/proc/self/numa_maps");
+      std::string line;
+      while (std::getline(numaMaps,line)) {
+        // each line is one mapping, with entries like "N0=123" (the
+        // number of pages on node 0) and "kernelpagesize_kB=4"
+        std::vector<std::pair<int,size_t>> pagesOnNode;
+        size_t pageSize = 4096;
+        std::stringstream ss(line);
+        std::string token;
+        while (ss >> token) {
+          int node; unsigned long long count;
+          if (sscanf(token.c_str(),"N%i=%llu",&node,&count) == 2 && node >= 0)
+            pagesOnNode.push_back({node,(size_t)count});
+          else if (sscanf(token.c_str(),"kernelpagesize_kB=%llu",&count) == 1)
+            pageSize = size_t(count)*1024;
+        }
+        for (auto &pages : pagesOnNode) {
+          if (pages.first >= (int)bytesOnNode.size())
+            bytesOnNode.resize(pages.first+1,0);
+          bytesOnNode[pages.first] += pages.second*pageSize;
+        }
+      }
+#endif
+      return bytesOnNode;
+    }
+
+    /*! reads how many bytes of this process' anonymous memory are
+        currently backed by huge pages; returns 0 if this can't be
+        determined */
+    size_t queryHugePageBackedBytes()
+    {
+#ifdef __linux__
+      std::ifstream smaps("/proc/self/smaps_rollup");
+      std::string line;
+      while (std::getline(smaps,line)) {
+        if (line.compare(0,14,"AnonHugePages:") != 0) continue;
+        return size_t(std::stoull(line.substr(14)))*1024;
+      }
+#endif
+      return 0;
+    }
+
+    MemoryStats getStats()
+    {
+      MemoryStats stats;
+      stats.numHugePageArrays    = numHugePageArrays;
+      stats.hugePageAdvisedBytes = hugePageAdvisedBytes;
+      stats.hugePageBackedBytes  = queryHugePageBackedBytes();
+      stats.numNumaPlacedArrays  = numNumaPlacedArrays;
+      stats.numaPlacedBytes      = numaPlacedBytes;
+      stats.bytesOnNumaNode      = queryBytesOnNumaNodes();
+      return stats;
+    }
+
+  } // ::mini::memory
+
+  Arena::~Arena()
+  {
+    for (auto block : blocks)
+      free(block);
+  }
+
+  void *Arena::allocate(size_t numBytes, size_t alignment)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t padding = (alignment - ((size_t)current & (alignment-1))) & (alignment-1);
+    if (padding + numBytes > remaining) {
+      // start a new block; anything larger than a block gets a block
+      // of its own
+      size_t newBlockSize = std::max(blockSize,numBytes+alignment);
+      char *block = (char*)malloc(newBlockSize);
+      if (!block) throw std::bad_alloc();
+      blocks.push_back(block);
+      current   = block;
+      remaining = newBlockSize;
+      padding   = (alignment - ((size_t)current & (alignment-1))) & (alignment-1);
+    }
+    char *result = current + padding;
+    current   += padding + numBytes;
+    remaining -= padding + numBytes;
+    return result;
+  }
+
+} // ::mini
@@ -0,0 +1,251 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/common.h"
+
+namespace mini {
+
+  /*! how large "bulk" arrays (vertices, indices, texels, ...) get
+      placed on the NUMA nodes of a multi-socket machine. All of these
+      get applied when the array gets allocated (ie, before anything
+      touches it), so they don't depend on which thread later writes
+      the data. On machines with a single NUMA node, and on non-linux
+      systems, all of these are the same as NUMA_DEFAULT. */
+  typedef enum {
+    /*! leave it to the OS - which usually means "on the node of the
+        thread that first touches it", ie, for a scene loaded by a
+        single thread, all of it on the same node */
+    NUMA_DEFAULT=0,
+    /*! pages of every array get interleaved across all nodes; good
+        for arrays that all threads access more or less randomly */
+    NUMA_INTERLEAVE,
+    /*! every array gets placed on a single node, with successive
+        arrays cycling through the nodes */
+    NUMA_ROUND_ROBIN,
+    /*! every array gets split into one contiguous range per node,
+        with the first range on the first node, etc; good for arrays
+        that later get processed by parallel loops that split their
+        index range into equal parts */
+    NUMA_PARTITIONED
+  } NumaPlacement;
+
+  /*! some statistics on how the memory for large "bulk" arrays
+      (vertices, indices, texels, ...) was allocated */
+  struct MemoryStats {
+    /*! number of bulk arrays that were above the huge page threshold,
+        and that we requested transparent huge pages for */
+    size_t numHugePageArrays    = 0;
+
+    /*! total number of bytes (in those arrays) that we issued a
+        huge-page request for. Note this is only a _request_; the
+        kernel may or may not honor it */
+    size_t hugePageAdvisedBytes = 0;
+
+    /*! number of bytes of this process' memory that the kernel
+        _actually_ backs by (anonymous) huge pages right now, as
+        reported by the OS; 0 if the OS doesn't tell us */
+    size_t hugePageBackedBytes  = 0;
+
+    /*! number of bulk arrays that we placed on NUMA nodes (according
+        to the NumaPlacement active when they got allocated), and the
+        total number of bytes in those */
+    size_t numNumaPlacedArrays  = 0;
+    size_t numaPlacedBytes      = 0;
+
+    /*! how many bytes of this process' (resident) memory currently
+        reside on each NUMA node, as reported by the OS; indexed by
+        node ID, and empty if the OS doesn't tell us */
+    std::vector<size_t> bytesOnNumaNode;
+  };
+
+  namespace memory {
+
+    /*! size of a (x86/arm64 linux) transparent huge page */
+    enum { HUGE_PAGE_SIZE = 2*1024*1024 };
+
+    /*! sets the minimum size (in bytes) an array has to have for us to
+        request huge pages for it; size_t(-1) disables huge pages
+        altogether */
+    void setHugePageThreshold(size_t numBytes);
+    size_t getHugePageThreshold();
+
+    /*! tells the OS that the given memory range should be backed by
+        transparent huge pages, if possible. Since the OS can only do
+        this for properly aligned 2MB regions we only advise the
+        (2MB-aligned) _interior_ of the given range; the first and
+        last partial pages get regular pages. This has to be called
+        _before_ that memory gets touched for the first time to have
+        the most effect. No-op on non-linux systems, and for arrays
+        smaller than the huge page threshold. */
+    void adviseHugePages(void *ptr, size_t numBytes);
+
+    /*! returns the IDs of the NUMA nodes that have memory; a single
+        node 0 if that can't be determined */
+    const std::vector<int> &getNumaNodes();
+
+    /*! sets how bulk arrays allocated from now on get placed on NUMA
+        nodes (see NumaPlacement); the default is NUMA_DEFAULT */
+    void setNumaPlacement(NumaPlacement placement);
+    /*! returns the placement active for the calling thread */
+    NumaPlacement getNumaPlacement();
+
+    /*! overrides the NUMA placement for all bulk arrays the calling
+        thread allocates during this object's lifetime; eg, for the
+        duration of a Scene::load(). NUMA_DEFAULT leaves the current
+        placement unchanged. Note this only affects the calling
+        thread - parallel_for workers that allocate bulk arrays have
+        to get it handed over, see withNumaPlacement() */
+    struct ScopedNumaPlacement {
+      ScopedNumaPlacement(NumaPlacement placement);
+      ~ScopedNumaPlacement();
+    private:
+      int saved;
+    };
+
+    /*! a function object that calls 'fn' under a given
+        ScopedNumaPlacement; see withNumaPlacement() */
+    template<typename Fn>
+    struct WithNumaPlacement {
+      template<typename... Args>
+      inline void operator()(Args&&... args) const
+      {
+        ScopedNumaPlacement scoped(placement);
+        fn(std::forward<Args>(args)...);
+      }
+
+      NumaPlacement placement;
+      Fn            fn;
+    };
+
+    /*! wraps a parallel_for body such that it runs with the calling
+        thread's current NumaPlacement on whichever (worker) thread
+        it ends up on, so bulk arrays allocated in there get placed
+        the same way as those allocated by the calling thread:
+
+          parallel_for(N,memory::withNumaPlacement([&](size_t i) {
+            .. memory::resizeBulk(..) ..
+          }));
+    */
+    template<typename Fn>
+    inline WithNumaPlacement<Fn> withNumaPlacement(Fn fn)
+    { return { getNumaPlacement(), fn }; }
+
+    /*! sets the minimum size (in bytes) an array has to have for us to
+        place it on NUMA nodes */
+    void setNumaThreshold(size_t numBytes);
+    size_t getNumaThreshold();
+
+    /*! tells the OS on which NUMA node(s) to put the pages of the
+        given memory range, according to the current NumaPlacement.
+        Like adviseHugePages() this only affects pages that haven't
+        been touched yet, and only whole pages (so the partial pages at
+        either end stay where the OS puts them). No-op for arrays
+        smaller than the NUMA threshold, with NUMA_DEFAULT, and on
+        machines with a single NUMA node. */
+    void placeOnNumaNodes(void *ptr, size_t numBytes);
+
+    /*! returns current statistics of how much memory got
+        huge-page-advised, and how much is actually backed by huge
+        pages */
+    MemoryStats getStats();
+
+    /*! resizes given vector to N elements, just like
+        std::vector::resize - but if the vector is empty and the
+        result is large enough it first reserves untouched memory,
+        advises that to use huge pages and/or places it on NUMA
+        nodes, and only then value-initializes (ie, touches) it. Use
+        for all large bulk arrays such as vertex or index arrays */
+    template<typename T>
+    inline void resizeBulk(std::vector<T> &vec, size_t N)
+    {
+      const size_t numBytes = N*sizeof(T);
+      if (vec.empty() && vec.capacity() < N
+          && (numBytes >= getHugePageThreshold()
+              || (numBytes >= getNumaThreshold()
+                  && getNumaPlacement() != NUMA_DEFAULT))) {
+        std::vector<T>().swap(vec);
+        vec.reserve(N);
+        adviseHugePages(vec.data(),numBytes);
+        placeOnNumaNodes(vec.data(),numBytes);
+      }
+      vec.resize(N);
+    }
+
+  } // ::mini::memory
+
+  /*! a simple, monotonic memory arena: allocations get carved out of
+      large blocks, and individual allocations never get freed; all
+      memory is released only when the arena itself dies. Meant for
+      the many small scene graph nodes (instances, objects, meshes)
+      created during loading, where millions of individual heap
+      allocations (and later, frees) would otherwise cost a lot of
+      time and fragment the heap. Allocation is thread-safe. */
+  struct Arena {
+    typedef std::shared_ptr<Arena> SP;
+
+    static SP create(size_t blockSize=4*1024*1024)
+    { return std::make_shared<Arena>(blockSize); }
+
+    Arena(size_t blockSize) : blockSize(blockSize) {}
+    ~Arena();
+
+    /*! allocates given number of bytes with given alignment (which
+        must be a power of two) */
+    void *allocate(size_t numBytes, size_t alignment);
+
+  private:
+    const size_t       blockSize;
+    std::mutex         mutex;
+    std::vector<char*> blocks;
+    char              *current   = nullptr;
+    size_t             remaining = 0;
+  };
+
+  /*! STL-compatible allocator that allocates from an arena; keeps the
+      arena alive for as long as any copy of this allocator (eg, one
+      inside a shared_ptr control block) is alive */
+  template<typename T>
+  struct ArenaAllocator {
+    typedef T value_type;
+
+    ArenaAllocator(const Arena::SP &arena) : arena(arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t N)
+    { return (T*)arena->allocate(N*sizeof(T),alignof(T)); }
+    /*! no-op - memory gets released only with the arena */
+    void deallocate(T *, size_t) {}
+
+    Arena::SP arena;
+  };
+
+  template<typename T, typename U>
+  inline bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b)
+  { return a.arena == b.arena; }
+  template<typename T, typename U>
+  inline bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b)
+  { return a.arena != b.arena; }
+
+  /*! creates a new T (and its shared_ptr control block) in the given
+      arena - the equivalent of std::make_shared<T>(args...) */
+  template<typename T, typename... Args>
+  inline std::shared_ptr<T> makeInArena(const Arena::SP &arena, Args&&... args)
+  { return std::allocate_shared<T>(ArenaAllocator<T>(arena),std::forward<Args>(args)...); }
+
+} // ::mini
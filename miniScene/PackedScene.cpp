@@ -0,0 +1,177 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/PackedScene.h"
+#include "miniScene/Serialized.h"
+#include "miniScene/Memory.h"
+
+namespace mini {
+
+  PackedScene::SP PackedScene::load(const std::string &fileName, Layout layout,
+                                    NumaPlacement numaPlacement,
+                                    const Progress &progress)
+  {
+    LoadOptions options;
+    options.progress = progress;
+    return create(Scene::load(fileName,options),layout,numaPlacement,progress);
+  }
+
+  PackedScene::SP PackedScene::create(Scene::SP scene, Layout layout,
+                                      NumaPlacement numaPlacement,
+                                      const Progress &progress)
+  {
+    memory::ScopedNumaPlacement scopedNumaPlacement(numaPlacement);
+    PackedScene::SP packed = std::make_shared<PackedScene>();
+    packed->layout      = layout;
+    packed->quadLights  = scene->quadLights;
+    packed->dirLights   = scene->dirLights;
+    packed->envMapLight = scene->envMapLight;
+
+    // ------------------------------------------------------------------
+    // first, assign IDs to all unique objects, meshes, and materials
+    // ------------------------------------------------------------------
+    SerializedScene serialized(scene.get());
+    packed->materials = serialized.materials.list;
+
+    // ------------------------------------------------------------------
+    // compute each mesh's offsets into the global arrays; this is a
+    // (cheap) serial prefix sum over the unique meshes
+    // ------------------------------------------------------------------
+    const bool interleaved = (layout == INTERLEAVED);
+    size_t numVertices = 0, numTriangles = 0, numNormals = 0, numTexcoords = 0;
+    packed->meshes.resize(serialized.meshes.size());
+    for (size_t meshID=0;meshID<serialized.meshes.size();meshID++) {
+      const Mesh::SP &mesh = serialized.meshes.list[meshID];
+      MeshRange &range = packed->meshes[meshID];
+      range.vertexOffset = numVertices;
+      range.numVertices  = mesh->vertices.size();
+      numVertices += range.numVertices;
+
+      range.indexOffset  = numTriangles;
+      range.numTriangles = mesh->getNumPrims();
+      numTriangles += range.numTriangles;
+
+      range.numNormals = mesh->getNumNormals();
+      if (interleaved && range.numNormals == range.numVertices)
+        range.normalOffset = range.vertexOffset;
+      else {
+        range.normalOffset = numNormals;
+        numNormals += range.numNormals;
+      }
+
+      range.numTexcoords = mesh->getNumTexcoords();
+      if (interleaved && range.numTexcoords == range.numVertices)
+        range.texcoordOffset = range.vertexOffset;
+      else {
+        range.texcoordOffset = numTexcoords;
+        numTexcoords += range.numTexcoords;
+      }
+
+      range.materialID = serialized.materials.getID(mesh->material);
+    }
+
+    // ------------------------------------------------------------------
+    // allocate the global arrays, then let each mesh copy its own data
+    // in parallel
+    // ------------------------------------------------------------------
+    if (interleaved)
+      memory::resizeBulk(packed->interleaved,numVertices);
+    else
+      memory::resizeBulk(packed->vertices,numVertices);
+    memory::resizeBulk(packed->indices,numTriangles);
+    memory::resizeBulk(packed->normals,numNormals);
+    memory::resizeBulk(packed->texcoords,numTexcoords);
+
+    parallel_for
+      (progress,"packing meshes",serialized.meshes.size(),
+       [&](size_t meshID) {
+         const Mesh &mesh = *serialized.meshes.list[meshID];
+         const MeshRange &range = packed->meshes[meshID];
+         if (mesh.hasCompactIndices())
+           for (size_t i=0;i<range.numTriangles;i++)
+             packed->indices[range.indexOffset+i] = vec3i(mesh.indices16[i]);
+         else
+           std::copy(mesh.indices.begin(),mesh.indices.end(),
+                     packed->indices.begin()+range.indexOffset);
+         if (!interleaved) {
+           std::copy(mesh.vertices.begin(),mesh.vertices.end(),
+                     packed->vertices.begin()+range.vertexOffset);
+           mesh.getNormals(packed->normals.data()+range.normalOffset);
+           mesh.getTexcoords(packed->texcoords.data()+range.texcoordOffset);
+           return;
+         }
+         const bool perVertexNormals   = (range.numNormals   == range.numVertices);
+         const bool perVertexTexcoords = (range.numTexcoords == range.numVertices);
+         Vertex *out = packed->interleaved.data()+range.vertexOffset;
+         for (size_t i=0;i<range.numVertices;i++) {
+           out[i].position = mesh.vertices[i];
+           out[i].normal   = perVertexNormals   ? mesh.getNormal(i)   : vec3f(0.f);
+           out[i].texcoord = perVertexTexcoords ? mesh.getTexcoord(i) : vec2f(0.f);
+         }
+         if (!perVertexNormals)
+           mesh.getNormals(packed->normals.data()+range.normalOffset);
+         if (!perVertexTexcoords)
+           mesh.getTexcoords(packed->texcoords.data()+range.texcoordOffset);
+       });
+
+    // ------------------------------------------------------------------
+    // objects: prefix-sum over the objects' mesh counts, then fill in
+    // mesh IDs in parallel
+    // ------------------------------------------------------------------
+    packed->objects.resize(serialized.objects.size());
+    size_t numObjectMeshes = 0;
+    for (size_t objID=0;objID<serialized.objects.size();objID++) {
+      ObjectRange &range = packed->objects[objID];
+      range.meshOffset = numObjectMeshes;
+      range.numMeshes  = serialized.objects.list[objID]->meshes.size();
+      numObjectMeshes += range.numMeshes;
+    }
+    packed->objectMeshIDs.resize(numObjectMeshes);
+    parallel_for
+      (progress,"packing objects",serialized.objects.size(),
+       [&](size_t objID) {
+         const Object &object = *serialized.objects.list[objID];
+         const ObjectRange &range = packed->objects[objID];
+         for (size_t i=0;i<range.numMeshes;i++)
+           packed->objectMeshIDs[range.meshOffset+i]
+             = serialized.meshes.getID(object.meshes[i]);
+       });
+
+    // ------------------------------------------------------------------
+    // instances
+    // ------------------------------------------------------------------
+    const size_t numInstances = scene->instances.size();
+    packed->instanceXfms.resize(numInstances);
+    packed->instanceObjectIDs.resize(numInstances);
+    parallel_for_blocked
+      (progress,"packing instances",(size_t)0,numInstances,16*1024,
+       [&](size_t begin, size_t end) {
+         for (size_t instID=begin;instID<end;instID++) {
+           const Instance::SP &inst = scene->instances[instID];
+           if (!inst) {
+             packed->instanceXfms[instID] = affine3f();
+             packed->instanceObjectIDs[instID] = -1;
+             continue;
+           }
+           packed->instanceXfms[instID] = inst->xfm;
+           packed->instanceObjectIDs[instID]
+             = serialized.objects.getID(inst->object);
+         }
+       });
+    return packed;
+  }
+
+} // ::mini
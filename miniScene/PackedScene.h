@@ -0,0 +1,149 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/Scene.h"
+
+namespace mini {
+
+  /*! a "flat", renderer-ready version of a mini::Scene, in which all
+      the (unique) meshes' vertex, index, normal, and texcoord arrays
+      are concatenated into one global array each, and all
+      meshes/objects/instances are referenced through integer IDs
+      into those arrays rather than through shared pointers. All
+      arrays in here can be uploaded (or handed to a BVH builder) as
+      a single bulk copy each, with no per-mesh pointer chasing.
+
+      Meshes that get used by multiple objects (or multiple times in
+      the same object) get stored only once. Null meshes in an
+      object, and null instances in the scene, get an ID of -1, so
+      mesh and instance IDs remain the same as in the original
+      scene. */
+  struct PackedScene {
+    typedef std::shared_ptr<PackedScene> SP;
+
+    typedef enum {
+      /*! positions, normals, and texcoords get stored in separate
+          arrays (the default) */
+      PLANAR=0,
+      /*! positions, per-vertex normals, and per-vertex texcoords get
+          stored interleaved in a single array of PackedScene::Vertex
+          structs */
+      INTERLEAVED
+    } Layout;
+
+    /*! a interleaved vertex, as used in the INTERLEAVED layout; 32
+        bytes per vertex. Meshes that don't have normals or texcoords
+        have those set to zero */
+    struct Vertex {
+      vec3f position;
+      vec3f normal;
+      vec2f texcoord;
+    };
+
+    /*! describes where in the global arrays a given mesh's data
+        lives. Note that indices are _mesh-local_ - ie, to get the
+        global vertex ID of a triangle's vertex one has to add that
+        mesh's vertexOffset */
+    struct MeshRange {
+      /*! offset and count (in vertices) into the 'vertices' array
+          (or 'interleaved' array, in the INTERLEAVED layout) */
+      size_t vertexOffset;
+      size_t numVertices;
+      /*! offset and count (in triangles) into the 'indices' array */
+      size_t indexOffset;
+      size_t numTriangles;
+      /*! offset and count into the 'normals' array. numNormals is
+          the same as in the input mesh, so per-vertex and ANARI-style
+          "faceVarying" normals can be told apart just like in
+          mini::Mesh. In the INTERLEAVED layout per-vertex normals
+          live in the 'interleaved' array (at vertexOffset), and only
+          faceVarying ones in 'normals' */
+      size_t normalOffset;
+      size_t numNormals;
+      /*! offset and count into the 'texcoords' array; same
+          conventions as for normals */
+      size_t texcoordOffset;
+      size_t numTexcoords;
+      /*! index into the 'materials' array */
+      int    materialID;
+    };
+
+    /*! describes the (range of) mesh IDs an object is made up of */
+    struct ObjectRange {
+      /*! offset and count into the 'objectMeshIDs' array */
+      size_t meshOffset;
+      size_t numMeshes;
+    };
+
+    /*! builds a packed scene from the given scene, in parallel. The
+        global arrays get placed on NUMA nodes as specified (with
+        NUMA_DEFAULT, as memory::setNumaPlacement() says). Reports its
+        progress to, and can be cancelled through, the given Progress
+        (throwing Cancelled) */
+    static SP create(Scene::SP scene, Layout layout=PLANAR,
+                     NumaPlacement numaPlacement=NUMA_DEFAULT,
+                     const Progress &progress=Progress());
+
+    /*! loads a ".mini" file and packs it; the intermediate
+        mini::Scene gets released before this returns */
+    static SP load(const std::string &fileName, Layout layout=PLANAR,
+                   NumaPlacement numaPlacement=NUMA_DEFAULT,
+                   const Progress &progress=Progress());
+
+    /*! returns a mesh's i'th triangle, with _global_ vertex indices;
+        only valid for scenes with less than 2G unique vertices */
+    inline vec3i getGlobalTriangle(int meshID, size_t triID) const
+    {
+      const MeshRange &mesh = meshes[meshID];
+      return indices[mesh.indexOffset+triID] + vec3i((int)mesh.vertexOffset);
+    }
+
+    Layout layout = PLANAR;
+
+    /*! all positions, in PLANAR layout; empty for INTERLEAVED */
+    std::vector<vec3f>  vertices;
+    /*! all vertices, in INTERLEAVED layout; empty for PLANAR */
+    std::vector<Vertex> interleaved;
+    /*! all normals (see MeshRange for INTERLEAVED layout) */
+    std::vector<vec3f>  normals;
+    /*! all texcoords (see MeshRange for INTERLEAVED layout) */
+    std::vector<vec2f>  texcoords;
+    /*! all triangles, with _mesh-local_ vertex indices */
+    std::vector<vec3i>  indices;
+
+    /*! one entry per unique mesh */
+    std::vector<MeshRange>    meshes;
+    /*! one entry per unique object */
+    std::vector<ObjectRange>  objects;
+    /*! the mesh IDs used by the objects; -1 for null meshes */
+    std::vector<int>          objectMeshIDs;
+    /*! the materials used by the meshes */
+    std::vector<Material::SP> materials;
+
+    /*! transform of each instance */
+    std::vector<affine3f>     instanceXfms;
+    /*! object ID each instance refers to; -1 for null instances */
+    std::vector<int>          instanceObjectIDs;
+
+    /*! the scene's lights; directly copied from the input scene */
+    std::vector<QuadLight>    quadLights;
+    std::vector<DirLight>     dirLights;
+    EnvMapLight::SP           envMapLight;
+  };
+
+} // ::mini
@@ -0,0 +1,59 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Progress.h"
+
+namespace mini {
+
+  ProgressStage::ProgressStage(const Progress &progress,
+                               const std::string &name,
+                               size_t numItems)
+    : progress(progress),
+      name(name),
+      numItems(numItems)
+  {
+    progress.checkCancelled();
+    if (progress.callback)
+      progress.callback(name,numItems ? 0.f : 1.f);
+  }
+
+  void ProgressStage::advance(size_t count)
+  {
+    const size_t after  = (numDone += count);
+    const size_t before = after - count;
+    if (!progress.callback || numItems == 0) return;
+
+    // only report when we crossed another percent
+    const size_t percentBefore = (100*before)/numItems;
+    const size_t percentAfter  = (100*after)/numItems;
+    if (percentAfter == percentBefore) return;
+
+    std::lock_guard<std::mutex> lock(reportMutex);
+    // some other thread may have reported a later state already
+    if (percentAfter <= lastReported) return;
+    lastReported = percentAfter;
+    progress.callback(name,std::min(1.f,after/float(numItems)));
+  }
+
+  ProgressCallback Progress::printToConsole()
+  {
+    return [](const std::string &stage, float fraction) {
+      std::cout << "\r" << stage << " ... " << int(100.f*fraction) << "%"
+                << (fraction >= 1.f ? "\n" : "") << std::flush;
+    };
+  }
+
+} // ::mini
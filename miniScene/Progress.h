@@ -0,0 +1,221 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/common.h"
+#include <atomic>
+#include <functional>
+
+namespace mini {
+
+  /*! thrown by long-running operations that noticed their
+      CancellationToken got cancelled */
+  struct Cancelled : public std::runtime_error {
+    Cancelled() : std::runtime_error("operation cancelled") {}
+  };
+
+  /*! a flag that a host app can set (from any thread) to ask a
+      running operation to stop. Operations check it regularly, and
+      once they see it set, stop what they're doing and throw
+      Cancelled */
+  struct CancellationToken {
+    typedef std::shared_ptr<CancellationToken> SP;
+
+    static SP create() { return std::make_shared<CancellationToken>(); }
+
+    inline void cancel() { cancelled = true; }
+    inline bool isCancelled() const { return cancelled; }
+
+  private:
+    std::atomic<bool> cancelled { false };
+  };
+
+  /*! receives progress reports: the name of the current stage of an
+      operation, and how much of that stage is done (0 to 1). May get
+      called from any thread, but never concurrently */
+  typedef std::function<void(const std::string &stage, float fraction)> ProgressCallback;
+
+  /*! what long-running operations take to let a host app monitor
+      and/or cancel them; both members are optional */
+  struct Progress {
+    /*! if set, the operation stops (and throws Cancelled) once this
+        got cancelled */
+    CancellationToken::SP cancellation;
+    /*! if set, gets told about the operation's progress */
+    ProgressCallback      callback;
+
+    inline bool isCancelled() const
+    { return cancellation && cancellation->isCancelled(); }
+
+    /*! throws Cancelled if cancelled */
+    inline void checkCancelled() const
+    { if (isCancelled()) throw Cancelled(); }
+
+    /*! returns a callback that prints progress to the console, for
+        use in tools */
+    static ProgressCallback printToConsole();
+  };
+
+  /*! tracks the progress of one stage of an operation that consists
+      of 'numItems' work items, which may get completed from
+      different threads; reports to the Progress' callback every time
+      another percent of the items is done */
+  struct ProgressStage {
+    ProgressStage(const Progress &progress,
+                  const std::string &name,
+                  size_t numItems);
+
+    /*! marks another 'numDone' items as done, and reports if needed */
+    void advance(size_t numDone=1);
+
+    const Progress   &progress;
+  private:
+    const std::string name;
+    const size_t      numItems;
+    std::atomic<size_t> numDone { 0 };
+    std::mutex        reportMutex;
+    /*! last percentage we reported; guarded by reportMutex */
+    size_t            lastReported = 0;
+  };
+
+  /*! parallel_for_blocked() that reports its progress (as a stage
+      of the given name), and stops once cancelled: blocks that
+      haven't started yet by then get skipped, and once all running
+      ones are done this throws Cancelled */
+  template<typename TASK_T>
+  void parallel_for_blocked(const Progress &progress,
+                            const std::string &stageName,
+                            size_t begin, size_t end, size_t blockSize,
+                            const TASK_T &taskFunction)
+  {
+    ProgressStage stage(progress,stageName,end-begin);
+    common::parallel_for_blocked
+      (begin,end,blockSize,
+       [&](size_t blockBegin, size_t blockEnd) {
+         if (progress.isCancelled()) return;
+         taskFunction(blockBegin,blockEnd);
+         stage.advance(blockEnd-blockBegin);
+       });
+    progress.checkCancelled();
+  }
+
+  /*! parallel_for() that reports its progress (as a stage of the
+      given name), and stops once cancelled: tasks that haven't
+      started yet by then get skipped, and once all running ones are
+      done this throws Cancelled */
+  template<typename TASK_T>
+  void parallel_for(const Progress &progress,
+                    const std::string &stageName,
+                    size_t numTasks,
+                    const TASK_T &taskFunction)
+  {
+    ProgressStage stage(progress,stageName,numTasks);
+    common::parallel_for
+      (numTasks,
+       [&](size_t taskID) {
+         if (progress.isCancelled()) return;
+         taskFunction(taskID);
+         stage.advance();
+       });
+    progress.checkCancelled();
+  }
+
+  /*! processes the blocks of one pass of parallel_exclusive_scan()
+      or parallel_partition() such that each block advances the
+      given stage, and blocks that haven't started yet once the
+      stage's Progress got cancelled get skipped (and the pass
+      throws Cancelled once the running ones are done) */
+  struct ProgressForEachBlock {
+    template<typename BODY_T>
+    void operator()(size_t numBlocks, const BODY_T &body) const
+    {
+      common::parallel_for
+        (numBlocks,
+         [&](size_t blockID) {
+           if (stage.progress.isCancelled()) return;
+           body(blockID);
+           stage.advance();
+         });
+      stage.progress.checkCancelled();
+    }
+
+    ProgressStage &stage;
+  };
+
+  /*! parallel_sort() that can be cancelled before it starts; since
+      the sort itself can't be interrupted, its progress only gets
+      reported as 0 and 100% */
+  template<typename RandomIt, typename Compare>
+  void parallel_sort(const Progress &progress,
+                     const std::string &stageName,
+                     RandomIt begin, RandomIt end, const Compare &less)
+  {
+    ProgressStage stage(progress,stageName,1);
+    common::parallel_sort(begin,end,less);
+    stage.advance();
+  }
+
+  template<typename RandomIt>
+  void parallel_sort(const Progress &progress,
+                     const std::string &stageName,
+                     RandomIt begin, RandomIt end)
+  {
+    ProgressStage stage(progress,stageName,1);
+    common::parallel_sort(begin,end);
+    stage.advance();
+  }
+
+  /*! parallel_exclusive_scan() that reports its progress (per block,
+      as a stage of the given name), and stops - throwing Cancelled -
+      once cancelled */
+  template<typename T>
+  T parallel_exclusive_scan(const Progress &progress,
+                            const std::string &stageName,
+                            const T *in, T *out, size_t n,
+                            T init=T(0), size_t blockSize=16*1024)
+  {
+    const size_t numBlocks = (n+blockSize-1)/blockSize;
+    ProgressStage stage(progress,stageName,numBlocks > 1 ? 2*numBlocks : 0);
+    return common::parallel_exclusive_scan(in,out,n,init,blockSize,
+                                           ProgressForEachBlock{stage});
+  }
+
+  template<typename T>
+  T parallel_exclusive_scan(const Progress &progress,
+                            const std::string &stageName,
+                            std::vector<T> &values, T init=T(0))
+  {
+    return parallel_exclusive_scan(progress,stageName,
+                                   values.data(),values.data(),values.size(),init);
+  }
+
+  /*! parallel_partition() that reports its progress (per block, as a
+      stage of the given name), and stops - throwing Cancelled, and
+      leaving the range in an unspecified order - once cancelled */
+  template<typename RandomIt, typename Pred>
+  RandomIt parallel_partition(const Progress &progress,
+                              const std::string &stageName,
+                              RandomIt begin, RandomIt end, const Pred &pred,
+                              size_t blockSize=16*1024)
+  {
+    const size_t numBlocks = (size_t(end-begin)+blockSize-1)/blockSize;
+    ProgressStage stage(progress,stageName,numBlocks > 1 ? 3*numBlocks : 0);
+    return common::parallel_partition(begin,end,pred,blockSize,
+                                      ProgressForEachBlock{stage});
+  }
+
+} // ::mini
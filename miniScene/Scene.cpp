@@ -15,21 +15,24 @@
 // ======================================================================== //
 
 #include "miniScene/Scene.h"
+#include "miniScene/FileFormat.h"
 #include "miniScene/Serialized.h"
 #include "miniScene/IO.h"
+#include "miniScene/Memory.h"
+#include "miniScene/Transforms.h"
+#include "miniScene/Codecs.h"
 #include <sstream>
+#include <cstdio>
+#include <unordered_map>
+#include <numeric>
+#include <random>
 
 namespace mini {
 
-  enum { FORMAT_VERSION = 12 };
-  /* VERSION HISTORY
-     12: embree-style materials, with virtual material read/write
-  */
+  using namespace format;
   
-
 #define PARALLELILIZE_GETBOUNDS 1
   
-  const size_t expected_magic = 4321000000ULL+FORMAT_VERSION;
 
   /*! computes the bounding box of a input box undergoing an affine
       transform; e.g., if we have the (object-space) bounds of an
@@ -49,49 +52,20 @@ namespace mini {
   }
 
 
-  typedef enum { INVALID=0,
-    DISNEY,
-    MATTE,
-    PLASTIC,
-    METAL,
-    VELVET,
-    METALLICPAINT,
-    THINGLASS,
-    DIELECTRIC,
-    BLENDER,
-    ANARI_MATERIAL
-  } MaterialTag;
-  
-  MaterialTag materialTagOf(Material::SP mat)
-  {
-    if (mat->as<DisneyMaterial>()) return DISNEY;
-    if (mat->as<BlenderMaterial>()) return BLENDER;
-    if (mat->as<Matte>()) return MATTE;
-    if (mat->as<Metal>()) return METAL;
-    if (mat->as<Velvet>()) return VELVET;
-    if (mat->as<Plastic>()) return PLASTIC;
-    if (mat->as<MetallicPaint>()) return METALLICPAINT;
-    if (mat->as<Dielectric>()) return DIELECTRIC;
-    if (mat->as<ThinGlass>()) return THINGLASS;
-    if (mat->as<ANARIMaterial>()) return ANARI_MATERIAL;
-    
-    throw std::runtime_error("un-supported material type "+mat->toString()+" in Scene::save");
-  }
-  
-  Material::SP createMaterialFromTag(MaterialTag tag)
+  Material::SP format::createMaterialFromTag(MaterialTag tag)
   {
     switch (tag){
-    case DISNEY: return DisneyMaterial::create();
-    case BLENDER: return BlenderMaterial::create();
-    case METAL: return Metal::create();
-    case VELVET: return Velvet::create();
-    case PLASTIC: return Plastic::create();
-    case MATTE: return Matte::create();
-    case DIELECTRIC: return Dielectric::create();
-    case THINGLASS: return ThinGlass::create();
-    case METALLICPAINT: return MetallicPaint::create();
-    case ANARI_MATERIAL: return ANARIMaterial::create();
-    case INVALID:
+    case Material::DISNEY: return DisneyMaterial::create();
+    case Material::BLENDER: return BlenderMaterial::create();
+    case Material::METAL: return Metal::create();
+    case Material::VELVET: return Velvet::create();
+    case Material::PLASTIC: return Plastic::create();
+    case Material::MATTE: return Matte::create();
+    case Material::DIELECTRIC: return Dielectric::create();
+    case Material::THINGLASS: return ThinGlass::create();
+    case Material::METALLICPAINT: return MetallicPaint::create();
+    case Material::ANARI_MATERIAL: return ANARIMaterial::create();
+    case Material::INVALID:
       ;
     }
     throw std::runtime_error("un-supported material tag "+std::to_string((int)tag)+" in Scene::load");
@@ -104,341 +78,221 @@ namespace mini {
     if (it == serialized.end()) return -1;
     return it->second;
   }
-  
-  // ------------------------------------------------------------------
-  void BlenderMaterial::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
-  {
-    io::writeElement(out,this->baseColor);
-    io::writeElement(out,this->roughness);
-    io::writeElement(out,this->metallic);
-    io::writeElement(out,this->specular);
-    io::writeElement(out,this->specularTint);
-    io::writeElement(out,this->transmission);
-    io::writeElement(out,this->transmissionRoughness);
-    io::writeElement(out,this->ior);
-    io::writeElement(out,this->alpha);
-    io::writeElement(out,this->subsurfaceRadius);
-    io::writeElement(out,this->subsurfaceColor);
-    io::writeElement(out,this->subsurface);
-    io::writeElement(out,this->anisotropic);
-    io::writeElement(out,this->anisotropicRotation);
-    io::writeElement(out,this->sheen);
-    io::writeElement(out,this->sheenTint);
-    io::writeElement(out,this->clearcoat);
-    io::writeElement(out,this->clearcoatRoughness);
-    
-    io::writeElement(out,getID(this->baseColorTexture,textures));
-    io::writeElement(out,getID(this->alphaTexture,textures));
-  }
-  
 
-  void BlenderMaterial::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
-  {
-    io::readElement(in,this->baseColor);
-    io::readElement(in,this->roughness);
-    io::readElement(in,this->metallic);
-    io::readElement(in,this->specular);
-    io::readElement(in,this->specularTint);
-    io::readElement(in,this->transmission);
-    io::readElement(in,this->transmissionRoughness);
-    io::readElement(in,this->ior);
-    io::readElement(in,this->alpha);
-    io::readElement(in,this->subsurfaceRadius);
-    io::readElement(in,this->subsurfaceColor);
-    io::readElement(in,this->subsurface);
-    io::readElement(in,this->anisotropic);
-    io::readElement(in,this->anisotropicRotation);
-    io::readElement(in,this->sheen);
-    io::readElement(in,this->sheenTint);
-    io::readElement(in,this->clearcoat);
-    io::readElement(in,this->clearcoatRoughness);
-    {
-      int texID = io::readElement<int>(in);
-      assert(texID >= 0);
-      assert(texID < textures.size());
-      this->baseColorTexture = textures[texID];
-    }
-    {
-      int texID = io::readElement<int>(in);
-      assert(texID >= 0);
-      assert(texID < textures.size());
-      this->alphaTexture = textures[texID];
-    }
-  }
-
-  void writeTexture(const std::map<Texture::SP,int> &textures,
-                    std::ofstream &out,
-                    Texture::SP tex)
-  {
-    int ID = getID(tex,textures);
-    io::writeElement(out,ID);
-  }
-  
   // ------------------------------------------------------------------
-  void ANARIMaterial::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
-  {
-    io::writeElement(out,this->baseColor);
-    writeTexture(textures,out,baseColor_texture);
-    io::writeElement(out,this->opacity);
-    writeTexture(textures,out,opacity_texture);
-    io::writeElement(out,this->metallic);
-    writeTexture(textures,out,metallic_texture);
-    io::writeElement(out,this->roughness);
-    writeTexture(textures,out,roughness_texture);
-    writeTexture(textures,out,normal_texture);
-    io::writeElement(out,this->emissive);
-    writeTexture(textures,out,emissive_texture);
-    writeTexture(textures,out,occlusion_texture);
-    io::writeElement(out,this->alphaMode);
-    io::writeElement(out,this->alphaCutoff);
-    io::writeElement(out,this->specular);
-    writeTexture(textures,out,specular_texture);
-    io::writeElement(out,this->specularColor);
-    writeTexture(textures,out,specularColor_texture);
-    io::writeElement(out,this->clearcoat);
-    writeTexture(textures,out,clearcoat_texture);
-    io::writeElement(out,this->clearcoatRoughness);
-    writeTexture(textures,out,clearcoatRoughness_texture);
-    writeTexture(textures,out,clearcoatNormal_texture);
-    io::writeElement(out,this->transmission);
-    writeTexture(textures,out,transmission_texture);
-    io::writeElement(out,this->ior);
-    writeTexture(textures,out,ior_texture);
-    io::writeElement(out,this->thickness);
-    writeTexture(textures,out,thickness_texture);
-    io::writeElement(out,this->attenuationDistance);
-    io::writeElement(out,this->attenuationColor);
-    writeTexture(textures,out,attenuationColor_texture);
-    io::writeElement(out,this->sheenColor);
-    writeTexture(textures,out,sheenColor_texture);
-    io::writeElement(out,this->sheenRoughness);
-    writeTexture(textures,out,sheenRoughness_texture);
-    io::writeElement(out,this->iridescence);
-    writeTexture(textures,out,iridescence_texture);
-    io::writeElement(out,this->iridescenceIor);
-    writeTexture(textures,out,iridescenceIor_texture);
-    io::writeElement(out,this->iridescenceThickness);
-    writeTexture(textures,out,iridescenceThickness_texture);
-  }
-
-
-  void readTexture(const std::vector<Texture::SP> &textures,
-                   std::ifstream &in,
-                   Texture::SP &tex)
-  {
-    int texID = io::readElement<int>(in);
-    assert(texID >= 0);
-    tex = textures[texID];
-  }
-  
-  void ANARIMaterial::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
-  {
-    io::readElement(in,this->baseColor);
-    io::readElement(in,this->baseColor);
-    readTexture(textures,in,baseColor_texture);
-    io::readElement(in,this->opacity);
-    readTexture(textures,in,opacity_texture);
-    io::readElement(in,this->metallic);
-    readTexture(textures,in,metallic_texture);
-    io::readElement(in,this->roughness);
-    readTexture(textures,in,roughness_texture);
-    readTexture(textures,in,normal_texture);
-    io::readElement(in,this->emissive);
-    readTexture(textures,in,emissive_texture);
-    readTexture(textures,in,occlusion_texture);
-    io::readElement(in,this->alphaMode);
-    io::readElement(in,this->alphaCutoff);
-    io::readElement(in,this->specular);
-    readTexture(textures,in,specular_texture);
-    io::readElement(in,this->specularColor);
-    readTexture(textures,in,specularColor_texture);
-    io::readElement(in,this->clearcoat);
-    readTexture(textures,in,clearcoat_texture);
-    io::readElement(in,this->clearcoatRoughness);
-    readTexture(textures,in,clearcoatRoughness_texture);
-    readTexture(textures,in,clearcoatNormal_texture);
-    io::readElement(in,this->transmission);
-    readTexture(textures,in,transmission_texture);
-    io::readElement(in,this->ior);
-    readTexture(textures,in,ior_texture);
-    io::readElement(in,this->thickness);
-    readTexture(textures,in,thickness_texture);
-    io::readElement(in,this->attenuationDistance);
-    io::readElement(in,this->attenuationColor);
-    readTexture(textures,in,attenuationColor_texture);
-    io::readElement(in,this->sheenColor);
-    readTexture(textures,in,sheenColor_texture);
-    io::readElement(in,this->sheenRoughness);
-    readTexture(textures,in,sheenRoughness_texture);
-    io::readElement(in,this->iridescence);
-    readTexture(textures,in,iridescence_texture);
-    io::readElement(in,this->iridescenceIor);
-    readTexture(textures,in,iridescenceIor_texture);
-    io::readElement(in,this->iridescenceThickness);
-    readTexture(textures,in,iridescenceThickness_texture);
-  };
-
-  // ------------------------------------------------------------------
-  void Plastic::write(std::ofstream &out,
-                      const std::map<Texture::SP,int> &textures)
+  void Material::write(std::ostream &out,
+                       const std::map<Texture::SP,int> &textures)
   {
-    io::writeElement(out,this->Ks);
-    io::writeElement(out,this->eta);
-    io::writeElement(out,this->pigmentColor);
-    io::writeElement(out,this->roughness);
+    const std::vector<MaterialField> &fields = getFields();
+    size_t numBytes = 0;
+    for (auto &field : fields)
+      numBytes += field.fileSize();
+    std::vector<char> bytes(numBytes);
+    char *dst = bytes.data();
+    for (auto &field : fields) {
+      if (field.type == MaterialField::TEXTURE) {
+        const int32_t texID = getID(get<Texture::SP>(field),textures);
+        memcpy(dst,&texID,sizeof(texID));
+      } else
+        memcpy(dst,(const char*)this+field.offset,field.fileSize());
+      dst += field.fileSize();
+    }
+    out.write(bytes.data(),bytes.size());
   }
 
-  void Plastic::read(std::ifstream &in,
-                     const std::vector<Texture::SP> &textures)
+  void Material::read(std::istream &in,
+                      const std::vector<Texture::SP> &textures)
   {
-    io::readElement(in,this->Ks);
-    io::readElement(in,this->eta);
-    io::readElement(in,this->pigmentColor);
-    io::readElement(in,this->roughness);
+    const std::vector<MaterialField> &fields = getFields();
+    size_t numBytes = 0;
+    for (auto &field : fields)
+      numBytes += field.fileSize();
+    std::vector<char> bytes(numBytes);
+    io::readArray(in,bytes.data(),bytes.size());
+    const char *src = bytes.data();
+    for (auto &field : fields) {
+      if (field.type == MaterialField::TEXTURE) {
+        int32_t texID;
+        memcpy(&texID,src,sizeof(texID));
+        if (texID >= (int)textures.size())
+          throw std::runtime_error("invalid texture ID in 'mini' scene file - cannot load");
+        get<Texture::SP>(field) = texID < 0 ? Texture::SP() : textures[texID];
+      } else
+        memcpy((char*)this+field.offset,src,field.fileSize());
+      src += field.fileSize();
+    }
   }
   
   // ------------------------------------------------------------------
-  void Matte::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
+  const std::vector<MaterialField> &BlenderMaterial::getFields() const
   {
-    io::writeElement(out,this->reflectance);
-  }
-
-  void Matte::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
-  {
-    io::readElement(in,this->reflectance);
+    static const std::vector<MaterialField> fields = {
+      materialField("baseColor",&BlenderMaterial::baseColor),
+      materialField("roughness",&BlenderMaterial::roughness),
+      materialField("metallic",&BlenderMaterial::metallic),
+      materialField("specular",&BlenderMaterial::specular),
+      materialField("specularTint",&BlenderMaterial::specularTint),
+      materialField("transmission",&BlenderMaterial::transmission),
+      materialField("transmissionRoughness",&BlenderMaterial::transmissionRoughness),
+      materialField("ior",&BlenderMaterial::ior),
+      materialField("alpha",&BlenderMaterial::alpha),
+      materialField("subsurfaceRadius",&BlenderMaterial::subsurfaceRadius),
+      materialField("subsurfaceColor",&BlenderMaterial::subsurfaceColor),
+      materialField("subsurface",&BlenderMaterial::subsurface),
+      materialField("anisotropic",&BlenderMaterial::anisotropic),
+      materialField("anisotropicRotation",&BlenderMaterial::anisotropicRotation),
+      materialField("sheen",&BlenderMaterial::sheen),
+      materialField("sheenTint",&BlenderMaterial::sheenTint),
+      materialField("clearcoat",&BlenderMaterial::clearcoat),
+      materialField("clearcoatRoughness",&BlenderMaterial::clearcoatRoughness),
+      materialField("baseColorTexture",&BlenderMaterial::baseColorTexture),
+      materialField("alphaTexture",&BlenderMaterial::alphaTexture)
+    };
+    return fields;
   }
   
   // ------------------------------------------------------------------
-  void MetallicPaint::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
+  const std::vector<MaterialField> &ANARIMaterial::getFields() const
   {
-    io::writeElement(out,this->glitterColor);
-    io::writeElement(out,this->glitterSpread);
-    io::writeElement(out,this->shadeColor);
-    io::writeElement(out,this->eta);
+    static const std::vector<MaterialField> fields = {
+      materialField("baseColor",&ANARIMaterial::baseColor),
+      materialField("baseColor_texture",&ANARIMaterial::baseColor_texture),
+      materialField("opacity",&ANARIMaterial::opacity),
+      materialField("opacity_texture",&ANARIMaterial::opacity_texture),
+      materialField("metallic",&ANARIMaterial::metallic),
+      materialField("metallic_texture",&ANARIMaterial::metallic_texture),
+      materialField("roughness",&ANARIMaterial::roughness),
+      materialField("roughness_texture",&ANARIMaterial::roughness_texture),
+      materialField("normal_texture",&ANARIMaterial::normal_texture),
+      materialField("emissive",&ANARIMaterial::emissive),
+      materialField("emissive_texture",&ANARIMaterial::emissive_texture),
+      materialField("occlusion_texture",&ANARIMaterial::occlusion_texture),
+      materialField("alphaMode",&ANARIMaterial::alphaMode),
+      materialField("alphaCutoff",&ANARIMaterial::alphaCutoff),
+      materialField("specular",&ANARIMaterial::specular),
+      materialField("specular_texture",&ANARIMaterial::specular_texture),
+      materialField("specularColor",&ANARIMaterial::specularColor),
+      materialField("specularColor_texture",&ANARIMaterial::specularColor_texture),
+      materialField("clearcoat",&ANARIMaterial::clearcoat),
+      materialField("clearcoat_texture",&ANARIMaterial::clearcoat_texture),
+      materialField("clearcoatRoughness",&ANARIMaterial::clearcoatRoughness),
+      materialField("clearcoatRoughness_texture",&ANARIMaterial::clearcoatRoughness_texture),
+      materialField("clearcoatNormal_texture",&ANARIMaterial::clearcoatNormal_texture),
+      materialField("transmission",&ANARIMaterial::transmission),
+      materialField("transmission_texture",&ANARIMaterial::transmission_texture),
+      materialField("ior",&ANARIMaterial::ior),
+      materialField("ior_texture",&ANARIMaterial::ior_texture),
+      materialField("thickness",&ANARIMaterial::thickness),
+      materialField("thickness_texture",&ANARIMaterial::thickness_texture),
+      materialField("attenuationDistance",&ANARIMaterial::attenuationDistance),
+      materialField("attenuationColor",&ANARIMaterial::attenuationColor),
+      materialField("attenuationColor_texture",&ANARIMaterial::attenuationColor_texture),
+      materialField("sheenColor",&ANARIMaterial::sheenColor),
+      materialField("sheenColor_texture",&ANARIMaterial::sheenColor_texture),
+      materialField("sheenRoughness",&ANARIMaterial::sheenRoughness),
+      materialField("sheenRoughness_texture",&ANARIMaterial::sheenRoughness_texture),
+      materialField("iridescence",&ANARIMaterial::iridescence),
+      materialField("iridescence_texture",&ANARIMaterial::iridescence_texture),
+      materialField("iridescenceIor",&ANARIMaterial::iridescenceIor),
+      materialField("iridescenceIor_texture",&ANARIMaterial::iridescenceIor_texture),
+      materialField("iridescenceThickness",&ANARIMaterial::iridescenceThickness),
+      materialField("iridescenceThickness_texture",&ANARIMaterial::iridescenceThickness_texture)
+    };
+    return fields;
   }
 
-  void MetallicPaint::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
+  // ------------------------------------------------------------------
+  const std::vector<MaterialField> &Plastic::getFields() const
   {
-    io::readElement(in,this->glitterColor);
-    io::readElement(in,this->glitterSpread);
-    io::readElement(in,this->shadeColor);
-    io::readElement(in,this->eta);
+    static const std::vector<MaterialField> fields = {
+      materialField("Ks",&Plastic::Ks),
+      materialField("eta",&Plastic::eta),
+      materialField("pigmentColor",&Plastic::pigmentColor),
+      materialField("roughness",&Plastic::roughness)
+    };
+    return fields;
   }
   
   // ------------------------------------------------------------------
-  void ThinGlass::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
+  const std::vector<MaterialField> &Matte::getFields() const
   {
-    io::writeElement(out,this->eta);
-    io::writeElement(out,this->thickness);
-    io::writeElement(out,this->transmission);
-  }
-
-  void ThinGlass::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
-  {
-    io::readElement(in,this->eta);
-    io::readElement(in,this->thickness);
-    io::readElement(in,this->transmission);
+    static const std::vector<MaterialField> fields = {
+      materialField("reflectance",&Matte::reflectance)
+    };
+    return fields;
   }
   
   // ------------------------------------------------------------------
-  void Dielectric::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
-  {
-    io::writeElement(out,this->etaInside);
-    io::writeElement(out,this->etaOutside);
-    io::writeElement(out,this->transmission);
-  }
-
-  void Dielectric::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
+  const std::vector<MaterialField> &MetallicPaint::getFields() const
   {
-    io::readElement(in,this->etaInside);
-    io::readElement(in,this->etaOutside);
-    io::readElement(in,this->transmission);
+    static const std::vector<MaterialField> fields = {
+      materialField("glitterColor",&MetallicPaint::glitterColor),
+      materialField("glitterSpread",&MetallicPaint::glitterSpread),
+      materialField("shadeColor",&MetallicPaint::shadeColor),
+      materialField("eta",&MetallicPaint::eta)
+    };
+    return fields;
   }
   
   // ------------------------------------------------------------------
-  void Metal::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
+  const std::vector<MaterialField> &ThinGlass::getFields() const
   {
-    io::writeElement(out,this->eta);
-    io::writeElement(out,this->k);
-    io::writeElement(out,this->roughness);
-  }
-
-  void Metal::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
-  {
-    io::readElement(in,this->eta);
-    io::readElement(in,this->k);
-    io::readElement(in,this->roughness);
+    static const std::vector<MaterialField> fields = {
+      materialField("eta",&ThinGlass::eta),
+      materialField("thickness",&ThinGlass::thickness),
+      materialField("transmission",&ThinGlass::transmission)
+    };
+    return fields;
   }
   
   // ------------------------------------------------------------------
-  void Velvet::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
+  const std::vector<MaterialField> &Dielectric::getFields() const
   {
-    io::writeElement(out,this->reflectance);
-    io::writeElement(out,this->horizonScatteringColor);
-    io::writeElement(out,this->horizonScatteringFallOff);
-    io::writeElement(out,this->backScattering);
+    static const std::vector<MaterialField> fields = {
+      materialField("etaInside",&Dielectric::etaInside),
+      materialField("etaOutside",&Dielectric::etaOutside),
+      materialField("transmission",&Dielectric::transmission)
+    };
+    return fields;
   }
-
-  void Velvet::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
+  
+  // ------------------------------------------------------------------
+  const std::vector<MaterialField> &Metal::getFields() const
   {
-    io::readElement(in,this->reflectance);
-    io::readElement(in,this->horizonScatteringColor);
-    io::readElement(in,this->horizonScatteringFallOff);
-    io::readElement(in,this->backScattering);
+    static const std::vector<MaterialField> fields = {
+      materialField("eta",&Metal::eta),
+      materialField("k",&Metal::k),
+      materialField("roughness",&Metal::roughness)
+    };
+    return fields;
   }
   
   // ------------------------------------------------------------------
-  void DisneyMaterial::write(std::ofstream &out,
-                             const std::map<Texture::SP,int> &textures)
+  const std::vector<MaterialField> &Velvet::getFields() const
   {
-    io::writeElement(out,this->emission);
-    io::writeElement(out,this->baseColor);
-    io::writeElement(out,this->metallic);
-    io::writeElement(out,this->roughness);
-    io::writeElement(out,this->transmission);
-    io::writeElement(out,this->ior);
-
-    io::writeElement(out,getID(this->colorTexture,textures));
-    io::writeElement(out,getID(this->alphaTexture,textures));
+    static const std::vector<MaterialField> fields = {
+      materialField("reflectance",&Velvet::reflectance),
+      materialField("horizonScatteringColor",&Velvet::horizonScatteringColor),
+      materialField("horizonScatteringFallOff",&Velvet::horizonScatteringFallOff),
+      materialField("backScattering",&Velvet::backScattering)
+    };
+    return fields;
   }
-
-  void DisneyMaterial::read(std::ifstream &in,
-                            const std::vector<Texture::SP> &textures)
+  
+  // ------------------------------------------------------------------
+  const std::vector<MaterialField> &DisneyMaterial::getFields() const
   {
-    io::readElement(in,this->emission);
-    io::readElement(in,this->baseColor);
-    io::readElement(in,this->metallic);
-    io::readElement(in,this->roughness);
-    io::readElement(in,this->transmission);
-    io::readElement(in,this->ior);
-    {
-      int texID = io::readElement<int>(in);
-      assert(texID >= 0);
-      assert(texID < textures.size());
-      this->colorTexture = textures[texID];
-    }
-    {
-      int texID = io::readElement<int>(in);
-      assert(texID >= 0);
-      assert(texID < textures.size());
-      this->alphaTexture = textures[texID];
-    }
+    static const std::vector<MaterialField> fields = {
+      materialField("emission",&DisneyMaterial::emission),
+      materialField("baseColor",&DisneyMaterial::baseColor),
+      materialField("metallic",&DisneyMaterial::metallic),
+      materialField("roughness",&DisneyMaterial::roughness),
+      materialField("transmission",&DisneyMaterial::transmission),
+      materialField("ior",&DisneyMaterial::ior),
+      materialField("colorTexture",&DisneyMaterial::colorTexture),
+      materialField("alphaTexture",&DisneyMaterial::alphaTexture)
+    };
+    return fields;
   }
 
   
@@ -470,6 +324,88 @@ namespace mini {
         bounds.extend(vtx);
     return bounds;
   }
+
+  bool Mesh::compactIndices()
+  {
+    if (hasCompactIndices()) return true;
+    if (indices.empty() || !canUseCompactIndices()) return false;
+    std::vector<vec3us> compact(indices.size());
+    for (size_t i=0;i<compact.size();i++)
+      compact[i] = vec3us(getIndex(i));
+    indices16 = std::move(compact);
+    indices.clear();
+    return true;
+  }
+
+  void Mesh::expandIndices()
+  {
+    if (!hasCompactIndices()) return;
+    std::vector<vec3i> expanded(indices16.size());
+    for (size_t i=0;i<expanded.size();i++)
+      expanded[i] = getIndex(i);
+    indices = std::move(expanded);
+    indices16.clear();
+  }
+
+  void Mesh::getNormals(vec3f *out) const
+  {
+    if (normalsOct.empty())
+      std::copy(normals.begin(),normals.end(),out);
+    else
+      vertex_formats::decodeOctNormals(normalsOct.data(),out,normalsOct.size());
+  }
+  
+  void Mesh::getTexcoords(vec2f *out) const
+  {
+    if (texcoords16.empty())
+      std::copy(texcoords.begin(),texcoords.end(),out);
+    else
+      vertex_formats::decodeTexcoords(texcoords16.data(),out,texcoords16.size(),
+                                      texcoords16Format);
+  }
+  
+  void Mesh::compactAttributes()
+  {
+    if (!normals.empty()) {
+      std::vector<uint32_t> compact(normals.size());
+      vertex_formats::encodeOctNormals(normals.data(),compact.data(),compact.size());
+      normalsOct = std::move(compact);
+      normals.clear();
+    }
+    if (!texcoords.empty()) {
+      bool allInUnitRange = true;
+      for (auto tc : texcoords)
+        if (!(tc.x >= 0.f && tc.x <= 1.f && tc.y >= 0.f && tc.y <= 1.f)) {
+          allInUnitRange = false;
+          break;
+        }
+      texcoords16Format
+        = allInUnitRange
+        ? vertex_formats::TEXCOORDS_UNORM16
+        : vertex_formats::TEXCOORDS_HALF;
+      std::vector<vec2us> compact(texcoords.size());
+      vertex_formats::encodeTexcoords(texcoords.data(),compact.data(),
+                                      compact.size(),texcoords16Format);
+      texcoords16 = std::move(compact);
+      texcoords.clear();
+    }
+  }
+  
+  void Mesh::expandAttributes()
+  {
+    if (!normalsOct.empty()) {
+      std::vector<vec3f> expanded(normalsOct.size());
+      getNormals(expanded.data());
+      normals = std::move(expanded);
+      normalsOct.clear();
+    }
+    if (!texcoords16.empty()) {
+      std::vector<vec2f> expanded(texcoords16.size());
+      getTexcoords(expanded.data());
+      texcoords = std::move(expanded);
+      texcoords16.clear();
+    }
+  }
     
   box3f Object::getBounds() const
   {
@@ -488,7 +424,7 @@ namespace mini {
          });
     } else
 #endif
-    for (auto mesh : meshes)
+    for (const auto &mesh : meshes)
       bounds.extend(mesh->getBounds());
     return bounds;
   }
@@ -500,124 +436,571 @@ namespace mini {
     return transformedBoxBounds(xfm,box);
   }
   
-  box3f Scene::getBounds() const
+  const uint32_t InstanceArrays::INVALID_ID;
+
+  void InstanceArrays::compact(float maxQuantizationError)
   {
-    box3f bounds;
-#if PARALLELILIZE_GETBOUNDS
-    std::map<Object::SP,box3f> objectBounds;
-    
-    // ------------------------------------------------------------------
-    // first, make a list of all the objects being used in the scene
-    // ------------------------------------------------------------------
-    std::mutex mutex;
+    if (isCompact()) return;
+    compactXfms = CompactTransforms::encode(xfms,maxQuantizationError);
+    std::vector<affine3f>().swap(xfms);
+  }
+
+  void InstanceArrays::expand()
+  {
+    if (!isCompact()) return;
+    xfms = compactXfms.decodeAll();
+    compactXfms = CompactTransforms();
+  }
+  
+  InstanceArrays Scene::getInstanceArrays() const
+  {
+    return getInstanceArrays(Progress());
+  }
+  
+  InstanceArrays Scene::getInstanceArrays(const Progress &progress) const
+  {
+    InstanceArrays arrays;
+    const size_t numInstances = instances.size();
+    arrays.xfms.resize(numInstances);
+    arrays.objectIDs.resize(numInstances);
+
+    // assigning (deterministic) object IDs has to be serial; looking
+    // them up by raw pointer at least avoids any refcount traffic
+    std::unordered_map<const Object *,uint32_t> objectIDs;
+    ProgressStage stage(progress,"assigning object IDs",numInstances);
+    const size_t blockSize = 16*1024;
+    for (size_t begin=0;begin<numInstances;begin+=blockSize) {
+      progress.checkCancelled();
+      const size_t end = std::min(begin+blockSize,numInstances);
+      for (size_t instID=begin;instID<end;instID++) {
+        const Instance::SP &inst = instances[instID];
+        if (!inst || !inst->object) {
+          arrays.objectIDs[instID] = InstanceArrays::INVALID_ID;
+          continue;
+        }
+        auto it = objectIDs.find(inst->object.get());
+        if (it != objectIDs.end()) {
+          arrays.objectIDs[instID] = it->second;
+          continue;
+        }
+        uint32_t objectID = (uint32_t)arrays.objects.size();
+        objectIDs[inst->object.get()] = objectID;
+        arrays.objects.push_back(inst->object);
+        arrays.objectIDs[instID] = objectID;
+      }
+      stage.advance(end-begin);
+    }
+
     parallel_for_blocked
-      ((size_t)0,instances.size(),1024,
+      (progress,"gathering instance transforms",(size_t)0,numInstances,16*1024,
        [&](size_t begin, size_t end) {
-         std::set<Object::SP> blockObjects;
-         box3f blockBox;
-         for (size_t i=begin;i<end;i++)
-           blockObjects.insert(instances[i]->object);
-         std::lock_guard<std::mutex> lock(mutex);
-         for (auto obj : blockObjects)
-           objectBounds[obj] = box3f();
+         for (size_t instID=begin;instID<end;instID++) {
+           const Instance::SP &inst = instances[instID];
+           arrays.xfms[instID] = inst ? inst->xfm : affine3f();
+         }
        });
-    
+    return arrays;
+  }
+
+  void Scene::setInstances(const InstanceArrays &arrays)
+  {
+    instances.clear();
+    instances.resize(arrays.size());
+    Arena::SP arena = Arena::create();
+    parallel_for_blocked
+      ((size_t)0,arrays.size(),16*1024,
+       [&](size_t begin, size_t end) {
+         for (size_t instID=begin;instID<end;instID++) {
+           uint32_t objectID = arrays.objectIDs[instID];
+           if (objectID == InstanceArrays::INVALID_ID) continue;
+           instances[instID] = makeInArena<Instance>(arena,
+                                                     arrays.objects[objectID],
+                                                     arrays.getXfm(instID));
+         }
+       });
+  }
+  
+  box3f Scene::getBounds() const
+  {
+    return getBounds(Progress());
+  }
+
+  box3f Scene::getBounds(const Progress &progress) const
+  {
+    box3f bounds;
+#if PARALLELILIZE_GETBOUNDS
     // ------------------------------------------------------------------
-    // second, make a linear list of all objects, so we can do them in
-    // parallel
+    // first, get the instances in SoA form, which also gives us a
+    // dense list of all unique objects
     // ------------------------------------------------------------------
-    std::vector<Object::SP> uniqueObjects;
-    uniqueObjects.reserve(objectBounds.size());
-    for (auto it : objectBounds)
-      uniqueObjects.push_back(it.first);
+    const InstanceArrays arrays = getInstanceArrays(progress);
     
     // ------------------------------------------------------------------
-    // third, compute all the object bounds
+    // second, compute all the object bounds
     // ------------------------------------------------------------------
-    parallel_for
-      (uniqueObjects.size(),
-       [&](size_t objID) {
-         auto obj = uniqueObjects[objID];
-         // this parallel access is fine because no new node
-         // will ever get created in the map; they all
-         // already exist, we just find() them here.
-         objectBounds[obj] = obj->getBounds();
+    std::vector<box3f> objectBounds(arrays.objects.size());
+    parallel_for_blocked
+      (progress,"computing object bounds",
+       (size_t)0,objectBounds.size(),1,
+       [&](size_t begin, size_t end) {
+         for (size_t objID=begin;objID<end;objID++)
+           objectBounds[objID] = arrays.objects[objID]->getBounds();
        });
     
     // ------------------------------------------------------------------
-    // last, do all the instances in parallel
+    // last, stream over all the instances in parallel
     // ------------------------------------------------------------------
+    std::mutex mutex;
     parallel_for_blocked
-      ((size_t)0,instances.size(),1024,
+      (progress,"computing instance bounds",
+       (size_t)0,arrays.size(),1024,
        [&](size_t begin, size_t end) {
          box3f blockBox;
          for (size_t i=begin;i<end;i++) {
-           auto inst = instances[i];
-           box3f objBounds = objectBounds[inst->object];
-           blockBox.extend(transformedBoxBounds(inst->xfm,objBounds));
+           const uint32_t objID = arrays.objectIDs[i];
+           if (objID == InstanceArrays::INVALID_ID) continue;
+           const box3f &objBounds = objectBounds[objID];
+           if (objBounds.empty()) continue;
+           blockBox.extend(transformedBoxBounds(arrays.getXfm(i),objBounds));
          }
          std::lock_guard<std::mutex> lock(mutex);
          bounds.extend(blockBox);
        });
 #else
-    for (auto inst : instances)
+    ProgressStage stage(progress,"computing instance bounds",instances.size());
+    for (auto inst : instances) {
+      progress.checkCancelled();
       bounds.extend(inst->getBounds());
+      stage.advance();
+    }
 #endif
     return bounds;
   }
     
     
-  void Scene::save(const std::string &baseName)
+  void format::writeTexture(std::ostream &out, const Texture &tex)
   {
-    std::ofstream out(baseName,std::ios::binary);
-    if (!out.good())
-      throw std::runtime_error("could not open file '"+baseName+"'");
-    SerializedScene serialized(this);
-      
-    io::writeElement(out,expected_magic);
+    io::writeElement(out,tex.size);
+    io::writeElement(out,tex.format);
+    io::writeElement(out,tex.filterMode);
+    io::writeVector(out,tex.data);
+  }
+
+  void format::readTexture(std::istream &in, Texture &tex)
+  {
+    io::readElement(in,tex.size);
+    io::readElement(in,tex.format);
+    io::readElement(in,tex.filterMode);
+    io::readVector(in,tex.data);
+  }
+
+  void CompressionStats::add(const std::string &kind,
+                             size_t rawBytes, size_t storedBytes,
+                             bool compressed)
+  {
+    Array &array = arrays[kind];
+    array.numArrays++;
+    array.numCompressed += compressed;
+    array.rawBytes      += rawBytes;
+    array.storedBytes   += storedBytes;
+  }
+
+  void CompressionStats::add(const CompressionStats &other)
+  {
+    for (auto &it : other.arrays) {
+      Array &array = arrays[it.first];
+      array.numArrays     += it.second.numArrays;
+      array.numCompressed += it.second.numCompressed;
+      array.rawBytes      += it.second.rawBytes;
+      array.storedBytes   += it.second.storedBytes;
+    }
+  }
+
+  /*! writes an array of vec3fs or vec2fs - under
+      FEATURE_COMPRESSED_FLOATS preceded by its FloatEncoding, and
+      compressed if asked for and if that makes it smaller */
+  template<typename Array>
+  void writeFloatArray(std::ostream &out, const Array &array,
+                       const char *kind,
+                       uint64_t features, const SaveOptions &options)
+  {
+    if (!(features & FEATURE_COMPRESSED_FLOATS)) {
+      io::writeVector(out,array);
+      return;
+    }
+    const int numComponents = sizeof(array[0])/sizeof(float);
+    const size_t rawBytes = array.size()*sizeof(array[0]);
+    if (options.compressFloats && !array.empty()) {
+      codecs::CompressedFloats compressed
+        = codecs::CompressedFloats::encode((const float *)array.data(),
+                                           array.size(),numComponents);
+      if (compressed.sizeInBytes() < rawBytes) {
+        io::writeElement(out,int(FLOATS_COMPRESSED));
+        io::writeElement(out,compressed.numComponents);
+        io::writeElement(out,compressed.numElements);
+        io::writeVector(out,compressed.chunkOffsets);
+        io::writeVector(out,compressed.bytes);
+        if (options.compressionStats)
+          options.compressionStats->add(kind,rawBytes,compressed.sizeInBytes(),true);
+        return;
+      }
+    }
+    io::writeElement(out,int(FLOATS_RAW));
+    io::writeVector(out,array);
+    if (options.compressionStats && options.compressFloats)
+      options.compressionStats->add(kind,rawBytes,rawBytes,false);
+  }
+
+  /*! writes a mesh's positions, normals, and texcoords in the
+      FEATURE_QUANTIZED_GEOMETRY layout */
+  void writeQuantizedGeometry(std::ostream &out, const Mesh &mesh,
+                              uint64_t features, const SaveOptions &options)
+  {
+    using namespace vertex_formats;
+
+    // positions: the fewest bits that meet the error bound, if any
+    int bits = 0;
+    PositionQuantization quantization;
+    if (options.positionQuantizationError >= 0.f && !mesh.vertices.empty()) {
+      const box3f bounds = mesh.getBounds();
+      for (int candidate : { 16, 21 }) {
+        quantization = makePositionQuantization(bounds,candidate);
+        if (maxQuantizationError(quantization) <= options.positionQuantizationError) {
+          bits = candidate;
+          break;
+        }
+      }
+    }
+    io::writeElement(out,bits);
+    if (bits == 16) {
+      std::vector<vec3us> quantized(mesh.vertices.size());
+      encodePositions16(mesh.vertices.data(),quantized.data(),quantized.size(),quantization);
+      io::writeElement(out,quantization.origin);
+      io::writeElement(out,quantization.scale);
+      io::writeVector(out,quantized);
+    } else if (bits == 21) {
+      std::vector<uint64_t> quantized(mesh.vertices.size());
+      encodePositions21(mesh.vertices.data(),quantized.data(),quantized.size(),quantization);
+      io::writeElement(out,quantization.origin);
+      io::writeElement(out,quantization.scale);
+      io::writeVector(out,quantized);
+    } else
+      writeFloatArray(out,mesh.vertices,"vertices",features,options);
+
+    // normals and texcoords: compact ones get written as they are;
+    // others get compacted only if asked to
+    if (!mesh.normalsOct.empty()) {
+      io::writeElement(out,int(ATTRIBUTES_COMPACT));
+      io::writeVector(out,mesh.normalsOct);
+    } else if (options.quantizeAttributes && !mesh.normals.empty()) {
+      std::vector<uint32_t> normalsOct(mesh.normals.size());
+      encodeOctNormals(mesh.normals.data(),normalsOct.data(),normalsOct.size());
+      io::writeElement(out,int(ATTRIBUTES_COMPACT));
+      io::writeVector(out,normalsOct);
+    } else {
+      io::writeElement(out,int(ATTRIBUTES_RAW));
+      writeFloatArray(out,mesh.normals,"normals",features,options);
+    }
+    
+    if (!mesh.texcoords16.empty()) {
+      io::writeElement(out,int(ATTRIBUTES_COMPACT));
+      io::writeElement(out,int(mesh.texcoords16Format));
+      io::writeVector(out,mesh.texcoords16);
+    } else if (options.quantizeAttributes && !mesh.texcoords.empty()) {
+      // same choice of format as Mesh::compactAttributes() makes
+      Mesh compact;
+      compact.texcoords = mesh.texcoords;
+      compact.compactAttributes();
+      io::writeElement(out,int(ATTRIBUTES_COMPACT));
+      io::writeElement(out,int(compact.texcoords16Format));
+      io::writeVector(out,compact.texcoords16);
+    } else {
+      io::writeElement(out,int(ATTRIBUTES_RAW));
+      writeFloatArray(out,mesh.texcoords,"texcoords",features,options);
+    }
+  }
+
+  /*! writes a mesh's indices as whichever IndexEncoding the
+      features and options allow, and that takes the least space */
+  void writeIndices(std::ostream &out, const Mesh &mesh,
+                    uint64_t features, const SaveOptions &options)
+  {
+    // meshes with 16-bit indices in memory that get stored as 32-bit
+    // ones (or compressed) first get widened
+    std::vector<vec3i> widened;
+    if (mesh.hasCompactIndices()) {
+      widened.resize(mesh.indices16.size());
+      for (size_t i=0;i<widened.size();i++)
+        widened[i] = mesh.getIndex(i);
+    }
+    const std::vector<vec3i> &indices
+      = mesh.hasCompactIndices() ? widened : mesh.indices.get();
+    
+    if (!(features & (FEATURE_INDEX16|FEATURE_COMPRESSED_INDICES))) {
+      io::writeVector(out,indices);
+      return;
+    }
+
+    const bool use16
+      = (features & FEATURE_INDEX16)
+      && options.compactIndices
+      && (mesh.hasCompactIndices() || mesh.canUseCompactIndices());
+    if (options.compressIndices && (features & FEATURE_COMPRESSED_INDICES)) {
+      const size_t numTriangles = mesh.getNumPrims();
+      codecs::CompressedIndices compressed
+        = codecs::CompressedIndices::encode(indices.data(),numTriangles);
+      const size_t rawSize = numTriangles*(use16 ? sizeof(vec3us) : sizeof(vec3i));
+      const bool useCompressed = compressed.sizeInBytes() < rawSize;
+      if (options.compressionStats)
+        options.compressionStats->add("indices",rawSize,
+                                      useCompressed ? compressed.sizeInBytes() : rawSize,
+                                      useCompressed);
+      if (useCompressed) {
+        io::writeElement(out,int(INDICES_COMPRESSED));
+        io::writeElement(out,compressed.numTriangles);
+        io::writeVector(out,compressed.blockBases);
+        io::writeVector(out,compressed.blockOffsets);
+        io::writeVector(out,compressed.bytes);
+        return;
+      }
+    }
+
+    if (!use16) {
+      io::writeElement(out,int(INDICES_VEC3I));
+      io::writeVector(out,indices);
+    } else if (mesh.hasCompactIndices()) {
+      io::writeElement(out,int(INDICES_VEC3US));
+      io::writeVector(out,mesh.indices16);
+    } else {
+      std::vector<vec3us> indices16(mesh.indices.size());
+      for (size_t i=0;i<indices16.size();i++)
+        indices16[i] = vec3us(mesh.indices[i]);
+      io::writeElement(out,int(INDICES_VEC3US));
+      io::writeVector(out,indices16);
+    }
+  }
+
+  void format::writeMesh(std::ostream &out, const Mesh &mesh, int matID,
+                         uint64_t features, const SaveOptions &options)
+  {
+    writeIndices(out,mesh,features,options);
+    if (features & FEATURE_QUANTIZED_GEOMETRY) {
+      writeQuantizedGeometry(out,mesh,features,options);
+      io::writeElement(out,matID);
+      return;
+    }
+    writeFloatArray(out,mesh.vertices,"vertices",features,options);
+    if (mesh.hasCompactAttributes()) {
+      // the file always stores full-precision attributes
+      std::vector<vec3f> normals(mesh.getNumNormals());
+      std::vector<vec2f> texcoords(mesh.getNumTexcoords());
+      mesh.getNormals(normals.data());
+      mesh.getTexcoords(texcoords.data());
+      writeFloatArray(out,normals,"normals",features,options);
+      writeFloatArray(out,texcoords,"texcoords",features,options);
+    } else {
+      writeFloatArray(out,mesh.normals,"normals",features,options);
+      writeFloatArray(out,mesh.texcoords,"texcoords",features,options);
+    }
+    io::writeElement(out,matID);
+  }
+
+  /*! (roughly) how many bytes given mesh takes up in a file */
+  size_t estimatedFileSize(const Mesh &mesh)
+  {
+    return mesh.indices.size()*sizeof(vec3i)
+      + mesh.indices16.size()*sizeof(vec3us)
+      + mesh.vertices.size()*sizeof(vec3f)
+      + mesh.normals.size()*sizeof(vec3f)
+      + mesh.normalsOct.size()*sizeof(uint32_t)
+      + mesh.texcoords.size()*sizeof(vec2f)
+      + mesh.texcoords16.size()*sizeof(vec2us);
+  }
+
+  /*! assigns items with given sizes to 'numStripes' stripes, such
+      that all stripes get about the same number of bytes: biggest
+      items first, each one to the stripe with the fewest bytes so
+      far. Returns the stripe ID of every item */
+  std::vector<int> assignStripes(const std::vector<size_t> &sizes,
+                                 int numStripes)
+  {
+    std::vector<size_t> order(sizes.size());
+    std::iota(order.begin(),order.end(),size_t(0));
+    std::stable_sort(order.begin(),order.end(),
+                     [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+    // (bytes so far, and ID, of every stripe; least-loaded on top)
+    typedef std::pair<size_t,int> StripeLoad;
+    std::priority_queue<StripeLoad,std::vector<StripeLoad>,std::greater<StripeLoad>> stripes;
+    for (int stripeID=0;stripeID<numStripes;stripeID++)
+      stripes.push({0,stripeID});
+    std::vector<int> stripeIDs(sizes.size());
+    for (size_t itemID : order) {
+      StripeLoad least = stripes.top();
+      stripes.pop();
+      stripeIDs[itemID] = least.second;
+      least.first += sizes[itemID];
+      stripes.push(least);
+    }
+    return stripeIDs;
+  }
+
+  /*! Scene::save(), for a file with given name (if saved to one) -
+      which striped scenes need, for naming their stripes */
+  void saveScene(Scene *scene,
+                 std::ostream &fileOut,
+                 const SaveOptions &options,
+                 const std::string &fileName)
+  {
+    // (with stripes, it's only the stripes that get block-compressed)
+    if (options.blockCompression != BLOCK_COMPRESSION_NONE && options.numStripes <= 1) {
+      io::BlockWriteBuffer blocks(fileOut,options.blockCompression,options.blockSize,
+                                  options.checksums);
+      std::ostream blockOut(&blocks);
+      // let errors thrown while compressing propagate to the caller
+      blockOut.exceptions(std::ios::badbit);
+      SaveOptions inner = options;
+      inner.blockCompression = BLOCK_COMPRESSION_NONE;
+      saveScene(scene,blockOut,inner,fileName);
+      blocks.finish();
+      return;
+    }
+    
+    SerializedScene serialized(scene);
+
+    uint64_t features = 0;
+    if (options.compactTransforms)
+      features |= FEATURE_COMPACT_XFMS;
+    for (auto &mesh : serialized.meshes.list)
+      if (options.compactIndices
+          && (mesh->hasCompactIndices() || mesh->canUseCompactIndices()))
+        features |= FEATURE_INDEX16;
+    if (options.positionQuantizationError >= 0.f || options.quantizeAttributes)
+      features |= FEATURE_QUANTIZED_GEOMETRY;
+    if (options.compressIndices)
+      features |= FEATURE_COMPRESSED_INDICES;
+    if (options.compressFloats)
+      features |= FEATURE_COMPRESSED_FLOATS;
+    if (options.checksums)
+      features |= FEATURE_CHECKSUMS;
+    if (options.numStripes > 1) {
+      if (fileName.empty())
+        throw std::runtime_error("striped scenes can only get saved to a file (by name)");
+      features |= FEATURE_STRIPED;
+    }
+
+    // with checksums, everything goes through a buffer that checksums
+    // it (and writes the checksums) record by record
+    std::unique_ptr<io::ChecksumWriteBuffer> checksums;
+    std::unique_ptr<std::ostream>            checksummedOut;
+    if (options.checksums) {
+      checksums.reset(new io::ChecksumWriteBuffer(fileOut));
+      checksummedOut.reset(new std::ostream(checksums.get()));
+      checksummedOut->exceptions(fileOut.exceptions());
+    }
+    std::ostream &out = checksums ? *checksummedOut : fileOut;
+    auto beginRecord = [&](RecordKind kind, int object, int index)
+    { if (checksums) checksums->beginRecord(kind,object,index); };
+    
+    // plain files get written in the old format, so older readers can
+    // still load them
+    const size_t magic = features ? expected_magic : magic_v12;
+    io::writeElement(out,magic);
+    if (features)
+      io::writeElement(out,features);
+
+    // with stripes, every texture and mesh goes to one of them - the
+    // biggest ones first, each to the stripe with the fewest bytes so
+    // far - and the manifest only says which
+    struct Stripe {
+      std::vector<int>                textures;
+      /*! object and mesh ID of every mesh */
+      std::vector<std::pair<int,int>> meshes;
+    };
+    const int numStripes = (features & FEATURE_STRIPED) ? options.numStripes : 0;
+    std::vector<Stripe>           stripes(numStripes);
+    std::vector<int>              textureStripes;
+    std::vector<std::vector<int>> meshStripes;
+    uint64_t                      stripeToken = 0;
+    if (numStripes) {
+      std::vector<size_t> sizes;
+      for (auto &tex : serialized.textures.list)
+        if (tex) sizes.push_back(tex->data.size());
+      for (auto &obj : serialized.objects.list)
+        for (auto &mesh : obj->meshes)
+          if (mesh) sizes.push_back(estimatedFileSize(*mesh));
+      const std::vector<int> assigned = assignStripes(sizes,numStripes);
+
+      size_t itemID = 0;
+      textureStripes.resize(serialized.textures.size(),-1);
+      for (int texID=0;texID<(int)serialized.textures.size();texID++)
+        if (serialized.textures[texID]) {
+          const int stripeID = textureStripes[texID] = assigned[itemID++];
+          stripes[stripeID].textures.push_back(texID);
+        }
+      meshStripes.resize(serialized.objects.size());
+      for (int objID=0;objID<(int)serialized.objects.size();objID++) {
+        const Object::SP &obj = serialized.objects[objID];
+        meshStripes[objID].resize(obj->meshes.size(),-1);
+        for (int meshID=0;meshID<(int)obj->meshes.size();meshID++)
+          if (obj->meshes[meshID]) {
+            const int stripeID = meshStripes[objID][meshID] = assigned[itemID++];
+            stripes[stripeID].meshes.push_back({objID,meshID});
+          }
+      }
+
+      // (so loading can tell stripes of other versions of this scene
+      // apart from its own)
+      std::random_device random;
+      stripeToken = (uint64_t(random()) << 32) | random();
+    }
 
     // ------------------------------------------------------------------
     // textures
     // ------------------------------------------------------------------
+    beginRecord(RECORD_HEADER,-1,-1);
+    if (numStripes) {
+      io::writeElement(out,numStripes);
+      io::writeElement(out,stripeToken);
+    }
     io::writeElement(out,serialized.textures.list.size());
-    for (auto tex : serialized.textures.list) {
+    for (int texID=0;texID<(int)serialized.textures.list.size();texID++) {
+      beginRecord(RECORD_TEXTURE,-1,texID);
+      const Texture::SP &tex = serialized.textures.list[texID];
       if (/* only first one may/will be null */!tex) {
         io::writeElement(out,int(0));
+      } else if (numStripes) {
+        io::writeElement(out,int(1));
+        io::writeElement(out,textureStripes[texID]);
       } else {
         io::writeElement(out,int(1));
-        io::writeElement(out,tex->size);
-        io::writeElement(out,tex->format);
-        io::writeElement(out,tex->filterMode);
-        io::writeVector(out,tex->data);
+        writeTexture(out,*tex);
       }
     }
 
     // ------------------------------------------------------------------
     // lights
     // ------------------------------------------------------------------
-    io::writeVector(out,quadLights);
-    io::writeVector(out,dirLights);
-    if (envMapLight) {
+    beginRecord(RECORD_LIGHTS,-1,-1);
+    io::writeVector(out,scene->quadLights);
+    io::writeVector(out,scene->dirLights);
+    if (scene->envMapLight) {
       io::writeElement(out,int(1));
-      io::writeElement(out,envMapLight->transform);
-      Texture::SP tex = envMapLight->texture;
-      assert(tex);
-      io::writeElement(out,tex->size);
-      io::writeElement(out,tex->format);
-      io::writeElement(out,tex->filterMode);
-      io::writeVector(out,tex->data);
+      io::writeElement(out,scene->envMapLight->transform);
+      assert(scene->envMapLight->texture);
+      writeTexture(out,*scene->envMapLight->texture);
     } else
       io::writeElement(out,int(0));
         
     // ------------------------------------------------------------------
     // materials
     // ------------------------------------------------------------------
+    beginRecord(RECORD_MATERIALS,-1,-1);
     io::writeElement(out,serialized.materials.list.size());
     for (auto mat : serialized.materials.list) {
       // io::writeElement(out,(MaterialData&)*mat);
 #if 1
       // version 12
-      int tag = (int)materialTagOf(mat);
+      int tag = (int)mat->tag();
       io::writeElement(out,tag);
       mat->write(out,serialized.textures.registry);
 #else
@@ -638,33 +1021,66 @@ namespace mini {
     // objects and meshes
     // ------------------------------------------------------------------
     io::writeElement(out,serialized.objects.size());
-    for (auto &obj : serialized.objects.list) {
+    ProgressStage objectStage(options.progress,"saving objects",serialized.objects.size());
+    for (int objID=0;objID<(int)serialized.objects.list.size();objID++) {
+      const Object::SP &obj = serialized.objects.list[objID];
+      options.progress.checkCancelled();
 
+      // (the first mesh's record includes the mesh count)
+      beginRecord(RECORD_MESH,objID,0);
       io::writeElement(out,obj->meshes.size());
-      for (auto mesh : obj->meshes) {
+      for (int meshID=0;meshID<(int)obj->meshes.size();meshID++) {
+        if (meshID > 0)
+          beginRecord(RECORD_MESH,objID,meshID);
+        const Mesh::SP &mesh = obj->meshes[meshID];
         if (!mesh) { io::writeElement(out,int(0)); continue; }
 
         io::writeElement(out,int(1));
-        io::writeVector(out,mesh->indices);
-        io::writeVector(out,mesh->vertices);
-        io::writeVector(out,mesh->normals);
-        io::writeVector(out,mesh->texcoords);
+        if (numStripes) {
+          io::writeElement(out,meshStripes[objID][meshID]);
+          continue;
+        }
         int matID = serialized.getID(mesh->material);
         assert(matID >= 0);
-        io::writeElement(out,matID);
+        writeMesh(out,*mesh,matID,features,options);
       }
+      objectStage.advance();
     }
 
     // ------------------------------------------------------------------
     // instances
     // ------------------------------------------------------------------
-    io::writeElement(out,instances.size());
-    for (auto &inst : instances) {
-      if (!inst) { io::writeElement(out,int(0)); continue; }
+    beginRecord(RECORD_INSTANCES,-1,-1);
+    if (features & FEATURE_COMPACT_XFMS) {
+      std::vector<int>      objectIDs(scene->instances.size());
+      std::vector<affine3f> xfms(scene->instances.size());
+      parallel_for_blocked
+        ((size_t)0,scene->instances.size(),16*1024,
+         [&](size_t begin, size_t end) {
+           for (size_t instID=begin;instID<end;instID++) {
+             const Instance::SP &inst = scene->instances[instID];
+             // null instances get object ID -1, and an identity
+             // transform (which doesn't cost anything in the palette)
+             objectIDs[instID] = inst ? serialized.getID(inst->object) : -1;
+             xfms[instID]      = inst ? inst->xfm : affine3f();
+           }
+         });
+      CompactTransforms compact
+        = CompactTransforms::encode(xfms,options.transformQuantizationError);
+      io::writeVector(out,objectIDs);
+      io::writeVector(out,compact.palette);
+      io::writeVector(out,compact.quantized);
+      io::writeVector(out,compact.linearRefs);
+      io::writeVector(out,compact.translations);
+    } else {
+      io::writeElement(out,scene->instances.size());
+      for (auto &inst : scene->instances) {
+        if (!inst) { io::writeElement(out,int(0)); continue; }
 
-      io::writeElement(out,int(1));
-      io::writeElement(out,inst->xfm);
-      io::writeElement(out,int(serialized.getID(inst->object)));
+        io::writeElement(out,int(1));
+        io::writeElement(out,inst->xfm);
+        io::writeElement(out,int(serialized.getID(inst->object)));
+      }
     }
       
     // ------------------------------------------------------------------
@@ -674,36 +1090,560 @@ namespace mini {
     // io::writeVector(out,ownedOn);
 
     // ------------------------------------------------------------------
-    // wrap-up: write end-of file marker
+    // wrap-up: write checksum table (if any), and end-of file marker
+    // ------------------------------------------------------------------
+    if (checksums) {
+      checksums->endRecord();
+      const uint64_t tableOffset = checksums->tell();
+      io::writeVector(out,checksums->records);
+      const std::vector<ChecksumRecord> &table = checksums->records;
+      io::writeElement(out,XXHash64::hash(table.data(),table.size()*sizeof(table[0])));
+      io::writeElement(out,tableOffset);
+    }
+    io::writeElement(out,magic);
+    if (checksums)
+      out.flush();
+    if (!out.good())
+      throw std::runtime_error("some error happened while writing mini scene");
+
+    // ------------------------------------------------------------------
+    // stripes (if any), all in parallel
     // ------------------------------------------------------------------
-    io::writeElement(out,expected_magic);
+    if (!numStripes) return;
+    size_t numStripedItems = 0;
+    for (auto &stripe : stripes)
+      numStripedItems += stripe.textures.size()+stripe.meshes.size();
+    ProgressStage stripeStage(options.progress,"saving stripes",numStripedItems);
+    // (CompressionStats aren't thread-safe, so every stripe gets its
+    // own, and they get merged at the end)
+    std::vector<CompressionStats> stripeStats(numStripes);
+    parallel_for
+      (numStripes,
+       [&](size_t stripeID) {
+         const std::string stripeName = stripeFileName(fileName,(int)stripeID);
+         std::ofstream file(stripeName,std::ios::binary);
+         if (!file.good())
+           throw std::runtime_error("could not open file '"+stripeName+"'");
+         std::unique_ptr<io::BlockWriteBuffer> blocks;
+         std::unique_ptr<std::ostream>         blockOut;
+         if (options.blockCompression != BLOCK_COMPRESSION_NONE) {
+           blocks.reset(new io::BlockWriteBuffer(file,options.blockCompression,
+                                                 options.blockSize,options.checksums));
+           blockOut.reset(new std::ostream(blocks.get()));
+           // let errors thrown while compressing propagate to the caller
+           blockOut->exceptions(std::ios::badbit);
+         }
+         std::ostream &blockedOut = blockOut ? *blockOut : file;
+         // with checksums, every stripe gets records - and a checksum
+         // table - of its own
+         std::unique_ptr<io::ChecksumWriteBuffer> checksums;
+         std::unique_ptr<std::ostream>            checksummedOut;
+         if (options.checksums) {
+           checksums.reset(new io::ChecksumWriteBuffer(blockedOut));
+           checksummedOut.reset(new std::ostream(checksums.get()));
+           checksummedOut->exceptions(blockedOut.exceptions());
+         }
+         std::ostream &out = checksums ? *checksummedOut : blockedOut;
+         auto beginRecord = [&](RecordKind kind, int object, int index)
+         { if (checksums) checksums->beginRecord(kind,object,index); };
+         SaveOptions stripeOptions = options;
+         if (options.compressionStats)
+           stripeOptions.compressionStats = &stripeStats[stripeID];
+
+         const Stripe &stripe = stripes[stripeID];
+         io::writeElement(out,stripe_magic);
+         io::writeElement(out,features);
+         beginRecord(RECORD_HEADER,-1,-1);
+         io::writeElement(out,stripeToken);
+         io::writeElement(out,int(stripeID));
+         io::writeElement(out,stripe.textures.size());
+         for (int texID : stripe.textures) {
+           options.progress.checkCancelled();
+           beginRecord(RECORD_TEXTURE,-1,texID);
+           writeTexture(out,*serialized.textures[texID]);
+           stripeStage.advance();
+         }
+         beginRecord(RECORD_HEADER,-1,-1);
+         io::writeElement(out,stripe.meshes.size());
+         for (auto &ids : stripe.meshes) {
+           options.progress.checkCancelled();
+           beginRecord(RECORD_MESH,ids.first,ids.second);
+           const Mesh::SP &mesh = serialized.objects[ids.first]->meshes[ids.second];
+           writeMesh(out,*mesh,serialized.materials.getID(mesh->material),
+                     features,stripeOptions);
+           stripeStage.advance();
+         }
+         if (checksums) {
+           checksums->endRecord();
+           const uint64_t tableOffset = checksums->tell();
+           io::writeVector(out,checksums->records);
+           const std::vector<ChecksumRecord> &table = checksums->records;
+           io::writeElement(out,XXHash64::hash(table.data(),table.size()*sizeof(table[0])));
+           io::writeElement(out,tableOffset);
+         }
+         io::writeElement(out,stripe_magic);
+         if (checksums)
+           out.flush();
+         if (blocks)
+           blocks->finish();
+         file.flush();
+         if (!file.good())
+           throw std::runtime_error("some error happened while writing '"+stripeName+"'");
+       });
+    if (options.compressionStats)
+      for (auto &stats : stripeStats)
+        options.compressionStats->add(stats);
+  }
+
+  void Scene::save(std::ostream &out,
+                   const SaveOptions &options)
+  {
+    saveScene(this,out,options,/*fileName*/"");
+  }
+
+  void Scene::save(const std::string &baseName,
+                   const SaveOptions &options)
+  {
+    std::ofstream out(baseName,std::ios::binary);
+    if (!out.good())
+      throw std::runtime_error("could not open file '"+baseName+"'");
+    saveScene(this,out,options,baseName);
+    out.flush();
     if (!out.good())
       throw std::runtime_error("some error happened while writing '"+baseName+"'");
+
+    // remove the stripes an earlier, more (or differently) striped
+    // version of this file may have left behind; those would never
+    // get loaded (their token doesn't match), but waste space, and
+    // would confuse anybody looking at the directory
+    const int numStripes = options.numStripes > 1 ? options.numStripes : 0;
+    for (int stripeID=numStripes;;stripeID++)
+      if (std::remove(stripeFileName(baseName,stripeID).c_str()) != 0)
+        break;
+  }
+  
+  void Scene::save(const WriteCallback &write,
+                   const SaveOptions &options)
+  {
+    io::CallbackWriteBuffer buffer(write);
+    std::ostream out(&buffer);
+    // let errors thrown by the callback propagate to the caller
+    out.exceptions(std::ios::badbit);
+    save(out,options);
+    buffer.flush();
   }
     
-  Scene::SP Scene::load(const std::string &baseName)
+  /*! reads what writeFloatArray() wrote */
+  template<typename T>
+  void readFloatArray(std::istream &in, std::vector<T> &array,
+                      uint64_t features)
   {
-    std::ifstream in(baseName,std::ios::binary);
-    if (!in.good())
-      throw std::runtime_error("could not open Scene{"+baseName+"}");
-    Scene::SP scene = std::make_shared<Scene>();
+    const int encoding
+      = (features & FEATURE_COMPRESSED_FLOATS)
+      ? io::readElement<int>(in)
+      : int(FLOATS_RAW);
+    if (encoding == FLOATS_RAW) {
+      io::readVector(in,array);
+      return;
+    }
+    if (encoding != FLOATS_COMPRESSED)
+      throw std::runtime_error("invalid float array encoding in 'mini' scene file - cannot load");
+    codecs::CompressedFloats compressed;
+    io::readElement(in,compressed.numComponents);
+    io::readElement(in,compressed.numElements);
+    io::readVector(in,compressed.chunkOffsets);
+    io::readVector(in,compressed.bytes);
+    if (compressed.numComponents*sizeof(float) != sizeof(T))
+      throw std::runtime_error("invalid float array encoding in 'mini' scene file - cannot load");
+    memory::resizeBulk(array,compressed.numElements);
+    compressed.decode((float *)array.data());
+  }
 
-    size_t magic = io::readElement<size_t>(in);
-    int format_version = 12;
-    if (magic == expected_magic) {
-      // all good, this is our format we'd also write
-    } else if (magic == expected_magic-1) {
-      // version 11 - old mini::Material handling - we should still be able to read this.
-      format_version = 11;
+  /*! reads what writeQuantizedGeometry() wrote; positions get
+      dequantized right away, compact normals and texcoords get
+      returned as they are */
+  void readQuantizedGeometry(std::istream &in, uint64_t features,
+                             std::vector<vec3f>    &vertices,
+                             std::vector<vec3f>    &normals,
+                             std::vector<uint32_t> &normalsOct,
+                             std::vector<vec2f>    &texcoords,
+                             std::vector<vec2us>   &texcoords16,
+                             int                   &texcoords16Format)
+  {
+    using namespace vertex_formats;
+    
+    const int bits = io::readElement<int>(in);
+    if (bits == 0)
+      readFloatArray(in,vertices,features);
+    else if (bits == 16 || bits == 21) {
+      PositionQuantization quantization;
+      quantization.bits = bits;
+      io::readElement(in,quantization.origin);
+      io::readElement(in,quantization.scale);
+      if (bits == 16) {
+        std::vector<vec3us> quantized;
+        io::readVector(in,quantized);
+        memory::resizeBulk(vertices,quantized.size());
+        decodePositions16(quantized.data(),vertices.data(),vertices.size(),quantization);
+      } else {
+        std::vector<uint64_t> quantized;
+        io::readVector(in,quantized);
+        memory::resizeBulk(vertices,quantized.size());
+        decodePositions21(quantized.data(),vertices.data(),vertices.size(),quantization);
+      }
     } else
-      throw std::runtime_error("invalid or incompatible 'mini' scene file (wrong file magic) - cannot load");
-      
+      throw std::runtime_error("invalid position quantization in 'mini' scene file - cannot load");
+
+    const int normalEncoding = io::readElement<int>(in);
+    if (normalEncoding == ATTRIBUTES_COMPACT)
+      io::readVector(in,normalsOct);
+    else if (normalEncoding == ATTRIBUTES_RAW)
+      readFloatArray(in,normals,features);
+    else
+      throw std::runtime_error("invalid normal encoding in 'mini' scene file - cannot load");
+
+    const int texcoordEncoding = io::readElement<int>(in);
+    if (texcoordEncoding == ATTRIBUTES_COMPACT) {
+      io::readElement(in,texcoords16Format);
+      if (texcoords16Format != TEXCOORDS_HALF && texcoords16Format != TEXCOORDS_UNORM16)
+        throw std::runtime_error("invalid texcoord format in 'mini' scene file - cannot load");
+      io::readVector(in,texcoords16);
+    } else if (texcoordEncoding == ATTRIBUTES_RAW)
+      readFloatArray(in,texcoords,features);
+    else
+      throw std::runtime_error("invalid texcoord encoding in 'mini' scene file - cannot load");
+  }
+  
+  Scene::SP Scene::load(const void *data, size_t numBytes,
+                        const LoadOptions &options)
+  {
+    io::MemoryReadBuffer buffer(data,numBytes);
+    std::istream in(&buffer);
+    return load(in,options);
+  }
+  
+  Scene::SP Scene::load(const ReadCallback &read,
+                        const LoadOptions &options)
+  {
+    io::CallbackReadBuffer buffer(read);
+    std::istream in(&buffer);
+    // let errors thrown by the callback propagate to the caller
+    in.exceptions(std::ios::badbit);
+    return load(in,options);
+  }
+  
+  /*! a mesh whose indices were stored compressed; reading the file
+      is serial, but decoding them doesn't have to be */
+  struct CompressedMesh {
+    Mesh::SP                  mesh;
+    codecs::CompressedIndices indices;
+  };
+
+  /*! reads what writeMesh() wrote into a new mesh (allocated in
+      'arena'); compressed indices don't get decoded yet, but the
+      mesh gets added to 'compressedMeshes' */
+  Mesh::SP readMesh(std::istream &in,
+                    uint64_t features,
+                    const std::vector<Material::SP> &materials,
+                    const Arena::SP &arena,
+                    const LoadOptions &options,
+                    std::vector<CompressedMesh> &compressedMeshes)
+  {
+    // read the arrays first, so we can create the mesh with its
+    // actual material (rather than a default one that we'd
+    // immediately throw away again)
+    std::vector<vec3i>    indices;
+    std::vector<vec3us>   indices16;
+    std::vector<vec3f>    vertices;
+    std::vector<vec3f>    normals;
+    std::vector<vec2f>    texcoords;
+    std::vector<uint32_t> normalsOct;
+    std::vector<vec2us>   texcoords16;
+    int texcoords16Format = 0;
+    codecs::CompressedIndices compressedIndices;
+    const int indexEncoding
+      = (features & (FEATURE_INDEX16|FEATURE_COMPRESSED_INDICES))
+      ? io::readElement<int>(in)
+      : int(INDICES_VEC3I);
+    if (indexEncoding == INDICES_VEC3I)
+      io::readVector(in,indices);
+    else if (indexEncoding == INDICES_VEC3US)
+      io::readVector(in,indices16);
+    else if (indexEncoding == INDICES_COMPRESSED) {
+      io::readElement(in,compressedIndices.numTriangles);
+      io::readVector(in,compressedIndices.blockBases);
+      io::readVector(in,compressedIndices.blockOffsets);
+      io::readVector(in,compressedIndices.bytes);
+    } else
+      throw std::runtime_error("invalid index encoding in 'mini' scene file - cannot load");
+    if (features & FEATURE_QUANTIZED_GEOMETRY) {
+      readQuantizedGeometry(in,features,vertices,normals,normalsOct,
+                            texcoords,texcoords16,texcoords16Format);
+    } else {
+      readFloatArray(in,vertices,features);
+      readFloatArray(in,normals,features);
+      readFloatArray(in,texcoords,features);
+    }
+    int matID = io::readElement<int>(in);
+    assert(matID >= 0);
+    assert(matID < materials.size());
+    Mesh::SP mesh = makeInArena<Mesh>(arena,materials[matID]);
+    mesh->indices   = std::move(indices);
+    mesh->indices16 = std::move(indices16);
+    mesh->vertices  = std::move(vertices);
+    mesh->normals   = std::move(normals);
+    mesh->texcoords = std::move(texcoords);
+    mesh->normalsOct  = std::move(normalsOct);
+    mesh->texcoords16 = std::move(texcoords16);
+    mesh->texcoords16Format = (vertex_formats::TexcoordFormat)texcoords16Format;
+    if (indexEncoding == INDICES_COMPRESSED)
+      // decoded later, together with all other meshes' indices
+      compressedMeshes.push_back({mesh,std::move(compressedIndices)});
+    else if (options.compactIndices)
+      mesh->compactIndices();
+    else
+      mesh->expandIndices();
+    if (options.compactAttributes)
+      mesh->compactAttributes();
+    else
+      mesh->expandAttributes();
+    return mesh;
+  }
+
+  /*! decodes the indices of all given meshes, in parallel across
+      meshes (and across blocks within each mesh) */
+  void decodeIndices(std::vector<CompressedMesh> &compressedMeshes,
+                     const LoadOptions &options)
+  {
+    // (the decoded indices get allocated on the worker threads, so
+    // those need the caller's NUMA placement)
+    parallel_for
+      (compressedMeshes.size(),
+       memory::withNumaPlacement([&](size_t i) {
+         CompressedMesh &cm = compressedMeshes[i];
+         std::vector<vec3i> indices;
+         memory::resizeBulk(indices,cm.indices.numTriangles);
+         cm.indices.decode(indices.data());
+         cm.mesh->indices = std::move(indices);
+         cm.indices = codecs::CompressedIndices();
+         if (options.compactIndices)
+           cm.mesh->compactIndices();
+       }));
+    compressedMeshes.clear();
+  }
+
+  /*! reads one record of the .mini file that starts at 'fileBegin'
+      (and the hash stored after the record) from 'in', and returns
+      what's wrong with it (if anything) */
+  std::string verifyRecord(std::istream &in, std::streampos fileBegin,
+                           const ChecksumRecord &record,
+                           std::vector<char> &buffer)
+  {
+    const std::streampos recordBegin = fileBegin+std::streamoff(record.offset);
+    if (in.tellg() != recordBegin)
+      in.seekg(recordBegin);
+    XXHash64 hash;
+    for (uint64_t done=0;done<record.size;) {
+      const size_t numBytes = (size_t)std::min<uint64_t>(buffer.size(),record.size-done);
+      io::readArray(in,buffer.data(),numBytes);
+      hash.update(buffer.data(),numBytes);
+      done += numBytes;
+    }
+    if (hash.digest() != record.hash)
+      return "checksum mismatch in "+record.describe();
+    if (io::readElement<uint64_t>(in) != record.hash)
+      return "stored checksum of "+record.describe()+" is corrupt";
+    return "";
+  }
+
+  /*! what a striped scene's manifest says is in one of its stripes:
+      the textures (which the manifest already created, since its
+      materials refer to them), and for every mesh, which object it
+      belongs to, and where in that object's meshes it goes. Both
+      also know their IDs in the file, which their checksum records
+      (if any) refer to */
+  struct StripeContents {
+    struct TextureSlot {
+      Texture::SP texture;
+      int         texID;
+    };
+    struct MeshSlot {
+      Object::SP object;
+      size_t     index;
+      int        objID, meshID;
+    };
+    std::vector<TextureSlot> textures;
+    std::vector<MeshSlot>    meshes;
+  };
+
+  /*! reads the stripe file with given name and ID (see
+      stripe_magic), which has to have the given contents */
+  void loadStripe(const std::string &stripeName,
+                  int stripeID,
+                  uint64_t features,
+                  uint64_t token,
+                  const StripeContents &contents,
+                  const std::vector<Material::SP> &materials,
+                  const Arena::SP &arena,
+                  ProgressStage &stage,
+                  const LoadOptions &options)
+  {
+    std::ifstream file(stripeName,std::ios::binary);
+    if (!file.good())
+      throw std::runtime_error("could not open stripe file '"+stripeName+"'");
+    const std::string notThisStripe
+      = "'"+stripeName+"' is not stripe #"+std::to_string(stripeID)
+      +" of this 'mini' scene file - cannot load";
+    std::unique_ptr<io::BlockReadBuffer>    blocks;
+    std::unique_ptr<std::istream>           blockIn;
+    std::unique_ptr<io::ChecksumReadBuffer> checksums;
+    std::unique_ptr<std::istream>           checksummedIn;
+    try {
+      size_t magic = io::readElement<size_t>(file);
+      if (magic == io::block_container_magic) {
+        blocks.reset(new io::BlockReadBuffer(file,/*magicAlreadyRead*/true));
+        blockIn.reset(new std::istream(blocks.get()));
+        // let errors thrown while decompressing propagate to the caller
+        blockIn->exceptions(std::ios::badbit);
+        magic = io::readElement<size_t>(*blockIn);
+      }
+      std::istream &blockedIn = blockIn ? *blockIn : file;
+      if (magic != stripe_magic || io::readElement<uint64_t>(blockedIn) != features)
+        throw std::runtime_error(notThisStripe);
+
+      // with checksums, the stripe has records (and a checksum table)
+      // of its own; same as for the manifest, they get verified up
+      // front unless that's already done by the blocks' checksums
+      bool verify
+        =  (features & FEATURE_CHECKSUMS)
+        && options.verifyChecksums
+        && !(blocks && blocks->hasChecksums());
+      if (verify && !blocks) {
+        const std::streampos contentBegin = file.tellg();
+        file.seekg(0);
+        const std::vector<ChecksumRecord> table = readChecksumTable(file);
+        std::vector<char> buffer(1<<20);
+        for (auto &record : table) {
+          options.progress.checkCancelled();
+          const std::string problem = verifyRecord(file,0,record,buffer);
+          if (!problem.empty())
+            throw std::runtime_error(problem);
+        }
+        file.clear();
+        file.seekg(contentBegin);
+        verify = false;
+      }
+      if (features & FEATURE_CHECKSUMS) {
+        checksums.reset(new io::ChecksumReadBuffer(blockedIn));
+        checksums->setVerify(verify);
+        checksummedIn.reset(new std::istream(checksums.get()));
+        // let checksum mismatches propagate to the caller
+        checksummedIn->exceptions(std::ios::badbit);
+      }
+      std::istream &in = checksums ? *checksummedIn : blockedIn;
+      auto beginRecord = [&](RecordKind kind, int object, int index)
+      { if (checksums) checksums->beginRecord(kind,object,index); };
+
+      beginRecord(RECORD_HEADER,-1,-1);
+      if (io::readElement<uint64_t>(in) != token
+          || io::readElement<int>(in) != stripeID)
+        throw std::runtime_error(notThisStripe);
+
+      if (io::readElement<size_t>(in) != contents.textures.size())
+        throw std::runtime_error("stripe file '"+stripeName+"' does not match its 'mini' scene file - cannot load");
+      for (auto &slot : contents.textures) {
+        options.progress.checkCancelled();
+        beginRecord(RECORD_TEXTURE,-1,slot.texID);
+        readTexture(in,*slot.texture);
+        stage.advance();
+      }
+
+      // (the mesh count has a header record of its own)
+      beginRecord(RECORD_HEADER,-1,-1);
+      if (io::readElement<size_t>(in) != contents.meshes.size())
+        throw std::runtime_error("stripe file '"+stripeName+"' does not match its 'mini' scene file - cannot load");
+      std::vector<CompressedMesh> compressedMeshes;
+      for (auto &slot : contents.meshes) {
+        options.progress.checkCancelled();
+        beginRecord(RECORD_MESH,slot.objID,slot.meshID);
+        slot.object->meshes[slot.index]
+          = readMesh(in,features,materials,arena,options,compressedMeshes);
+        stage.advance();
+      }
+      decodeIndices(compressedMeshes,options);
+
+      if (checksums) {
+        checksums->endRecord();
+        // (only needed by Scene::verify())
+        std::vector<ChecksumRecord> table;
+        io::readVector(in,table);
+        io::readElement<uint64_t>(in);
+        io::readElement<uint64_t>(in);
+      }
+      if (io::readElement<size_t>(in) != stripe_magic)
+        throw std::runtime_error("incomplete stripe file '"+stripeName+"' - cannot load");
+    } catch (const Cancelled &) {
+      throw;
+    } catch (const std::exception &e) {
+      if (!(features & FEATURE_CHECKSUMS) || !options.verifyChecksums) throw;
+      // say which stripe file (and record in there, unless it's a
+      // mismatch, which already says that) the error is in
+      const std::string where
+        = (checksums && checksums->isInRecord())
+        ? checksums->currentRecord().describe()+" of "
+        : "";
+      throw std::runtime_error(std::string(e.what())
+                               +" (while reading "+where+"stripe file '"+stripeName+"')");
+    }
+  }
+
+  /*! reads everything after a .mini file's magic and features into
+      'scene'; with checksums, 'in' reads through 'checksums'. For a
+      striped scene, the stripes get found through 'fileName' */
+  void readSceneContents(Scene::SP scene,
+                         std::istream &in,
+                         size_t magic,
+                         int format_version,
+                         uint64_t features,
+                         io::ChecksumReadBuffer *checksums,
+                         const std::string &fileName,
+                         const LoadOptions &options)
+  {
+    auto beginRecord = [&](RecordKind kind, int object, int index)
+    { if (checksums) checksums->beginRecord(kind,object,index); };
+
+    // for a striped scene, this is just the manifest; its textures
+    // and meshes get read from their stripes once it's complete
+    // (with checksums, the stripe count and token are part of the
+    // header record)
+    beginRecord(RECORD_HEADER,-1,-1);
+    int      numStripes  = 0;
+    uint64_t stripeToken = 0;
+    if (features & FEATURE_STRIPED) {
+      if (fileName.empty())
+        throw std::runtime_error("striped 'mini' scene files can only get loaded by file name");
+      io::readElement(in,numStripes);
+      io::readElement(in,stripeToken);
+      if (numStripes < 1)
+        throw std::runtime_error("invalid stripe count in 'mini' scene file - cannot load");
+    }
+    std::vector<StripeContents> stripes(numStripes);
+    auto readStripeID = [&]() {
+      const int stripeID = io::readElement<int>(in);
+      if (stripeID < 0 || stripeID >= numStripes)
+        throw std::runtime_error("invalid stripe ID in 'mini' scene file - cannot load");
+      return stripeID;
+    };
+    
     // ------------------------------------------------------------------
     // textures
     // ------------------------------------------------------------------
     std::vector<Texture::SP> textures;
     size_t numTextures = io::readElement<size_t>(in);
+    ProgressStage textureStage(options.progress,"loading textures",numTextures);
     for (int i=0;i<numTextures;i++) {
+      options.progress.checkCancelled();
+      beginRecord(RECORD_TEXTURE,-1,i);
       // if (i==0)
       //   textures.push_back(0); // first one is always 0
       // else {
@@ -711,35 +1651,36 @@ namespace mini {
       io::readElement(in,valid);
       if (!valid) {
         textures.push_back({});
+      } else if (features & FEATURE_STRIPED) {
+        // (filled in once its stripe gets read)
+        textures.push_back(std::make_shared<Texture>());
+        stripes[readStripeID()].textures.push_back({textures.back(),i});
       } else {
         Texture::SP tex = std::make_shared<Texture>();
-        io::readElement(in,tex->size);
-        io::readElement(in,tex->format);
-        io::readElement(in,tex->filterMode);
-        io::readVector(in,tex->data);
+        readTexture(in,*tex);
         textures.push_back(tex);
       }
+      textureStage.advance();
     }
 
     // ------------------------------------------------------------------
     // lights
     // ------------------------------------------------------------------
+    beginRecord(RECORD_LIGHTS,-1,-1);
     io::readVector(in,scene->quadLights);
     io::readVector(in,scene->dirLights);
     const int hasEnvMap = io::readElement<int>(in);
     if (hasEnvMap) {
       scene->envMapLight = std::make_shared<EnvMapLight>();
       io::readElement(in,scene->envMapLight->transform);
-      Texture::SP tex = scene->envMapLight->texture = std::make_shared<Texture>();
-      io::readElement(in,tex->size);
-      io::readElement(in,tex->format);
-      io::readElement(in,tex->filterMode);
-      io::readVector(in,tex->data);
+      scene->envMapLight->texture = std::make_shared<Texture>();
+      readTexture(in,*scene->envMapLight->texture);
     }
     
     // ------------------------------------------------------------------
     // materials
     // ------------------------------------------------------------------
+    beginRecord(RECORD_MATERIALS,-1,-1);
     std::vector<Material::SP> materials;
     size_t numMaterials = io::readElement<size_t>(in);
     for (int i=0;i<numMaterials;i++) {
@@ -748,7 +1689,7 @@ namespace mini {
       int tag;
       if (format_version == 11)
         // "DISNEY" is the direct equivalent to whatever we had before version 11
-        tag = DISNEY;
+        tag = Material::DISNEY;
       else
         io::readElement(in,tag);
       Material::SP mat = createMaterialFromTag((MaterialTag)tag);
@@ -780,60 +1721,452 @@ namespace mini {
     // ------------------------------------------------------------------
     // objects and meshes
     // ------------------------------------------------------------------
+    // all the (potentially millions of) scene graph nodes get
+    // allocated from one arena rather than individually from the
+    // heap; the arena stays alive as long as any of them does.
+    Arena::SP arena = Arena::create();
+    
+    std::vector<CompressedMesh> compressedMeshes;
+
     size_t numObjects = io::readElement<size_t>(in);
     std::vector<Object::SP> objects;
+    objects.reserve(numObjects);
+    ProgressStage objectStage(options.progress,"loading objects",numObjects);
     for (int objID=0;objID<numObjects;objID++) {
+      options.progress.checkCancelled();
+      // (the first mesh's record includes the mesh count)
+      beginRecord(RECORD_MESH,objID,0);
       size_t numMeshes = io::readElement<size_t>(in);
-      Object::SP object = std::make_shared<Object>();
+      Object::SP object = makeInArena<Object>(arena);
+      object->meshes.reserve(numMeshes);
 
       for (int meshID=0;meshID<(int)numMeshes;meshID++) {
+        if (meshID > 0)
+          beginRecord(RECORD_MESH,objID,meshID);
         int isValid = io::readElement<int>(in);
         if (!isValid) {
           continue;
         }
-        Mesh::SP mesh = std::make_shared<Mesh>();
-        io::readVector(in,mesh->indices);
-        io::readVector(in,mesh->vertices);
-        io::readVector(in,mesh->normals);
-        io::readVector(in,mesh->texcoords);
-        int matID = io::readElement<int>(in);
-        assert(matID >= 0);
-        assert(matID < materials.size());
-        mesh->material = materials[matID];
-        object->meshes.push_back(mesh);
+        if (features & FEATURE_STRIPED) {
+          // (filled in once its stripe gets read)
+          object->meshes.push_back({});
+          stripes[readStripeID()].meshes.push_back({object,object->meshes.size()-1,
+                                                    objID,meshID});
+        } else
+          object->meshes.push_back(readMesh(in,features,materials,arena,options,
+                                            compressedMeshes));
       }
       objects.push_back(object);
+      objectStage.advance();
     }
 
+    // decode all compressed indices in parallel
+    decodeIndices(compressedMeshes,options);
+
     // ------------------------------------------------------------------
     // instances
     // ------------------------------------------------------------------
-    size_t numInstances = io::readElement<size_t>(in);
-    for (int instID=0;instID<numInstances;instID++) {
-      int isValid = io::readElement<int>(in);
-      if (!isValid) {
-        scene->instances.push_back(0);
-        continue;
+    beginRecord(RECORD_INSTANCES,-1,-1);
+    if (features & FEATURE_COMPACT_XFMS) {
+      std::vector<int> objectIDs;
+      CompactTransforms compact;
+      io::readVector(in,objectIDs);
+      io::readVector(in,compact.palette);
+      io::readVector(in,compact.quantized);
+      io::readVector(in,compact.linearRefs);
+      io::readVector(in,compact.translations);
+      if (compact.linearRefs.size() != objectIDs.size() ||
+          compact.translations.size() != objectIDs.size())
+        throw std::runtime_error("inconsistent instance transforms in 'mini' scene file - cannot load");
+      for (size_t instID=0;instID<objectIDs.size();instID++) {
+        // (object ID -1 is a null instance)
+        if (objectIDs[instID] < -1 || objectIDs[instID] >= (int)objects.size())
+          throw std::runtime_error("invalid object ID "+std::to_string(objectIDs[instID])
+                                   +" in 'mini' scene file - cannot load");
+        const uint32_t ref = compact.linearRefs[instID];
+        const size_t tableSize
+          = (ref & CompactTransforms::QUANTIZED_BIT)
+          ? compact.quantized.size()
+          : compact.palette.size();
+        if ((ref & ~CompactTransforms::QUANTIZED_BIT) >= tableSize)
+          throw std::runtime_error("invalid instance transform reference in 'mini' scene file - cannot load");
+      }
+      const std::vector<affine3f> xfms = compact.decodeAll();
+      scene->instances.resize(objectIDs.size());
+      parallel_for_blocked
+        ((size_t)0,objectIDs.size(),16*1024,
+         [&](size_t begin, size_t end) {
+           for (size_t instID=begin;instID<end;instID++) {
+             if (objectIDs[instID] < 0) continue;
+             scene->instances[instID]
+               = makeInArena<Instance>(arena,objects[objectIDs[instID]],xfms[instID]);
+           }
+         });
+    } else {
+      size_t numInstances = io::readElement<size_t>(in);
+      scene->instances.reserve(numInstances);
+      for (int instID=0;instID<numInstances;instID++) {
+        int isValid = io::readElement<int>(in);
+        if (!isValid) {
+          scene->instances.push_back(0);
+          continue;
+        }
+        affine3f xfm = io::readElement<affine3f>(in);
+        Object::SP object = objects[io::readElement<int>(in)];
+        scene->instances.push_back(makeInArena<Instance>(arena,object,xfm));
       }
-      Instance::SP inst = std::make_shared<Instance>();
-      io::readElement(in,inst->xfm);
-      inst->object = objects[io::readElement<int>(in)];
-      scene->instances.push_back(inst);
     }
 
     // ------------------------------------------------------------------
     // wrap-up
     // ------------------------------------------------------------------
+    if (checksums) {
+      checksums->endRecord();
+      // the checksum table is only needed to verify files without
+      // loading them (see Scene::verify())
+      std::vector<ChecksumRecord> table;
+      io::readVector(in,table);
+      io::readElement<uint64_t>(in);
+      io::readElement<uint64_t>(in);
+    }
 
     size_t magicAtEnd = io::readElement<size_t>(in);
-    if (magicAtEnd != expected_magic
+    if (magicAtEnd != magic
         &&
-        magicAtEnd != (expected_magic-1)
-        )
+        // older writers didn't always end with the same magic they
+        // started with
+        (format_version == FORMAT_VERSION
+         || (magicAtEnd != magic_v12 && magicAtEnd != magic_v11)))
       throw std::runtime_error("incomplete or incompatible miniScene/.mini file - cannot load");
-      
+
+    // ------------------------------------------------------------------
+    // stripes (if any), all in parallel
+    // ------------------------------------------------------------------
+    if (features & FEATURE_STRIPED) {
+      size_t numStripedItems = 0;
+      for (auto &stripe : stripes)
+        numStripedItems += stripe.textures.size()+stripe.meshes.size();
+      ProgressStage stripeStage(options.progress,"loading stripes",numStripedItems);
+      // (every stripe's meshes and textures get allocated on a
+      // worker thread, so those need the caller's NUMA placement)
+      parallel_for
+        (stripes.size(),
+         memory::withNumaPlacement([&](size_t stripeID) {
+           loadStripe(stripeFileName(fileName,(int)stripeID),(int)stripeID,
+                      features,stripeToken,stripes[stripeID],
+                      materials,arena,stripeStage,options);
+         }));
+    }
+  }
+
+  std::vector<ChecksumRecord> format::readChecksumTable(std::istream &in)
+  {
+    in.clear();
+    const std::streampos fileBegin = in.tellg();
+    // (stripe files have the same layout, just another magic)
+    const size_t magic = io::readElement<size_t>(in);
+    if ((magic != expected_magic && magic != stripe_magic)
+        || !(io::readElement<uint64_t>(in) & FEATURE_CHECKSUMS))
+      throw std::runtime_error("'mini' scene file does not have checksums");
+    in.seekg(-std::streamoff(2*sizeof(uint64_t)+sizeof(size_t)),std::ios::end);
+    const uint64_t tableHash   = io::readElement<uint64_t>(in);
+    const uint64_t tableOffset = io::readElement<uint64_t>(in);
+    if (io::readElement<size_t>(in) != magic)
+      throw std::runtime_error("incomplete 'mini' scene file (no end-of-file magic)");
+    in.seekg(fileBegin+std::streamoff(tableOffset));
+    const size_t numRecords = io::readElement<size_t>(in);
+    // (every record is followed by its 8-byte hash)
+    if (numRecords > tableOffset/sizeof(uint64_t))
+      throw std::runtime_error("checksum table of 'mini' scene file is corrupt");
+    std::vector<ChecksumRecord> table(numRecords);
+    io::readArray(in,table.data(),table.size());
+    if (XXHash64::hash(table.data(),table.size()*sizeof(table[0])) != tableHash)
+      throw std::runtime_error("checksum table of 'mini' scene file is corrupt");
+    return table;
+  }
+
+  /*! Scene::load(), for a stream whose data may already have been
+      verified (by the checksums of the blocks it came from); for
+      files loaded by name, 'fileName' is that name */
+  Scene::SP loadScene(std::istream &fileIn,
+                      const LoadOptions &options,
+                      bool alreadyVerified,
+                      const std::string &fileName)
+  {
+    memory::ScopedNumaPlacement numaPlacement(options.numaPlacement);
+    Scene::SP scene = std::make_shared<Scene>();
+
+    const std::streampos fileBegin = fileIn.tellg();
+    size_t magic = io::readElement<size_t>(fileIn);
+    if (magic == io::block_container_magic) {
+      io::BlockReadBuffer blocks(fileIn,/*magicAlreadyRead*/true);
+      std::istream blockIn(&blocks);
+      // let errors thrown while decompressing propagate to the caller
+      blockIn.exceptions(std::ios::badbit);
+      return loadScene(blockIn,options,blocks.hasChecksums(),fileName);
+    }
+    int format_version = FORMAT_VERSION;
+    uint64_t features = 0;
+    if (magic == expected_magic) {
+      // all good, this is our format we'd also write
+      io::readElement(fileIn,features);
+      if (features & ~KNOWN_FEATURES)
+        throw std::runtime_error("'mini' scene file uses features this version of miniScene does not support - cannot load");
+    } else if (magic == magic_v12) {
+      // version 12 - same as 13, but without any features
+      format_version = 12;
+    } else if (magic == magic_v11) {
+      // version 11 - old mini::Material handling - we should still be able to read this.
+      format_version = 11;
+    } else
+      throw std::runtime_error("invalid or incompatible 'mini' scene file (wrong file magic) - cannot load");
+
+    if (!(features & FEATURE_CHECKSUMS)) {
+      readSceneContents(scene,fileIn,magic,format_version,features,nullptr,
+                        fileName,options);
+      return scene;
+    }
+
+    const std::streampos contentBegin = fileIn.tellg();
+    if (options.verifyChecksums && !alreadyVerified && contentBegin >= 0) {
+      // the stream is seekable, so we can verify all records before
+      // reading any of them, and never even look at corrupt data
+      fileIn.seekg(fileBegin);
+      const std::vector<ChecksumRecord> table = readChecksumTable(fileIn);
+      ProgressStage stage(options.progress,"verifying checksums",table.size());
+      std::vector<char> buffer(1<<20);
+      for (auto &record : table) {
+        options.progress.checkCancelled();
+        const std::string problem = verifyRecord(fileIn,fileBegin,record,buffer);
+        if (!problem.empty())
+          throw std::runtime_error(problem);
+        stage.advance();
+      }
+      fileIn.clear();
+      fileIn.seekg(contentBegin);
+      alreadyVerified = true;
+    }
+    
+    // with checksums, everything else gets read through a buffer
+    // that skips them - or, for data that couldn't get verified up
+    // front (from non-seekable streams), checks each record once it
+    // got read
+    io::ChecksumReadBuffer checksums(fileIn);
+    checksums.setVerify(options.verifyChecksums && !alreadyVerified);
+    std::istream in(&checksums);
+    // let checksum mismatches propagate to the caller
+    in.exceptions(std::ios::badbit);
+    try {
+      readSceneContents(scene,in,magic,format_version,features,&checksums,
+                        fileName,options);
+    } catch (const Cancelled &) {
+      throw;
+    } catch (const std::exception &e) {
+      if (!options.verifyChecksums) throw;
+      const std::string where = checksums.currentRecord().describe();
+      const std::string what  = e.what();
+      // (mismatches already say where they are, and errors after the
+      // last record - such as in stripe files - aren't in any)
+      if (!checksums.isInRecord() || what.find(where) != std::string::npos) throw;
+      throw std::runtime_error(what+" (while reading "+where+")");
+    }
     return scene;
   }
+  
+  Scene::SP Scene::load(const std::string &baseName,
+                        const LoadOptions &options)
+  {
+    std::ifstream in(baseName,std::ios::binary);
+    if (!in.good())
+      throw std::runtime_error("could not open Scene{"+baseName+"}");
+    return loadScene(in,options,/*alreadyVerified*/false,baseName);
+  }
+  
+  Scene::SP Scene::load(std::istream &in,
+                        const LoadOptions &options)
+  {
+    return loadScene(in,options,/*alreadyVerified*/false,/*fileName*/"");
+  }
+
+  /*! Scene::verify(), for a single file - the scene file itself, or
+      one of its stripes */
+  std::vector<std::string> verifyFile(const std::string &fileName,
+                                      const Progress &progress)
+  {
+    std::vector<std::string> problems;
+    /*! collects the non-empty ones of the given per-block or
+        per-record problems, in order */
+    auto collect = [&](const std::vector<std::string> &found) {
+      for (auto &problem : found)
+        if (!problem.empty()) problems.push_back(problem);
+    };
+    
+    std::ifstream in(fileName,std::ios::binary);
+    if (!in.good())
+      throw std::runtime_error("could not open Scene{"+fileName+"}");
+
+    if (io::readElement<size_t>(in) != io::block_container_magic) {
+      // a plain file: all records are independent of each other, so
+      // verify them in parallel, in groups of about 'groupSize'
+      // bytes, each of which reads through a stream of its own
+      in.seekg(0);
+      const std::vector<ChecksumRecord> table = readChecksumTable(in);
+      const uint64_t groupSize = (64<<20);
+      std::vector<size_t> groupBegin;
+      uint64_t groupBytes = groupSize;
+      for (size_t i=0;i<table.size();i++) {
+        if (groupBytes >= groupSize) {
+          groupBegin.push_back(i);
+          groupBytes = 0;
+        }
+        groupBytes += table[i].size;
+      }
+      groupBegin.push_back(table.size());
+      
+      std::vector<std::string> recordProblems(table.size());
+      mini::parallel_for_blocked
+        (progress,"verifying records",0,groupBegin.size()-1,1,
+         [&](size_t begin, size_t end) {
+           std::ifstream groupIn(fileName,std::ios::binary);
+           std::vector<char> buffer(1<<20);
+           for (size_t group=begin;group<end;group++) 
+             for (size_t i=groupBegin[group];i<groupBegin[group+1];i++) {
+               try {
+                 recordProblems[i] = verifyRecord(groupIn,0,table[i],buffer);
+               } catch (const std::exception &e) {
+                 // can't read the rest of this group, either
+                 recordProblems[i] = "could not read "+table[i].describe()+": "+e.what();
+                 break;
+               }
+             }
+         });
+      collect(recordProblems);
+      return problems;
+    }
+
+    // a block-compressed file: first verify all blocks (in parallel),
+    // then all records of the inner file; the latter sequentially,
+    // since reading the inner file (in parallel) decompresses whole
+    // batches of blocks at a time
+    io::readElement<uint32_t>(in);
+    const uint32_t flags = io::readElement<uint32_t>(in);
+    in.seekg(0);
+    const std::vector<io::BlockInfo> blocks = io::readBlockIndex(in);
+    std::vector<std::string> blockProblems(blocks.size());
+    if (flags & io::BLOCK_FLAG_CHECKSUMS) {
+      mini::parallel_for_blocked
+        (progress,"verifying blocks",0,blocks.size(),16,
+         [&](size_t begin, size_t end) {
+           std::ifstream blockIn(fileName,std::ios::binary);
+           std::vector<uint8_t> stored;
+           for (size_t i=begin;i<end;i++) {
+             const io::BlockInfo &info = blocks[i];
+             const std::string block
+               = "compressed block #"+std::to_string(i)
+               +" (at uncompressed offset "+std::to_string(info.rawOffset)+")";
+             try {
+               blockIn.seekg(std::streamoff(info.fileOffset));
+               const io::BlockHeader header = io::readElement<io::BlockHeader>(blockIn);
+               if (header.rawSize != info.rawSize
+                   || header.storedSize != info.storedSize
+                   || header.compression != info.compression) {
+                 blockProblems[i] = "header of "+block+" does not match the block index";
+                 continue;
+               }
+               stored.resize(header.storedSize);
+               io::readArray(blockIn,stored.data(),stored.size());
+               if (io::readElement<uint64_t>(blockIn)
+                   != XXHash64::hash(stored.data(),stored.size()))
+                 blockProblems[i] = "checksum mismatch in "+block;
+             } catch (const std::exception &e) {
+               blockProblems[i] = "could not read "+block+": "+e.what();
+               blockIn.clear();
+             }
+           }
+         });
+      collect(blockProblems);
+    }
+
+    in.clear();
+    in.seekg(0);
+    io::BlockReadBuffer blockBuffer(in);
+    std::istream inner(&blockBuffer);
+    inner.exceptions(std::ios::badbit);
+    std::vector<ChecksumRecord> table;
+    try {
+      const size_t innerMagic = io::readElement<size_t>(inner);
+      const bool hasRecords
+        =  (innerMagic == expected_magic || innerMagic == stripe_magic)
+        && (io::readElement<uint64_t>(inner) & FEATURE_CHECKSUMS);
+      if (!hasRecords) {
+        if (!(flags & io::BLOCK_FLAG_CHECKSUMS))
+          throw std::runtime_error("'mini' scene file does not have checksums");
+        // (can only check the blocks, then)
+        return problems;
+      }
+      inner.seekg(0);
+      table = readChecksumTable(inner);
+    } catch (const std::exception &e) {
+      if (!(flags & io::BLOCK_FLAG_CHECKSUMS)) throw;
+      problems.push_back(std::string("could not read checksum table: ")+e.what());
+      return problems;
+    }
+    std::vector<io::BlockInfo> corruptBlocks;
+    for (size_t i=0;i<blocks.size();i++)
+      if (!blockProblems[i].empty()) corruptBlocks.push_back(blocks[i]);
+    ProgressStage stage(progress,"verifying records",table.size());
+    std::vector<char> buffer(1<<20);
+    for (auto &record : table) {
+      progress.checkCancelled();
+      stage.advance();
+      // records in corrupt blocks can't get read, and are corrupt
+      // themselves unless the corruption is in their block's header
+      // or checksum
+      bool inCorruptBlock = false;
+      for (auto &block : corruptBlocks)
+        if (block.rawOffset < record.offset+record.size+sizeof(uint64_t)
+            && record.offset < block.rawOffset+block.rawSize)
+          inCorruptBlock = true;
+      if (inCorruptBlock) {
+        problems.push_back(record.describe()+" is (at least partly) in a corrupt block");
+        continue;
+      }
+      try {
+        const std::string problem = verifyRecord(inner,0,record,buffer);
+        if (!problem.empty()) problems.push_back(problem);
+      } catch (const std::exception &e) {
+        problems.push_back("could not read "+record.describe()+": "+e.what());
+        inner.clear();
+      }
+    }
+    return problems;
+  }
+
+  std::vector<std::string> Scene::verify(const std::string &fileName,
+                                         const Progress &progress)
+  {
+    std::vector<std::string> problems = verifyFile(fileName,progress);
+    // (can't trust the stripe count of a corrupt manifest)
+    if (!problems.empty()) return problems;
+
+    std::ifstream in(fileName,std::ios::binary);
+    if (io::readElement<size_t>(in) != expected_magic
+        || !(io::readElement<uint64_t>(in) & FEATURE_STRIPED))
+      return problems;
+    const int numStripes = io::readElement<int>(in);
+    for (int stripeID=0;stripeID<numStripes;stripeID++) {
+      const std::string stripeName = stripeFileName(fileName,stripeID);
+      try {
+        for (auto &problem : verifyFile(stripeName,progress))
+          problems.push_back("stripe file '"+stripeName+"': "+problem);
+      } catch (const Cancelled &) {
+        throw;
+      } catch (const std::exception &e) {
+        problems.push_back("could not verify stripe file '"+stripeName+"': "+e.what());
+      }
+    }
+    return problems;
+  }
 
 } // ::brix
 
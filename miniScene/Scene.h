@@ -17,6 +17,14 @@
 #pragma once
 
 #include "miniScene/common.h"
+#include "miniScene/VertexFormats.h"
+#include "miniScene/CowVector.h"
+#include "miniScene/Memory.h"
+#include "miniScene/Progress.h"
+#include "miniScene/BlockCompression.h"
+#include "miniScene/Checksum.h"
+#include "miniScene/Transforms.h"
+#include <functional>
 
 namespace mini {
     
@@ -65,21 +73,77 @@ namespace mini {
     std::vector<uint8_t> data;
   };
 
+  /*! one parameter of a material type: its name, type, and where in
+    the material it is. This lets generic code (reading and writing
+    materials, comparing or hashing them, etc) handle all parameters
+    of all material types without knowing these types; see
+    Material::getFields() */
+  struct MaterialField {
+    typedef enum { FLOAT=0, INT, VEC3F, TEXTURE } Type;
+
+    /*! number of bytes this field takes up in .mini files (which
+      store textures as int IDs) */
+    inline size_t fileSize() const
+    { return type == VEC3F ? sizeof(vec3f) : sizeof(int32_t); }
+
+    const char *name;
+    Type        type;
+    /*! byte offset of the field, relative to (the Material base
+      class of) the material it's in */
+    size_t      offset;
+  };
+
   struct Material : public std::enable_shared_from_this<Material> {
     typedef std::shared_ptr<Material> SP;
 
+    /*! the different (concrete) material types; these values also
+      identify them in .mini files */
+    typedef enum { INVALID=0,
+      DISNEY,
+      MATTE,
+      PLASTIC,
+      METAL,
+      VELVET,
+      METALLICPAINT,
+      THINGLASS,
+      DIELECTRIC,
+      BLENDER,
+      ANARI_MATERIAL
+    } Tag;
+
     /*! constructs a new Material - note you _probably_ want to use
       Material::create() instead */
     Material() = default;
 
     virtual std::string toString() const = 0;
+
+    /*! this material's type */
+    virtual Tag tag() const = 0;
+
+    /*! all parameters of this material's type, in the order in
+      which .mini files store them; the same (static) table for all
+      materials of a type */
+    virtual const std::vector<MaterialField> &getFields() const = 0;
     
-    virtual void write(std::ofstream &out,
-                       const std::map<Texture::SP,int> &textures) = 0;
-    virtual void read(std::ifstream &in,
-                      const std::vector<Texture::SP> &textures) = 0;
+    /*! writes all of getFields() in one go, with textures as their
+      IDs in 'textures' (-1 if not in there) */
+    virtual void write(std::ostream &out,
+                       const std::map<Texture::SP,int> &textures);
+    /*! reads what write() wrote, in one go */
+    virtual void read(std::istream &in,
+                      const std::vector<Texture::SP> &textures);
     virtual Material::SP clone() const = 0;
 
+    /*! the value of given field (one of getFields()) of this
+      material; T has to be the field's type (float, int, vec3f, or
+      Texture::SP) */
+    template<typename T>
+    inline T &get(const MaterialField &field)
+    { return *(T*)((char*)this+field.offset); }
+    template<typename T>
+    inline const T &get(const MaterialField &field) const
+    { return *(const T*)((const char*)this+field.offset); }
+
     template<typename ActualMaterial>
     inline std::shared_ptr<ActualMaterial> as() 
     { return std::dynamic_pointer_cast<ActualMaterial>(shared_from_this()); }
@@ -88,6 +152,24 @@ namespace mini {
       Material::create() instead */
     Material(const Material &) = default;
   };
+
+  inline MaterialField::Type materialFieldType(const float *)       { return MaterialField::FLOAT; }
+  inline MaterialField::Type materialFieldType(const int *)         { return MaterialField::INT; }
+  inline MaterialField::Type materialFieldType(const vec3f *)       { return MaterialField::VEC3F; }
+  inline MaterialField::Type materialFieldType(const Texture::SP *) { return MaterialField::TEXTURE; }
+
+  /*! the MaterialField for given member of given material type; for
+    building that type's getFields() table */
+  template<typename ActualMaterial, typename T>
+  inline MaterialField materialField(const char *name, T ActualMaterial::*member)
+  {
+    // (offsetof() isn't defined for classes with virtual functions,
+    // so measure on an actual material)
+    ActualMaterial prototype;
+    const char *base = (const char *)static_cast<Material *>(&prototype);
+    const T *field = &(prototype.*member);
+    return { name, materialFieldType(field), size_t((const char *)field-base) };
+  }
     
   /* blender style principled material - currently filled in with
      nvisii style material, which _should_ be fairly similar (nvisii
@@ -110,11 +192,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<BlenderMaterial>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "BlenderMaterial"; }
+    Tag tag() const override { return BLENDER; }
+    const std::vector<MaterialField> &getFields() const override;
     
     vec3f baseColor              = { .8f, .8f, .8f };
     float roughness              = .5f;
@@ -159,11 +239,9 @@ namespace mini {
     Material::SP clone() const override
     { return std::make_shared<ANARIMaterial>(*this); }
     
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "ANARIMaterial"; }
+    Tag tag() const override { return ANARI_MATERIAL; }
+    const std::vector<MaterialField> &getFields() const override;
 
     // baseColor
     // FLOAT32_VEC3 / SAMPLER / STRING
@@ -350,11 +428,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<DisneyMaterial>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "DisneyMaterial"; }
+    Tag tag() const override { return DISNEY; }
+    const std::vector<MaterialField> &getFields() const override;
     
     
     // bool isEmissive() const { return reduce_max(emission) != 0.f; }
@@ -403,11 +479,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<Plastic>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "Plastic"; }
+    Tag tag() const override { return PLASTIC; }
+    const std::vector<MaterialField> &getFields() const override;
 
 
     vec3f Ks = { 1.f, 1.f, 1.f };
@@ -434,11 +508,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<Metal>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "Metal"; }
+    Tag tag() const override { return METAL; }
+    const std::vector<MaterialField> &getFields() const override;
 
     vec3f eta { 2.485f,2.485f,2.485f };
     vec3f k { 3.43f,3.43f,3.43f };
@@ -463,11 +535,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<Velvet>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "Velvet"; }
+    Tag tag() const override { return VELVET; }
+    const std::vector<MaterialField> &getFields() const override;
 
     vec3f reflectance { 0.55f, 0.0f, 0.0f };
     vec3f horizonScatteringColor { 0.75f, 0.2f, 0.2f };
@@ -493,11 +563,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<Dielectric>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "Dielectric"; }
+    Tag tag() const override { return DIELECTRIC; }
+    const std::vector<MaterialField> &getFields() const override;
 
     float etaInside = 1.45f;
     float etaOutside = 1.f;
@@ -521,11 +589,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<ThinGlass>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "ThinGlass"; }
+    Tag tag() const override { return THINGLASS; }
+    const std::vector<MaterialField> &getFields() const override;
     
     float eta = 1.45f;
     float thickness = 1.f;
@@ -550,11 +616,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<MetallicPaint>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "MetallicPaint"; }
+    Tag tag() const override { return METALLICPAINT; }
+    const std::vector<MaterialField> &getFields() const override;
     
     float eta = 1.45f;
     vec3f glitterColor { 0.055f, 0.16f, 0.25f };
@@ -580,11 +644,9 @@ namespace mini {
     /*! constructs a new Material that is a identical clone of the
       current material */
     Material::SP clone() const override { return std::make_shared<Matte>(*this); }
-    void write(std::ofstream &out,
-               const std::map<Texture::SP,int> &textures) override;
-    void read(std::ifstream &in,
-              const std::vector<Texture::SP> &textures) override;
     std::string toString() const override { return "Matte"; }
+    Tag tag() const override { return MATTE; }
+    const std::vector<MaterialField> &getFields() const override;
     
     vec3f reflectance { 0.5f,0.5f,0.5f };
   };
@@ -602,26 +664,110 @@ namespace mini {
     { return std::make_shared<Mesh>(material); }
     
     // bool   isEmissive() const { return material->isEmissive(); }
-    size_t getNumPrims() const { return indices.size(); }
+    size_t getNumPrims() const { return indices.size()+indices16.size(); }
 
     /*! computes a bounding box over all the triangles in this mesh */
     box3f getBounds() const;
 
+    /*! whether this mesh's triangles are stored in 'indices16'
+        rather than in 'indices' */
+    inline bool hasCompactIndices() const { return !indices16.empty(); }
+
+    /*! whether this mesh has few enough vertices for its indices to
+        fit into 16 bits */
+    inline bool canUseCompactIndices() const { return vertices.size() <= (1<<16); }
+    
+    /*! returns the vertex indices of the given triangle, no matter
+        which of the two index arrays they're stored in */
+    inline vec3i getIndex(size_t primID) const
+    { return indices16.empty() ? indices[primID] : vec3i(indices16[primID]); }
+
+    /*! moves the triangles from 'indices' to 'indices16', if the
+        number of vertices allows; returns whether the mesh now uses
+        16-bit indices */
+    bool compactIndices();
+
+    /*! moves the triangles (back) from 'indices16' to 'indices' */
+    void expandIndices();
+
+    /*! whether this mesh's normals and texcoords are stored in
+        'normalsOct' and 'texcoords16' */
+    inline bool hasCompactAttributes() const
+    { return !normalsOct.empty() || !texcoords16.empty(); }
+
+    inline size_t getNumNormals() const
+    { return normals.size()+normalsOct.size(); }
+    inline size_t getNumTexcoords() const
+    { return texcoords.size()+texcoords16.size(); }
+
+    /*! returns the i'th normal, no matter how it is stored */
+    inline vec3f getNormal(size_t i) const
+    {
+      return normalsOct.empty()
+        ? normals[i]
+        : vertex_formats::decodeOctNormal(normalsOct[i]);
+    }
+
+    /*! returns the i'th texture coordinate, no matter how it is stored */
+    inline vec2f getTexcoord(size_t i) const
+    {
+      return texcoords16.empty()
+        ? texcoords[i]
+        : vertex_formats::decodeTexcoord(texcoords16[i],texcoords16Format);
+    }
+
+    /*! writes all getNumNormals() normals to 'out', decoding them if
+        required */
+    void getNormals(vec3f *out) const;
+    
+    /*! writes all getNumTexcoords() texcoords to 'out', decoding them
+        if required */
+    void getTexcoords(vec2f *out) const;
+    
+    /*! (lossily) moves normals to 'normalsOct', and texcoords to
+        'texcoords16'; texcoords use UNORM16 if they're all in [0,1],
+        and half floats otherwise */
+    void compactAttributes();
+
+    /*! moves normals and texcoords (back) to 'normals' and
+        'texcoords' */
+    void expandAttributes();
+
     /*! array of vertices */
-    std::vector<vec3f> vertices;
+    CowVector<vec3f> vertices;
 
     /*! if this is the same size as number of vertices, then it's one
         vertex normal per vertex; otherwise if it is 3 times the
         number of indices then it's ANARI "faceVarying" normals */
-    std::vector<vec3f> normals;
+    CowVector<vec3f> normals;
     
     /*! if this is the same size as number of vertices, then it's one
         texture coordinate per vertex; otherwise if it is 3 times the
         number of indices then it's ANARI "faceVarying" texcoords */
-    std::vector<vec2f> texcoords;
+    CowVector<vec2f> texcoords;
+
+    /*! octahedral-encoded normals (see
+        vertex_formats::encodeOctNormal()), used instead of 'normals'
+        after compactAttributes(); at most one of the two is
+        non-empty, so code that may see such meshes should use
+        getNumNormals() and getNormal() */
+    CowVector<uint32_t> normalsOct;
+
+    /*! 16-bit texcoords (in the format given by 'texcoords16Format'),
+        used instead of 'texcoords' after compactAttributes(); at most
+        one of the two is non-empty */
+    CowVector<vec2us>   texcoords16;
+    vertex_formats::TexcoordFormat texcoords16Format = vertex_formats::TEXCOORDS_HALF;
     
     /*! the vector containing the triangles' vertex indices */
-    std::vector<vec3i> indices;
+    CowVector<vec3i> indices;
+
+    /*! the triangles' vertex indices for meshes with at most 64K
+        vertices (see compactIndices()). At most one of 'indices' and
+        'indices16' is non-empty; code that may see such meshes
+        should use getNumPrims() and getIndex() rather than accessing
+        'indices' directly. */
+    CowVector<vec3us> indices16;
 
     /*! the material to be applied to this mesh */
     Material::SP       material;
@@ -682,6 +828,54 @@ namespace mini {
     Object::SP object;
   };
 
+  /*! a struct-of-arrays version of a list of instances: one
+    contiguous array of transforms, and one of object IDs that index
+    into a dense table of the (unique) objects being instantiated. In
+    this form loops over (possibly millions of) instances can stream
+    through contiguous memory, without chasing a pointer (and
+    touching a shared_ptr reference count) per instance. Use
+    Scene::getInstanceArrays() and Scene::setInstances() to convert
+    from/to a scene's instances.
+
+    For scenes with very many instances the transforms can also be
+    kept in memory as CompactTransforms (16 rather than 48 bytes per
+    instance, see compact()); in that case 'xfms' is empty, and
+    getXfm() decodes them on the fly. */
+  struct InstanceArrays {
+    /*! object ID used for null instances (and instances of null
+      objects) */
+    static const uint32_t INVALID_ID = uint32_t(-1);
+
+    inline size_t size() const { return objectIDs.size(); }
+
+    /*! whether the transforms are stored in 'compactXfms' (rather
+      than in 'xfms') */
+    inline bool isCompact() const { return xfms.size() != objectIDs.size(); }
+
+    /*! returns the i'th instance's transform, no matter in which
+      form the transforms are stored */
+    inline affine3f getXfm(size_t i) const
+    { return isCompact() ? compactXfms.decode(i) : xfms[i]; }
+
+    /*! converts the transforms to compact form, releasing the memory
+      of 'xfms'; see CompactTransforms::encode() for the meaning of
+      'maxQuantizationError'. No-op if already compact. */
+    void compact(float maxQuantizationError=-1.f);
+
+    /*! converts compact transforms back into plain 'xfms'. No-op if
+      not compact. */
+    void expand();
+    
+    /*! one transform per instance; empty if isCompact() */
+    std::vector<affine3f>   xfms;
+    /*! all instances' transforms, if isCompact(); else empty */
+    CompactTransforms       compactXfms;
+    /*! one object ID per instance, indexing into 'objects' */
+    std::vector<uint32_t>   objectIDs;
+    /*! the unique objects, in order of their first use */
+    std::vector<Object::SP> objects;
+  };
+  
   /*! a quadrilateral area light that emits light into the direction
     pointed to by the normal. The light shape is given by an
     "anchor" point describing one of the corners of the light
@@ -743,6 +937,146 @@ namespace mini {
     affine3f    transform;
   };
 
+  /*! how well the arrays of a scene compressed when it got saved
+    (see SaveOptions::compressionStats) */
+  struct CompressionStats {
+    struct Array {
+      /*! ratio of raw to stored size */
+      inline double ratio() const
+      { return storedBytes ? rawBytes/double(storedBytes) : 1.; }
+
+      /*! number of arrays of this kind */
+      size_t numArrays     = 0;
+      /*! how many of those got stored compressed; for the others,
+          compression wouldn't have made them any smaller */
+      size_t numCompressed = 0;
+      size_t rawBytes      = 0;
+      size_t storedBytes   = 0;
+    };
+    /*! adds one array with given sizes */
+    void add(const std::string &kind, size_t rawBytes, size_t storedBytes,
+             bool compressed);
+    /*! adds all arrays of 'other' */
+    void add(const CompressionStats &other);
+
+    /*! per kind of array: "indices", "vertices", "normals", or
+        "texcoords" */
+    std::map<std::string,Array> arrays;
+  };
+
+  /*! options that control how Scene::save() encodes a scene. Every
+    encoding that older versions of this library can't read gets
+    recorded as a 'feature' flag in the file, and requires a reader
+    that knows this feature; files that don't end up using any such
+    feature get written in the plain (version 12) format - which is
+    what the default options do. */
+  struct SaveOptions {
+    /*! store instance transforms as CompactTransforms (a palette of
+      unique linear parts, plus one translation and one 32-bit
+      reference per instance) rather than as one affine3f each. Note
+      this only affects the file; to keep a loaded scene's transforms
+      in that form in memory, see InstanceArrays::compact() */
+    bool  compactTransforms = false;
+    /*! if >= 0 (and compactTransforms is set), linear parts that
+      are a rotation plus uniform scale may get quantized, as long as
+      no matrix entry changes by more than this (relative to the
+      scale); see CompactTransforms::encode() */
+    float transformQuantizationError = -1.f;
+    /*! store the indices of meshes with at most 64K vertices
+      (including all meshes that use 16-bit indices in memory) as
+      16-bit values; if not set, all indices get stored as 32-bit
+      values, so older readers can read the file */
+    bool  compactIndices = false;
+    /*! store each mesh's indices losslessly compressed (see
+      codecs::CompressedIndices), unless that wouldn't make them any
+      smaller than storing them as they are */
+    bool  compressIndices = false;
+    /*! store each mesh's vertices, normals, and texcoords losslessly
+      compressed (see codecs::CompressedFloats), unless that wouldn't
+      make them any smaller; arrays that get quantized are not
+      affected */
+    bool  compressFloats = false;
+    /*! if non-null, this gets the sizes of all arrays that got
+      considered for compression */
+    CompressionStats *compressionStats = nullptr;
+    /*! if not BLOCK_COMPRESSION_NONE, the whole file gets written
+      as a block-compressed container (see io::BlockWriteBuffer),
+      with blocks of 'blockSize' bytes (before compression) each.
+      This is independent of (and can be combined with) all other
+      options. Scene::load() recognizes such files automatically */
+    BlockCompression blockCompression = BLOCK_COMPRESSION_NONE;
+    size_t           blockSize        = (2<<20);
+    /*! store a checksum with every texture and mesh (and the other
+      parts of the file; see RecordKind), plus a table of all of them
+      at the end of the file, so files can get verified (see
+      LoadOptions::verifyChecksums, and miniVerify) and corruption
+      pinned down to the affected object. With blockCompression, also
+      stores a checksum with every block */
+    bool  checksums = false;
+    /*! if >= 0, store each mesh's vertex positions quantized to 16
+      or 21 bits per component (relative to the mesh's bounds), with
+      the fewest bits that keep every coordinate within this
+      (absolute, object-space) error; meshes for which even 21 bits
+      aren't enough get stored unquantized */
+    float positionQuantizationError = -1.f;
+    /*! store normals octahedral-encoded, and texcoords as 16-bit
+      values (see Mesh::compactAttributes(); note this is lossy).
+      With either this or positionQuantizationError set, meshes that
+      already use compact attributes in memory get stored as they
+      are, rather than expanded */
+    bool  quantizeAttributes = false;
+    /*! if > 1, the scene gets saved 'striped': the file itself only
+      gets a manifest, and the textures and meshes - which usually
+      are almost all of the data - get spread over this many stripe
+      files next to it ("<fileName>.stripe<i>"), balanced by size.
+      Stripes get written (and later loaded) in parallel, so on a
+      parallel file system they can be on different storage targets.
+      Only supported by save(fileName). With checksums, every stripe
+      gets checksums (and a checksum table) of its own; with
+      blockCompression, each stripe (but not the manifest) is
+      block-compressed. save(fileName) removes the stripe files an
+      earlier save to the same file name may have left behind beyond
+      the ones it writes (all of them, if not striped) */
+    int   numStripes = 1;
+    /*! to monitor and/or cancel the save; if cancelled, save()
+      throws Cancelled, and leaves an incomplete file */
+    Progress progress;
+  };
+
+  /*! name of the file with stripe #stripeID of the striped scene
+    (see SaveOptions::numStripes) that got saved as 'fileName' */
+  inline std::string stripeFileName(const std::string &fileName, int stripeID)
+  { return fileName+".stripe"+std::to_string(stripeID); }
+
+  /*! options that control how Scene::load() builds the in-memory
+    scene */
+  struct LoadOptions {
+    /*! if set, every mesh with at most 64K vertices gets its indices
+      stored in Mesh::indices16; else, all meshes get their indices
+      in Mesh::indices (no matter how they were stored in the
+      file) */
+    bool compactIndices = false;
+    /*! if set, every mesh's normals and texcoords get stored in
+      compact form (see Mesh::compactAttributes()); note this is
+      lossy */
+    bool compactAttributes = false;
+    /*! how to place the (large) mesh and texture arrays on the NUMA
+      nodes of a multi-socket machine (see NumaPlacement); with
+      NUMA_DEFAULT, whatever memory::setNumaPlacement() says */
+    NumaPlacement numaPlacement = NUMA_DEFAULT;
+    /*! for files that were saved with checksums: verify them, and
+      throw (saying which texture, mesh, etc is affected) upon the
+      first mismatch, or if anything else goes wrong reading the
+      file. For seekable streams (files, memory) everything gets
+      verified before any of it gets used; from non-seekable ones,
+      each part only gets verified after it was read. Checksums of
+      block-compressed files' blocks always get verified */
+    bool verifyChecksums = false;
+    /*! to monitor and/or cancel the load; if cancelled, load()
+      throws Cancelled */
+    Progress progress;
+  };
+
   /*! a complete scene, consisting of a list of instances (may be a
     single one if the scene doesn't use instantiation), and some
     light sources */
@@ -765,12 +1099,83 @@ namespace mini {
       while */
     box3f getBounds() const;
 
-    /*! loads a ".mini" file from the given file */
-    static Scene::SP load(const std::string &fileName);
+    /*! same as getBounds(), but reports its progress to, and can be
+      cancelled through, the given Progress; throws Cancelled if
+      cancelled */
+    box3f getBounds(const Progress &progress) const;
+
+    /*! returns a struct-of-arrays copy of this scene's instances
+      (with transforms and object IDs in contiguous arrays) for
+      loops that have to stream over all instances */
+    InstanceArrays getInstanceArrays() const;
+
+    /*! same as getInstanceArrays(), but reports its progress to, and
+      can be cancelled through, the given Progress; throws Cancelled
+      if cancelled */
+    InstanceArrays getInstanceArrays(const Progress &progress) const;
+
+    /*! replaces this scene's instances with the ones described in the
+      given struct-of-arrays instance list */
+    void setInstances(const InstanceArrays &arrays);
+    
+    /*! function that reads up to 'maxBytes' bytes into 'dst', and
+      returns how many it actually read; returning 0 means end of
+      data */
+    typedef std::function<size_t(void *dst, size_t maxBytes)> ReadCallback;
+    
+    /*! function that has to consume all of the 'numBytes' bytes at
+      'src'; errors should be reported by throwing an exception */
+    typedef std::function<void(const void *src, size_t numBytes)> WriteCallback;
+    
+    /*! loads a ".mini" file from the given file; for a striped
+      scene (see SaveOptions::numStripes), all stripes get loaded in
+      parallel */
+    static Scene::SP load(const std::string &fileName,
+                          const LoadOptions &options=LoadOptions());
+    
+    /*! loads a ".mini" scene from the given input stream; reading
+      starts at the stream's current position. Striped scenes can
+      only get loaded by file name */
+    static Scene::SP load(std::istream &in,
+                          const LoadOptions &options=LoadOptions());
+    
+    /*! loads a ".mini" scene from a memory region that contains the
+      entire content of a ".mini" file (e.g., a file that was
+      mmap'ed, or that got cached in memory) */
+    static Scene::SP load(const void *data, size_t numBytes,
+                          const LoadOptions &options=LoadOptions());
+    
+    /*! loads a ".mini" scene whose bytes get provided, in order, by
+      the given read callback */
+    static Scene::SP load(const ReadCallback &read,
+                          const LoadOptions &options=LoadOptions());
+
+    /*! verifies the integrity of a ".mini" file that was saved with
+      SaveOptions::checksums, without loading it: checks the
+      checksums of all of its blocks (for a block-compressed file)
+      and of all of its textures, meshes, etc, in parallel. Returns a
+      description of every problem found (e.g., "checksum mismatch
+      in mesh #3 of object #12"), so an empty list means the file is
+      intact. For a striped scene, also verifies all of its stripe
+      files. Throws if the file can't get verified at all (e.g.,
+      because it doesn't have checksums) */
+    static std::vector<std::string> verify(const std::string &fileName,
+                                           const Progress &progress=Progress());
 
     /*! saves the model in file with given name, using a binary file
       format that can be loaded with Scene::load() */
-    void save(const std::string &fileName);
+    void save(const std::string &fileName,
+              const SaveOptions &options=SaveOptions());
+
+    /*! writes the model (in the same format as save(fileName)) to the
+      given output stream */
+    void save(std::ostream &out,
+              const SaveOptions &options=SaveOptions());
+
+    /*! writes the model (in the same format as save(fileName)) by
+      pushing its bytes, in order, to the given write callback */
+    void save(const WriteCallback &write,
+              const SaveOptions &options=SaveOptions());
       
     std::vector<QuadLight>  quadLights;
     std::vector<DirLight>   dirLights;
@@ -0,0 +1,111 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/SceneBuilder.h"
+#include <algorithm>
+#include <thread>
+
+namespace mini {
+
+  SceneBuilder::SceneBuilder(int numShards)
+  {
+    if (numShards <= 0)
+      numShards = 4*std::max(1,(int)std::thread::hardware_concurrency());
+    for (int i=0;i<numShards;i++)
+      shards.push_back(std::unique_ptr<Shard>(new Shard));
+  }
+
+  SceneBuilder::Shard &SceneBuilder::myShard()
+  {
+    size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return *shards[hash % shards.size()];
+  }
+
+  void SceneBuilder::addInstance(uint64_t key, const Instance::SP &instance)
+  {
+    Shard &shard = myShard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.instances.push_back({key,instance});
+  }
+
+  void SceneBuilder::addMesh(const Object::SP &object, uint64_t key, const Mesh::SP &mesh)
+  {
+    Shard &shard = myShard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.meshes.push_back({key,{object,mesh}});
+  }
+
+  void SceneBuilder::addQuadLight(uint64_t key, const QuadLight &light)
+  {
+    Shard &shard = myShard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.quadLights.push_back({key,light});
+  }
+
+  void SceneBuilder::addDirLight(uint64_t key, const DirLight &light)
+  {
+    Shard &shard = myShard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.dirLights.push_back({key,light});
+  }
+
+  /*! moves the given per-shard lists into one list, sorted by key */
+  template<typename T, typename Shard>
+  std::vector<T> gatherSorted(std::vector<std::unique_ptr<Shard>> &shards,
+                              std::vector<T> Shard::*list)
+  {
+    size_t count = 0;
+    for (auto &shard : shards)
+      count += ((*shard).*list).size();
+    std::vector<T> all;
+    all.reserve(count);
+    for (auto &shard : shards) {
+      std::vector<T> &items = (*shard).*list;
+      std::move(items.begin(),items.end(),std::back_inserter(all));
+      std::vector<T>().swap(items);
+    }
+    std::sort(all.begin(),all.end(),
+              [](const T &a, const T &b) { return a.key < b.key; });
+    return all;
+  }
+
+  Scene::SP SceneBuilder::finalize()
+  {
+    Scene::SP scene = Scene::create();
+
+    auto instances = gatherSorted(shards,&Shard::instances);
+    scene->instances.resize(instances.size());
+    parallel_for_blocked
+      ((size_t)0,instances.size(),16*1024,
+       [&](size_t begin, size_t end) {
+         for (size_t i=begin;i<end;i++)
+           scene->instances[i] = std::move(instances[i].item);
+       });
+
+    // meshes get appended in key order; since that's the order we
+    // append them in, each object's meshes end up in key order, too
+    auto meshes = gatherSorted(shards,&Shard::meshes);
+    for (auto &mesh : meshes)
+      mesh.item.object->meshes.push_back(mesh.item.mesh);
+
+    for (auto &light : gatherSorted(shards,&Shard::quadLights))
+      scene->quadLights.push_back(light.item);
+    for (auto &light : gatherSorted(shards,&Shard::dirLights))
+      scene->dirLights.push_back(light.item);
+    return scene;
+  }
+
+} // ::mini
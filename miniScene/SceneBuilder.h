@@ -0,0 +1,92 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/Scene.h"
+
+namespace mini {
+
+  /*! helper for importers that want to create a scene from multiple
+      threads: each thread can add instances (and meshes to objects)
+      concurrently, without any locking of its own. Every item gets
+      added with a 'key' (e.g., the index of the shape it was created
+      from in the input file), and finalize() puts all items in order
+      of their keys - so the resulting scene is the same no matter
+      how the threads got scheduled, as long as the keys are unique.
+
+      Internally, items get appended to one of several 'shards'
+      (picked by thread ID), each with its own mutex, so threads
+      rarely ever wait for each other. */
+  struct SceneBuilder {
+    typedef std::shared_ptr<SceneBuilder> SP;
+
+    /*! creates a new builder; with numShards=0 we use a few shards
+        per hardware thread */
+    static SP create(int numShards=0)
+    { return std::make_shared<SceneBuilder>(numShards); }
+
+    SceneBuilder(int numShards=0);
+
+    /*! adds an instance; thread-safe */
+    void addInstance(uint64_t key, const Instance::SP &instance);
+
+    /*! adds an instance of the given object; thread-safe */
+    inline void addInstance(uint64_t key,
+                            const Object::SP &object,
+                            const affine3f &xfm=affine3f())
+    { addInstance(key,Instance::create(object,xfm)); }
+
+    /*! adds a mesh to the given object; the object's meshes will be
+        in key order (after any meshes the object already had).
+        Thread-safe, also for different threads adding to the same
+        object */
+    void addMesh(const Object::SP &object, uint64_t key, const Mesh::SP &mesh);
+
+    /*! adds light sources; thread-safe */
+    void addQuadLight(uint64_t key, const QuadLight &light);
+    void addDirLight(uint64_t key, const DirLight &light);
+
+    /*! creates the scene from everything that was added so far, and
+        resets the builder. Must not run concurrently with any of the
+        add..() calls. */
+    Scene::SP finalize();
+
+  private:
+    template<typename T>
+    struct Keyed {
+      uint64_t key;
+      T        item;
+    };
+    struct ObjectMesh {
+      Object::SP object;
+      Mesh::SP   mesh;
+    };
+    struct Shard {
+      std::mutex                           mutex;
+      std::vector<Keyed<Instance::SP>>     instances;
+      std::vector<Keyed<ObjectMesh>>       meshes;
+      std::vector<Keyed<QuadLight>>        quadLights;
+      std::vector<Keyed<DirLight>>         dirLights;
+    };
+
+    /*! the shard the calling thread should append to */
+    Shard &myShard();
+
+    std::vector<std::unique_ptr<Shard>> shards;
+  };
+
+} // ::mini
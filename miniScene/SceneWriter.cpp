@@ -0,0 +1,273 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/SceneWriter.h"
+#include "miniScene/FileFormat.h"
+
+namespace mini {
+
+  using namespace format;
+
+  SceneWriter::SceneWriter(const std::string &fileName,
+                           const SaveOptions &options)
+    : out(fileName,std::ios::binary),
+      fileName(fileName),
+      options(options)
+  {
+    if (!out.good())
+      throw std::runtime_error("could not open file '"+fileName+"'");
+    if (options.compactTransforms)
+      throw std::runtime_error("SceneWriter does not support compact transforms");
+    if (options.blockCompression != BLOCK_COMPRESSION_NONE)
+      throw std::runtime_error("SceneWriter does not support block compression");
+    if (options.checksums)
+      throw std::runtime_error("SceneWriter does not support checksums");
+    if (options.numStripes > 1)
+      throw std::runtime_error("SceneWriter does not support striped scenes");
+
+    // we don't know yet whether any mesh will end up with 16-bit
+    // indices, so go by the options alone
+    if (options.compactIndices)
+      features |= FEATURE_INDEX16;
+    if (options.positionQuantizationError >= 0.f || options.quantizeAttributes)
+      features |= FEATURE_QUANTIZED_GEOMETRY;
+    if (options.compressIndices)
+      features |= FEATURE_COMPRESSED_INDICES;
+    if (options.compressFloats)
+      features |= FEATURE_COMPRESSED_FLOATS;
+    magic = features ? expected_magic : magic_v12;
+    io::writeElement(out,magic);
+    if (features)
+      io::writeElement(out,features);
+
+    numTexturesPos = beginCount();
+    // texture 0 is always the null texture
+    textures[nullptr] = 0;
+    io::writeElement(out,int(0));
+  }
+
+  std::streampos SceneWriter::beginCount()
+  {
+    std::streampos pos = out.tellp();
+    io::writeElement(out,size_t(0));
+    return pos;
+  }
+
+  void SceneWriter::patchCount(std::streampos pos, size_t count)
+  {
+    std::streampos end = out.tellp();
+    out.seekp(pos);
+    io::writeElement(out,count);
+    out.seekp(end);
+  }
+
+  int SceneWriter::addTexture(const Texture::SP &texture)
+  {
+    auto it = textures.find(texture);
+    if (it != textures.end())
+      return it->second;
+    if (section != TEXTURES)
+      throw std::runtime_error("SceneWriter: cannot add textures after the first object");
+
+    int ID = (int)textures.size();
+    textures[texture] = ID;
+    io::writeElement(out,int(1));
+    writeTexture(out,*texture);
+    return ID;
+  }
+
+  void SceneWriter::addQuadLight(const QuadLight &light)
+  {
+    if (section != TEXTURES)
+      throw std::runtime_error("SceneWriter: cannot add lights after the first object");
+    quadLights.push_back(light);
+  }
+
+  void SceneWriter::addDirLight(const DirLight &light)
+  {
+    if (section != TEXTURES)
+      throw std::runtime_error("SceneWriter: cannot add lights after the first object");
+    dirLights.push_back(light);
+  }
+
+  void SceneWriter::setEnvMapLight(const EnvMapLight::SP &envMapLight)
+  {
+    if (section != TEXTURES)
+      throw std::runtime_error("SceneWriter: cannot add lights after the first object");
+    if (envMapLight && !envMapLight->texture)
+      throw std::runtime_error("SceneWriter: env-map light without a texture");
+    this->envMapLight = envMapLight;
+  }
+
+  int SceneWriter::findMaterialID(const Material::SP &material) const
+  {
+    auto it = materialIDs.find(material.get());
+    if (it == materialIDs.end() || it->second.material.expired())
+      return -1;
+    return it->second.ID;
+  }
+  
+  int SceneWriter::addMaterial(const Material::SP &material)
+  {
+    if (!material)
+      throw std::runtime_error("SceneWriter: null material");
+    const int knownID = findMaterialID(material);
+    if (knownID >= 0)
+      return knownID;
+    if (section != TEXTURES)
+      throw std::runtime_error("SceneWriter: material was not added before the first object");
+
+    // same textures the SerializedScene would pick up
+    for (auto &field : material->getFields())
+      if (field.type == MaterialField::TEXTURE)
+        addTexture(material->get<Texture::SP>(field));
+
+    int ID = (int)materials.size();
+    materialIDs[material.get()] = { ID, material };
+    materials.push_back(material);
+    return ID;
+  }
+
+  void SceneWriter::advanceTo(Section target)
+  {
+    if (section > target)
+      throw std::runtime_error("SceneWriter: scene parts added out of order");
+    if (inObject && target > OBJECTS)
+      throw std::runtime_error("SceneWriter: object was not ended");
+
+    while (section < target) {
+      switch (section) {
+      case TEXTURES: {
+        patchCount(numTexturesPos,textures.size());
+
+        io::writeVector(out,quadLights);
+        io::writeVector(out,dirLights);
+        if (envMapLight) {
+          io::writeElement(out,int(1));
+          io::writeElement(out,envMapLight->transform);
+          writeTexture(out,*envMapLight->texture);
+        } else
+          io::writeElement(out,int(0));
+        quadLights.clear();
+        dirLights.clear();
+        envMapLight = nullptr;
+        section = MATERIALS;
+      } break;
+      case MATERIALS: {
+        io::writeElement(out,materials.size());
+        for (auto mat : materials) {
+          io::writeElement(out,(int)mat->tag());
+          mat->write(out,textures);
+        }
+        // from now on we only need the material IDs; the materials'
+        // and textures' data is on disk already, so don't keep them
+        // alive (materialIDs only holds weak references)
+        textures.clear();
+        materials.clear();
+        numObjectsPos = beginCount();
+        section = OBJECTS;
+      } break;
+      case OBJECTS: {
+        patchCount(numObjectsPos,numObjects);
+        numInstancesPos = beginCount();
+        section = INSTANCES;
+      } break;
+      case INSTANCES: {
+        patchCount(numInstancesPos,numInstances);
+        section = DONE;
+      } break;
+      default:
+        assert(0);
+      }
+    }
+  }
+
+  void SceneWriter::beginObject()
+  {
+    if (inObject)
+      throw std::runtime_error("SceneWriter: previous object was not ended");
+    advanceTo(OBJECTS);
+    inObject = true;
+    numMeshesInObject = 0;
+    numMeshesPos = beginCount();
+  }
+
+  void SceneWriter::addMesh(const Mesh::SP &mesh)
+  {
+    if (!inObject)
+      throw std::runtime_error("SceneWriter: addMesh() outside of an object");
+    numMeshesInObject++;
+    if (!mesh) { io::writeElement(out,int(0)); return; }
+
+    const int materialID = findMaterialID(mesh->material);
+    if (materialID < 0)
+      throw std::runtime_error("SceneWriter: mesh uses a material that was not added before the first object");
+    io::writeElement(out,int(1));
+    writeMesh(out,*mesh,materialID,features,options);
+  }
+
+  int SceneWriter::endObject()
+  {
+    if (!inObject)
+      throw std::runtime_error("SceneWriter: endObject() without beginObject()");
+    patchCount(numMeshesPos,numMeshesInObject);
+    inObject = false;
+    return (int)numObjects++;
+  }
+
+  int SceneWriter::addObject(const Object::SP &object)
+  {
+    if (section == TEXTURES)
+      for (auto mesh : object->meshes)
+        if (mesh) addMaterial(mesh->material);
+
+    beginObject();
+    for (auto mesh : object->meshes)
+      addMesh(mesh);
+    return endObject();
+  }
+
+  void SceneWriter::addInstance(int objectID, const affine3f &xfm)
+  {
+    if (objectID < 0 || objectID >= (int)numObjects)
+      throw std::runtime_error("SceneWriter: invalid object ID "+std::to_string(objectID));
+    advanceTo(INSTANCES);
+    numInstances++;
+    io::writeElement(out,int(1));
+    io::writeElement(out,xfm);
+    io::writeElement(out,objectID);
+  }
+
+  void SceneWriter::addNullInstance()
+  {
+    advanceTo(INSTANCES);
+    numInstances++;
+    io::writeElement(out,int(0));
+  }
+
+  void SceneWriter::finalize()
+  {
+    if (section == DONE)
+      throw std::runtime_error("SceneWriter: finalize() called twice");
+    advanceTo(DONE);
+    io::writeElement(out,magic);
+    out.flush();
+    if (!out.good())
+      throw std::runtime_error("some error happened while writing '"+fileName+"'");
+    out.close();
+  }
+
+} // ::mini
@@ -0,0 +1,144 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/Scene.h"
+#include <fstream>
+
+namespace mini {
+
+  /*! writes a .mini file incrementally, so importers can emit a scene
+      piece by piece without ever having the whole scene in memory:
+      every mesh gets written out as soon as it's added, and can be
+      released by the caller right after. Loading the resulting file
+      gives the same scene Scene::save() would have written.
+
+      Since the file stores textures, lights, materials, objects, and
+      instances in that order, things have to get added in that order,
+      too:
+
+      - all textures, lights, and materials have to be added before
+        the first object. If that first object gets added via
+        addObject(), the materials of its meshes get added
+        automatically, and every material's textures (see
+        Material::getFields()) get added along with the material;
+
+      - all objects (and their meshes) have to be added before the
+        first instance.
+
+      Adding something out of order throws a std::runtime_error. A
+      SceneWriter is not thread-safe. Of the SaveOptions, all but
+      'compactTransforms' (which needs all instances at once),
+      'blockCompression' and 'checksums' (the writer needs to go back
+      and patch in element counts), and 'numStripes' are
+      supported. */
+  struct SceneWriter {
+    typedef std::shared_ptr<SceneWriter> SP;
+
+    static SP create(const std::string &fileName,
+                     const SaveOptions &options=SaveOptions())
+    { return std::make_shared<SceneWriter>(fileName,options); }
+
+    SceneWriter(const std::string &fileName,
+                const SaveOptions &options=SaveOptions());
+
+    /*! adds a texture, and returns its ID */
+    int addTexture(const Texture::SP &texture);
+
+    void addQuadLight(const QuadLight &light);
+    void addDirLight(const DirLight &light);
+    void setEnvMapLight(const EnvMapLight::SP &envMapLight);
+
+    /*! adds a material (and all of its textures that weren't added
+        yet), and returns its ID; adding the same material again just
+        returns its ID */
+    int addMaterial(const Material::SP &material);
+
+    /*! starts a new object, whose meshes can then be added (and
+        written) one at a time, via addMesh() */
+    void beginObject();
+    /*! writes given mesh (which may be null) as the next mesh of the
+        current object; the mesh can be released right after */
+    void addMesh(const Mesh::SP &mesh);
+    /*! ends the current object, and returns its ID */
+    int endObject();
+
+    /*! writes the given object and all its meshes; returns the
+        object's ID */
+    int addObject(const Object::SP &object);
+
+    /*! adds an instance of the object with given ID */
+    void addInstance(int objectID, const affine3f &xfm=affine3f());
+    /*! adds a null instance */
+    void addNullInstance();
+
+    /*! writes whatever is still missing, and closes the file. The
+        file is not a valid .mini file until this was called. */
+    void finalize();
+
+  private:
+    typedef enum { TEXTURES, MATERIALS, OBJECTS, INSTANCES, DONE } Section;
+
+    /*! writes all sections up to (but excluding) the given one */
+    void advanceTo(Section section);
+
+    /*! writes a placeholder element count, and returns where it is */
+    std::streampos beginCount();
+    /*! overwrites the count at given position */
+    void patchCount(std::streampos pos, size_t count);
+
+    std::ofstream out;
+    std::string   fileName;
+    SaveOptions   options;
+    uint64_t      features = 0;
+    size_t        magic;
+    Section       section = TEXTURES;
+
+    std::map<Texture::SP,int>  textures;
+    std::streampos             numTexturesPos;
+
+    std::vector<QuadLight>     quadLights;
+    std::vector<DirLight>      dirLights;
+    EnvMapLight::SP            envMapLight;
+
+    /*! returns the ID of the given material, or -1 if it wasn't
+        added */
+    int findMaterialID(const Material::SP &material) const;
+    
+    /*! every added material's ID, by identity. These only hold weak
+        references, so once the materials are written (and
+        'materials' cleared) they - and their textures - can get
+        released; an expired entry means its address may have been
+        reused for a different material */
+    struct MaterialEntry {
+      int                     ID;
+      std::weak_ptr<Material> material;
+    };
+    std::map<const Material *,MaterialEntry> materialIDs;
+    std::vector<Material::SP>  materials;
+
+    size_t         numObjects = 0;
+    std::streampos numObjectsPos;
+    bool           inObject = false;
+    size_t         numMeshesInObject = 0;
+    std::streampos numMeshesPos;
+
+    size_t         numInstances = 0;
+    std::streampos numInstancesPos;
+  };
+
+} // ::mini
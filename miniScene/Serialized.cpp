@@ -36,16 +36,9 @@ namespace mini {
           assert(material);
           if (materials.addWasKnown(material)) continue;
 
-          DisneyMaterial::SP disney = material->as<DisneyMaterial>();
-          if (disney) {
-            textures.add(disney->colorTexture);
-            textures.add(disney->alphaTexture);
-          }
-          BlenderMaterial::SP blender = material->as<BlenderMaterial>();
-          if (blender) {
-            textures.add(blender->baseColorTexture);
-            textures.add(blender->alphaTexture);
-          }
+          for (auto &field : material->getFields())
+            if (field.type == MaterialField::TEXTURE)
+              textures.add(material->get<Texture::SP>(field));
         }
       }
     }
@@ -29,12 +29,13 @@ namespace mini {
     inline const T &operator[](int ID) const
     { assert(ID>=0); assert(ID<list.size()); return list[ID]; }
       
-    int getID(T t)
+    /*! returns the ID of given object, or -1 if not known. Only
+        reads the registry, so this is safe to call from multiple
+        threads as long as nobody adds to it at the same time */
+    int getID(const T &t) const
     {
-      if (registry.find(t) == registry.end())
-        return -1;
-
-      return registry[t];
+      auto it = registry.find(t);
+      return it == registry.end() ? -1 : it->second;
     }
       
     inline bool wasKnown(T t) const
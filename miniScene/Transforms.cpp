@@ -0,0 +1,225 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Transforms.h"
+#include <unordered_map>
+
+namespace mini {
+
+  const uint32_t CompactTransforms::QUANTIZED_BIT;
+
+  /*! hashes a linear space by its bit pattern, so the palette
+      contains only bit-wise identical entries, and stays lossless */
+  struct LinearSpaceHash {
+    size_t operator()(const LinearSpace3f &l) const
+    {
+      const uint32_t *bits = (const uint32_t *)&l;
+      size_t hash = 0;
+      for (int i=0;i<9;i++)
+        hash = hash * 0x9e3779b97f4a7c15ull + bits[i];
+      return hash;
+    }
+  };
+
+  struct LinearSpaceEqual {
+    bool operator()(const LinearSpace3f &a, const LinearSpace3f &b) const
+    { return memcmp(&a,&b,sizeof(a)) == 0; }
+  };
+
+  /*! converts a (proper, orthonormal) rotation matrix to a
+      quaternion; this is the inverse of the LinearSpace3f(quaternion)
+      constructor */
+  inline Quaternion3f quaternionFrom(const LinearSpace3f &m)
+  {
+    // m.vx etc are the matrix' _columns_, so entry (row,col) is
+    // m.v<col>.<row>
+    const float trace = m.vx.x + m.vy.y + m.vz.z;
+    if (trace > 0.f) {
+      const float s = 2.f*sqrtf(1.f+trace);
+      return Quaternion3f(.25f*s,
+                          (m.vy.z-m.vz.y)/s,
+                          (m.vz.x-m.vx.z)/s,
+                          (m.vx.y-m.vy.x)/s);
+    } else if (m.vx.x > m.vy.y && m.vx.x > m.vz.z) {
+      const float s = 2.f*sqrtf(1.f+m.vx.x-m.vy.y-m.vz.z);
+      return Quaternion3f((m.vy.z-m.vz.y)/s,
+                          .25f*s,
+                          (m.vy.x+m.vx.y)/s,
+                          (m.vz.x+m.vx.z)/s);
+    } else if (m.vy.y > m.vz.z) {
+      const float s = 2.f*sqrtf(1.f+m.vy.y-m.vx.x-m.vz.z);
+      return Quaternion3f((m.vz.x-m.vx.z)/s,
+                          (m.vy.x+m.vx.y)/s,
+                          .25f*s,
+                          (m.vz.y+m.vy.z)/s);
+    } else {
+      const float s = 2.f*sqrtf(1.f+m.vz.z-m.vx.x-m.vy.y);
+      return Quaternion3f((m.vx.y-m.vy.x)/s,
+                          (m.vz.x+m.vx.z)/s,
+                          (m.vz.y+m.vy.z)/s,
+                          .25f*s);
+    }
+  }
+
+  inline Quaternion3f normalized(const Quaternion3f &q)
+  { return q * (1.f/sqrtf(q.r*q.r+q.i*q.i+q.j*q.j+q.k*q.k)); }
+
+  inline short quantizeSNorm(float f)
+  { return (short)roundf(std::max(-1.f,std::min(1.f,f))*32767.f); }
+
+  inline LinearSpace3f decodeQuantized(const CompactTransforms::QuantizedLinear &q)
+  {
+    Quaternion3f rot(q.rotation.x/32767.f,
+                     q.rotation.y/32767.f,
+                     q.rotation.z/32767.f,
+                     q.rotation.w/32767.f);
+    return q.scale * LinearSpace3f(normalized(rot));
+  }
+
+  inline float maxAbsDifference(const LinearSpace3f &a, const LinearSpace3f &b)
+  {
+    const float *fa = (const float *)&a;
+    const float *fb = (const float *)&b;
+    float maxDiff = 0.f;
+    for (int i=0;i<9;i++)
+      maxDiff = std::max(maxDiff,fabsf(fa[i]-fb[i]));
+    return maxDiff;
+  }
+
+  /*! tries to express given linear transform as uniform scale times
+      a (quantized) rotation; returns false if that's not possible
+      within the given error bound (e.g., because the transform has
+      non-uniform scale or shear) */
+  bool tryQuantize(const LinearSpace3f &l,
+                   float maxError,
+                   CompactTransforms::QuantizedLinear &q)
+  {
+    const float d = l.det();
+    if (!(fabsf(d) > 0.f) || std::isinf(d)) return false;
+    // a negative scale also covers transforms that mirror
+    const float scale = cbrtf(d);
+    Quaternion3f rot = normalized(quaternionFrom(l / scale));
+    // q and -q are the same rotation; pick one
+    if (rot.r < 0.f) rot = -rot;
+    q.rotation = vec4s(quantizeSNorm(rot.r),
+                       quantizeSNorm(rot.i),
+                       quantizeSNorm(rot.j),
+                       quantizeSNorm(rot.k));
+    q.scale = scale;
+    return maxAbsDifference(decodeQuantized(q),l) <= maxError*fabsf(scale);
+  }
+
+  CompactTransforms CompactTransforms::encode(const std::vector<affine3f> &xfms,
+                                              float maxQuantizationError)
+  {
+    CompactTransforms result;
+    result.translations.resize(xfms.size());
+    result.linearRefs.resize(xfms.size());
+
+    // ------------------------------------------------------------------
+    // find the unique linear parts (serial, but only a hash lookup per
+    // transform), and how often each of them gets used
+    // ------------------------------------------------------------------
+    std::unordered_map<LinearSpace3f,uint32_t,LinearSpaceHash,LinearSpaceEqual> uniqueIDs;
+    std::vector<LinearSpace3f> unique;
+    std::vector<uint32_t>      useCount;
+    for (size_t i=0;i<xfms.size();i++) {
+      auto it = uniqueIDs.find(xfms[i].l);
+      uint32_t uniqueID;
+      if (it == uniqueIDs.end()) {
+        uniqueID = (uint32_t)unique.size();
+        uniqueIDs[xfms[i].l] = uniqueID;
+        unique.push_back(xfms[i].l);
+        useCount.push_back(0);
+      } else
+        uniqueID = it->second;
+      useCount[uniqueID]++;
+      result.translations[i] = xfms[i].p;
+      // for now, this refers to the unique linear part; gets remapped
+      // below
+      result.linearRefs[i] = uniqueID;
+    }
+
+    // ------------------------------------------------------------------
+    // try to quantize those that are used only once - if a linear part
+    // is shared it's cheaper to store it exactly in the palette
+    // ------------------------------------------------------------------
+    std::vector<QuantizedLinear> candidates(unique.size());
+    std::vector<uint8_t>         canQuantize(unique.size(),0);
+    if (maxQuantizationError >= 0.f)
+      parallel_for
+        (unique.size(),
+         [&](size_t uniqueID) {
+           if (useCount[uniqueID] != 1) return;
+           canQuantize[uniqueID]
+             = tryQuantize(unique[uniqueID],maxQuantizationError,
+                           candidates[uniqueID]);
+         });
+
+    std::vector<uint32_t> refOf(unique.size());
+    for (size_t uniqueID=0;uniqueID<unique.size();uniqueID++) {
+      if (canQuantize[uniqueID]) {
+        refOf[uniqueID] = (uint32_t)result.quantized.size() | QUANTIZED_BIT;
+        result.quantized.push_back(candidates[uniqueID]);
+      } else {
+        refOf[uniqueID] = (uint32_t)result.palette.size();
+        result.palette.push_back(unique[uniqueID]);
+      }
+    }
+    parallel_for_blocked
+      ((size_t)0,xfms.size(),16*1024,
+       [&](size_t begin, size_t end) {
+         for (size_t i=begin;i<end;i++)
+           result.linearRefs[i] = refOf[result.linearRefs[i]];
+       });
+    return result;
+  }
+
+  affine3f CompactTransforms::decode(size_t i) const
+  {
+    const uint32_t ref = linearRefs[i];
+    affine3f xfm;
+    xfm.l = (ref & QUANTIZED_BIT)
+      ? decodeQuantized(quantized[ref & ~QUANTIZED_BIT])
+      : palette[ref];
+    xfm.p = translations[i];
+    return xfm;
+  }
+
+  std::vector<affine3f> CompactTransforms::decodeAll() const
+  {
+    // decode each quantized linear part only once
+    std::vector<LinearSpace3f> dequantized(quantized.size());
+    parallel_for
+      (quantized.size(),
+       [&](size_t i) { dequantized[i] = decodeQuantized(quantized[i]); });
+
+    std::vector<affine3f> xfms(size());
+    parallel_for_blocked
+      ((size_t)0,size(),16*1024,
+       [&](size_t begin, size_t end) {
+         for (size_t i=begin;i<end;i++) {
+           const uint32_t ref = linearRefs[i];
+           xfms[i].l = (ref & QUANTIZED_BIT)
+             ? dequantized[ref & ~QUANTIZED_BIT]
+             : palette[ref];
+           xfms[i].p = translations[i];
+         }
+       });
+    return xfms;
+  }
+
+} // ::mini
@@ -0,0 +1,83 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/common.h"
+
+namespace mini {
+
+  /*! a compact encoding for a (typically large) list of affine
+      transforms, such as those of a scene's instances. Each transform
+      gets stored as its translation, plus a 32-bit reference to its
+      linear (3x3) part, which lives in one of two tables:
+
+      - a palette of unique linear parts; since many instance-heavy
+        scenes use only a few different rotations/scales, identical
+        linear parts get stored only once. This is lossless.
+
+      - optionally, a table of quantized linear parts, storing a
+        rotation (as a quaternion with 16-bit components) plus a
+        uniform scale. This is lossy, and is only used for transforms
+        whose linear part can be represented this way within a given
+        error bound; all others still go into the palette.
+
+      This takes 16 bytes per transform (plus the tables) instead of
+      the 48 bytes of an affine3f. */
+  struct CompactTransforms {
+    /*! a linear transform that consists of only a rotation and
+        uniform scale; stored as a (normalized) quaternion with 16-bit
+        snorm components, and the scale factor. 12 bytes. */
+    struct QuantizedLinear {
+      vec4s rotation;
+      float scale;
+    };
+
+    /*! if this bit is set in a linear ref, the lower bits are an
+        index into 'quantized'; else, they're an index into 'palette' */
+    static const uint32_t QUANTIZED_BIT = 0x80000000u;
+
+    /*! encodes given transforms. Identical linear parts always get
+        deduplicated. If maxQuantizationError is >= 0, linear parts
+        that are used only once, and that can be represented as
+        rotation plus uniform scale such that no matrix entry
+        differs from the original by more than maxQuantizationError
+        times that scale, get quantized; with the default of -1 the
+        encoding is lossless. */
+    static CompactTransforms encode(const std::vector<affine3f> &xfms,
+                                    float maxQuantizationError=-1.f);
+
+    /*! number of encoded transforms */
+    inline size_t size() const { return translations.size(); }
+
+    /*! decodes the i'th transform */
+    affine3f decode(size_t i) const;
+
+    /*! decodes all transforms, in parallel */
+    std::vector<affine3f> decodeAll() const;
+
+    /*! unique linear parts */
+    std::vector<LinearSpace3f>   palette;
+    /*! quantized linear parts */
+    std::vector<QuantizedLinear> quantized;
+    /*! per transform: reference to its linear part (see
+        QUANTIZED_BIT) */
+    std::vector<uint32_t>        linearRefs;
+    /*! per transform: its translation */
+    std::vector<vec3f>           translations;
+  };
+
+} // ::mini
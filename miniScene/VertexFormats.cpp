@@ -0,0 +1,150 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/VertexFormats.h"
+
+namespace mini {
+  namespace vertex_formats {
+
+    /*! elements per parallel task; small enough for a block's in- and
+        outputs to stay in L2 */
+    const size_t BLOCK_SIZE = 16*1024;
+
+    void encodeOctNormals(const vec3f *in, uint32_t *out, size_t count)
+    {
+      parallel_for_blocked
+        ((size_t)0,count,BLOCK_SIZE,
+         [&](size_t begin, size_t end) {
+           for (size_t i=begin;i<end;i++)
+             out[i] = encodeOctNormal(in[i]);
+         });
+    }
+
+    void decodeOctNormals(const uint32_t *in, vec3f *out, size_t count)
+    {
+      parallel_for_blocked
+        ((size_t)0,count,BLOCK_SIZE,
+         [&](size_t begin, size_t end) {
+           for (size_t i=begin;i<end;i++)
+             out[i] = decodeOctNormal(in[i]);
+         });
+    }
+
+    void encodeTexcoords(const vec2f *in, vec2us *out, size_t count,
+                         TexcoordFormat format)
+    {
+      parallel_for_blocked
+        ((size_t)0,count,BLOCK_SIZE,
+         [&](size_t begin, size_t end) {
+           if (format == TEXCOORDS_UNORM16)
+             for (size_t i=begin;i<end;i++)
+               out[i] = vec2us(encodeUNorm16(in[i].x),encodeUNorm16(in[i].y));
+           else
+             for (size_t i=begin;i<end;i++)
+               out[i] = vec2us(floatToHalf(in[i].x),floatToHalf(in[i].y));
+         });
+    }
+
+    void decodeTexcoords(const vec2us *in, vec2f *out, size_t count,
+                         TexcoordFormat format)
+    {
+      parallel_for_blocked
+        ((size_t)0,count,BLOCK_SIZE,
+         [&](size_t begin, size_t end) {
+           if (format == TEXCOORDS_UNORM16)
+             for (size_t i=begin;i<end;i++)
+               out[i] = vec2f(decodeUNorm16(in[i].x),decodeUNorm16(in[i].y));
+           else
+             for (size_t i=begin;i<end;i++)
+               out[i] = vec2f(halfToFloat(in[i].x),halfToFloat(in[i].y));
+         });
+    }
+
+    void encodePositions16(const vec3f *in, vec3us *out, size_t count,
+                           const PositionQuantization &quantization)
+    {
+      const vec3f origin = quantization.origin;
+      const vec3f scale  = quantization.scale;
+      parallel_for_blocked
+        ((size_t)0,count,BLOCK_SIZE,
+         [&](size_t begin, size_t end) {
+           for (size_t i=begin;i<end;i++)
+             out[i] = vec3us(quantizeCoordinate(in[i].x,origin.x,scale.x,0xffff),
+                             quantizeCoordinate(in[i].y,origin.y,scale.y,0xffff),
+                             quantizeCoordinate(in[i].z,origin.z,scale.z,0xffff));
+         });
+    }
+
+    /* the decoders work on the flat arrays of components rather than
+       on vec3s, and do nothing but a multiply-add per component, so
+       the compiler can vectorize them (with whatever SIMD the target
+       has) */
+    void decodePositions16(const vec3us *in, vec3f *out, size_t count,
+                           const PositionQuantization &quantization)
+    {
+      const vec3f origin = quantization.origin;
+      const vec3f scale  = quantization.scale;
+      parallel_for_blocked
+        ((size_t)0,count,BLOCK_SIZE,
+         [&](size_t begin, size_t end) {
+           const uint16_t *q = (const uint16_t *)(in+begin);
+           float *f = (float *)(out+begin);
+           for (size_t i=0;i<end-begin;i++) {
+             f[3*i+0] = origin.x + float(q[3*i+0])*scale.x;
+             f[3*i+1] = origin.y + float(q[3*i+1])*scale.y;
+             f[3*i+2] = origin.z + float(q[3*i+2])*scale.z;
+           }
+         });
+    }
+
+    void encodePositions21(const vec3f *in, uint64_t *out, size_t count,
+                           const PositionQuantization &quantization)
+    {
+      const vec3f origin = quantization.origin;
+      const vec3f scale  = quantization.scale;
+      const uint32_t maxValue = (1u<<21)-1;
+      parallel_for_blocked
+        ((size_t)0,count,BLOCK_SIZE,
+         [&](size_t begin, size_t end) {
+           for (size_t i=begin;i<end;i++)
+             out[i]
+               = (uint64_t(quantizeCoordinate(in[i].x,origin.x,scale.x,maxValue)))
+               | (uint64_t(quantizeCoordinate(in[i].y,origin.y,scale.y,maxValue)) << 21)
+               | (uint64_t(quantizeCoordinate(in[i].z,origin.z,scale.z,maxValue)) << 42);
+         });
+    }
+
+    void decodePositions21(const uint64_t *in, vec3f *out, size_t count,
+                           const PositionQuantization &quantization)
+    {
+      const vec3f origin = quantization.origin;
+      const vec3f scale  = quantization.scale;
+      const uint64_t mask = (1u<<21)-1;
+      parallel_for_blocked
+        ((size_t)0,count,BLOCK_SIZE,
+         [&](size_t begin, size_t end) {
+           float *f = (float *)(out+begin);
+           for (size_t i=0;i<end-begin;i++) {
+             const uint64_t q = in[begin+i];
+             f[3*i+0] = origin.x + float(uint32_t(q & mask))*scale.x;
+             f[3*i+1] = origin.y + float(uint32_t((q >> 21) & mask))*scale.y;
+             f[3*i+2] = origin.z + float(uint32_t((q >> 42) & mask))*scale.z;
+           }
+         });
+    }
+
+  } // ::mini::vertex_formats
+} // ::mini
@@ -0,0 +1,215 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "miniScene/common.h"
+#include <limits>
+
+/*! compact encodings for per-vertex attributes, as used by
+    Mesh::compactAttributes(): normals as 32-bit octahedral
+    encodings, and texture coordinates as two 16-bit values (either
+    half floats, or unorms for texcoords in [0,1]). All these are
+    the same formats GPUs can consume directly (e.g., octahedral
+    normals in a shader, or R16G16_SFLOAT/R16G16_UNORM vertex
+    attributes). Also, quantized vertex positions, as optionally
+    used in .mini files (see SaveOptions::positionQuantizationError). */
+namespace mini {
+  namespace vertex_formats {
+
+    /*! how a mesh's 16-bit texture coordinates are to be interpreted */
+    typedef enum : uint8_t { TEXCOORDS_HALF=0, TEXCOORDS_UNORM16 } TexcoordFormat;
+
+    inline float signNotZero(float f) { return f < 0.f ? -1.f : 1.f; }
+
+    inline uint16_t encodeSNorm16(float f)
+    { return (uint16_t)(int16_t)roundf(std::max(-1.f,std::min(1.f,f))*32767.f); }
+
+    inline float decodeSNorm16(uint16_t u)
+    { return std::max(-1.f,(int16_t)u*(1.f/32767.f)); }
+
+    inline uint16_t encodeUNorm16(float f)
+    { return (uint16_t)roundf(std::max(0.f,std::min(1.f,f))*65535.f); }
+
+    inline float decodeUNorm16(uint16_t u)
+    { return u*(1.f/65535.f); }
+
+    /*! encodes a unit vector in octahedral mapping, with 16 bits per
+        component; the x component is in the lower 16 bits. A zero
+        vector gets encoded as (0,0,1) */
+    inline uint32_t encodeOctNormal(vec3f n)
+    {
+      const float sum = fabsf(n.x)+fabsf(n.y)+fabsf(n.z);
+      if (!(sum > 0.f)) return 0;
+      float x = n.x/sum, y = n.y/sum;
+      if (n.z < 0.f) {
+        const float ox = x;
+        x = (1.f-fabsf(y))*signNotZero(ox);
+        y = (1.f-fabsf(ox))*signNotZero(y);
+      }
+      return uint32_t(encodeSNorm16(x)) | (uint32_t(encodeSNorm16(y)) << 16);
+    }
+
+    /*! decodes a normal encoded with encodeOctNormal(); the result is
+        normalized */
+    inline vec3f decodeOctNormal(uint32_t bits)
+    {
+      float x = decodeSNorm16(uint16_t(bits));
+      float y = decodeSNorm16(uint16_t(bits >> 16));
+      const float z = 1.f-fabsf(x)-fabsf(y);
+      const float t = std::max(-z,0.f);
+      x += (x >= 0.f) ? -t : t;
+      y += (y >= 0.f) ? -t : t;
+      const float invLen = 1.f/sqrtf(x*x+y*y+z*z);
+      return vec3f(x*invLen,y*invLen,z*invLen);
+    }
+
+    /*! converts a float to half (IEEE 754 binary16), rounding to
+        nearest even; values too large for a half become infinity */
+    inline uint16_t floatToHalf(float f)
+    {
+      uint32_t bits;
+      memcpy(&bits,&f,sizeof(bits));
+      const uint32_t sign = (bits >> 16) & 0x8000u;
+      const uint32_t absBits = bits & 0x7fffffffu;
+      if (absBits >= 0x7f800000u)
+        // inf or nan (keep nan a nan)
+        return uint16_t(sign | 0x7c00u | (absBits > 0x7f800000u ? 0x200u : 0u));
+      if (absBits >= 0x477ff000u)
+        // rounds to something larger than the largest half
+        return uint16_t(sign | 0x7c00u);
+      if (absBits < 0x38800000u) {
+        // denormal (or zero) in half
+        if (absBits < 0x33000000u) return uint16_t(sign);
+        const uint32_t mantissa = (absBits & 0x007fffffu) | 0x00800000u;
+        // value is mantissa * 2^(exponent-150), in units of 2^-24
+        const int shift = 126 - int(absBits >> 23);
+        uint32_t result = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift)-1);
+        const uint32_t half = 1u << (shift-1);
+        if (rest > half || (rest == half && (result & 1)))
+          result++;
+        return uint16_t(sign | result);
+      }
+      uint32_t result = (absBits - 0x38000000u) >> 13;
+      const uint32_t rest = absBits & 0x1fffu;
+      if (rest > 0x1000u || (rest == 0x1000u && (result & 1)))
+        result++;
+      return uint16_t(sign | result);
+    }
+
+    /*! converts a half (IEEE 754 binary16) to float; exact */
+    inline float halfToFloat(uint16_t h)
+    {
+      const uint32_t sign     = uint32_t(h & 0x8000u) << 16;
+      const uint32_t exponent = (h >> 10) & 0x1fu;
+      const uint32_t mantissa = h & 0x3ffu;
+      uint32_t bits;
+      if (exponent == 0x1fu)
+        bits = sign | 0x7f800000u | (mantissa << 13);
+      else if (exponent != 0)
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+      else {
+        // zero or denormal: value is mantissa * 2^-24
+        const float f = mantissa * (1.f/16777216.f);
+        memcpy(&bits,&f,sizeof(bits));
+        bits |= sign;
+      }
+      float f;
+      memcpy(&f,&bits,sizeof(f));
+      return f;
+    }
+
+    inline vec2us encodeTexcoord(vec2f tc, TexcoordFormat format)
+    {
+      return (format == TEXCOORDS_UNORM16)
+        ? vec2us(encodeUNorm16(tc.x),encodeUNorm16(tc.y))
+        : vec2us(floatToHalf(tc.x),floatToHalf(tc.y));
+    }
+
+    inline vec2f decodeTexcoord(vec2us tc, TexcoordFormat format)
+    {
+      return (format == TEXCOORDS_UNORM16)
+        ? vec2f(decodeUNorm16(tc.x),decodeUNorm16(tc.y))
+        : vec2f(halfToFloat(tc.x),halfToFloat(tc.y));
+    }
+
+    /*! describes how positions got quantized: each coordinate gets
+        stored as an unsigned integer 'q' with 'bits' bits, and
+        decodes to origin+q*scale (per component). 'origin' is the
+        lower corner of the (mesh's) bounds, so the quantization grid
+        is local to the mesh rather than to the world origin */
+    struct PositionQuantization {
+      vec3f origin;
+      vec3f scale;
+      int   bits;
+    };
+
+    /*! returns the quantization with given bits per component for
+        positions within the given (non-empty) bounds */
+    inline PositionQuantization makePositionQuantization(const box3f &bounds, int bits)
+    {
+      PositionQuantization quantization;
+      quantization.origin = bounds.lower;
+      quantization.scale  = (bounds.upper-bounds.lower) * (1.f/float((1u<<bits)-1));
+      quantization.bits   = bits;
+      return quantization;
+    }
+
+    /*! the largest error (per component, in the positions' units)
+        that quantizing to given bits introduces: half a grid step,
+        plus a few ulps for rounding in the decode */
+    inline float maxQuantizationError(const PositionQuantization &quantization)
+    {
+      const box3f bounds(quantization.origin,
+                         quantization.origin+quantization.scale*float((1u<<quantization.bits)-1));
+      const float magnitude = reduce_max(max(abs(bounds.lower),abs(bounds.upper)));
+      return .5f*reduce_max(quantization.scale) + 4.f*magnitude*std::numeric_limits<float>::epsilon();
+    }
+
+    inline uint32_t quantizeCoordinate(float f, float origin, float scale, uint32_t maxValue)
+    {
+      if (!(scale > 0.f)) return 0;
+      const float q = roundf((f-origin)/scale);
+      return q <= 0.f ? 0u : (q >= float(maxValue) ? maxValue : uint32_t(q));
+    }
+
+    /*! positions quantized to 16 bits per component; 6 bytes per
+        vertex */
+    void encodePositions16(const vec3f *in, vec3us *out, size_t count,
+                           const PositionQuantization &quantization);
+    void decodePositions16(const vec3us *in, vec3f *out, size_t count,
+                           const PositionQuantization &quantization);
+    /*! positions quantized to 21 bits per component, with x in the
+        lowest 21 bits of each 64-bit value, then y, then z; 8 bytes
+        per vertex */
+    void encodePositions21(const vec3f *in, uint64_t *out, size_t count,
+                           const PositionQuantization &quantization);
+    void decodePositions21(const uint64_t *in, vec3f *out, size_t count,
+                           const PositionQuantization &quantization);
+
+    /*! bulk versions of the above; these work in parallel over
+        blocks of elements, with the format check hoisted out of the
+        inner loops so the compiler can vectorize these */
+    void encodeOctNormals(const vec3f *in, uint32_t *out, size_t count);
+    void decodeOctNormals(const uint32_t *in, vec3f *out, size_t count);
+    void encodeTexcoords(const vec2f *in, vec2us *out, size_t count,
+                         TexcoordFormat format);
+    void decodeTexcoords(const vec2us *in, vec2f *out, size_t count,
+                         TexcoordFormat format);
+
+  } // ::mini::vertex_formats
+} // ::mini
@@ -99,3 +99,5 @@ namespace mini {
   }
 } // ::mini
 
+#include "miniScene/common/parallel/parallel_algorithms.h"
+
@@ -0,0 +1,165 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+/*! parallel sort/scan/partition, on top of (whichever version of)
+    parallel_for common.h picked; this file assumes that common.h
+    was already included */
+
+// std
+#include <vector>
+#include <algorithm>
+#include <iterator>
+// tbb
+#if OWL_HAVE_TBB
+#include <tbb/parallel_sort.h>
+#endif
+
+namespace mini {
+  namespace common {
+
+    /*! sorts the given range; with TBB this is a parallel sort,
+        otherwise a std::sort. Like std::sort, not stable. */
+    template<typename RandomIt, typename Compare>
+    inline void parallel_sort(RandomIt begin, RandomIt end, const Compare &less)
+    {
+#if OWL_HAVE_TBB
+      tbb::parallel_sort(begin,end,less);
+#else
+      std::sort(begin,end,less);
+#endif
+    }
+
+    template<typename RandomIt>
+    inline void parallel_sort(RandomIt begin, RandomIt end)
+    {
+#if OWL_HAVE_TBB
+      tbb::parallel_sort(begin,end);
+#else
+      std::sort(begin,end);
+#endif
+    }
+
+    namespace detail {
+      /*! runs body(blockID) for all blockID < numBlocks, in parallel;
+          the default way the scan and partition below process their
+          blocks (versions with progress reporting plug in their own,
+          see Progress.h) */
+      struct ParallelForEachBlock {
+        template<typename BODY_T>
+        inline void operator()(size_t numBlocks, const BODY_T &body) const
+        { parallel_for(numBlocks,body); }
+      };
+    }
+    
+    /*! writes out[i] = init + in[0] + ... + in[i-1], for all i<n, and
+        returns the sum over all elements (plus init). 'in' and 'out'
+        may be the same array. Works in two parallel passes over
+        blocks of blockSize elements (first summing up each block,
+        then scanning each block from the sum of the ones before it),
+        so 'T' should be associative under operator+. Each pass
+        processes its blocks via forEachBlock(numBlocks,body) */
+    template<typename T, typename FOR_EACH_BLOCK_T=detail::ParallelForEachBlock>
+    T parallel_exclusive_scan(const T *in, T *out, size_t n,
+                              T init=T(0), size_t blockSize=16*1024,
+                              const FOR_EACH_BLOCK_T &forEachBlock=FOR_EACH_BLOCK_T())
+    {
+      const size_t numBlocks = (n+blockSize-1)/blockSize;
+      if (numBlocks <= 1) {
+        T sum = init;
+        for (size_t i=0;i<n;i++) { T v = in[i]; out[i] = sum; sum = sum + v; }
+        return sum;
+      }
+      std::vector<T> blockOffsets(numBlocks);
+      forEachBlock(numBlocks,[&](size_t blockID){
+          const size_t begin = blockID*blockSize;
+          const size_t end   = std::min(begin+blockSize,n);
+          T sum = T(0);
+          for (size_t i=begin;i<end;i++) sum = sum + in[i];
+          blockOffsets[blockID] = sum;
+        });
+      T sum = init;
+      for (auto &ofs : blockOffsets) { T v = ofs; ofs = sum; sum = sum + v; }
+      forEachBlock(numBlocks,[&](size_t blockID){
+          const size_t begin = blockID*blockSize;
+          const size_t end   = std::min(begin+blockSize,n);
+          T blockSum = blockOffsets[blockID];
+          for (size_t i=begin;i<end;i++) {
+            T v = in[i]; out[i] = blockSum; blockSum = blockSum + v;
+          }
+        });
+      return sum;
+    }
+
+    template<typename T>
+    inline T parallel_exclusive_scan(std::vector<T> &values, T init=T(0))
+    { return parallel_exclusive_scan(values.data(),values.data(),values.size(),init); }
+
+    /*! moves all elements for which 'pred' is true to the front of
+        the range, and returns the first element for which it is
+        false. Unlike std::partition this is stable - both halves
+        keep their relative order - so results don't depend on the
+        number of threads. 'pred' gets evaluated exactly once per
+        element; elements need to be default-constructible and
+        movable. Works in three parallel passes over blocks of
+        blockSize elements, each of which processes its blocks via
+        forEachBlock(numBlocks,body) */
+    template<typename RandomIt, typename Pred,
+             typename FOR_EACH_BLOCK_T=detail::ParallelForEachBlock>
+    RandomIt parallel_partition(RandomIt begin, RandomIt end, const Pred &pred,
+                                size_t blockSize=16*1024,
+                                const FOR_EACH_BLOCK_T &forEachBlock=FOR_EACH_BLOCK_T())
+    {
+      typedef typename std::iterator_traits<RandomIt>::value_type T;
+      const size_t n = end-begin;
+      const size_t numBlocks = (n+blockSize-1)/blockSize;
+      if (numBlocks <= 1)
+        return std::stable_partition(begin,end,pred);
+
+      std::vector<uint8_t> isTrue(n);
+      std::vector<size_t>  trueOffsets(numBlocks);
+      forEachBlock(numBlocks,[&](size_t blockID){
+          const size_t blockBegin = blockID*blockSize;
+          const size_t blockEnd   = std::min(blockBegin+blockSize,n);
+          size_t count = 0;
+          for (size_t i=blockBegin;i<blockEnd;i++)
+            count += (isTrue[i] = pred(begin[i]) ? 1 : 0);
+          trueOffsets[blockID] = count;
+        });
+      const size_t numTrue = parallel_exclusive_scan(trueOffsets);
+
+      std::vector<T> partitioned(n);
+      forEachBlock(numBlocks,[&](size_t blockID){
+          const size_t blockBegin = blockID*blockSize;
+          const size_t blockEnd   = std::min(blockBegin+blockSize,n);
+          size_t trueOfs  = trueOffsets[blockID];
+          // all elements before this block that weren't true are false
+          size_t falseOfs = numTrue + (blockBegin - trueOffsets[blockID]);
+          for (size_t i=blockBegin;i<blockEnd;i++)
+            partitioned[isTrue[i] ? trueOfs++ : falseOfs++] = std::move(begin[i]);
+        });
+      forEachBlock(numBlocks,[&](size_t blockID){
+          const size_t blockBegin = blockID*blockSize;
+          const size_t blockEnd   = std::min(blockBegin+blockSize,n);
+          std::move(partitioned.begin()+blockBegin,partitioned.begin()+blockEnd,
+                    begin+blockBegin);
+        });
+      return begin+numTrue;
+    }
+
+  } // ::mini::common
+} // ::mini
@@ -0,0 +1,239 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "testing.h"
+#include "miniScene/Codecs.h"
+#include "miniScene/BlockCompression.h"
+#include <cstring>
+#include <sstream>
+
+using namespace mini;
+
+/*! text-like data: random words from a small vocabulary */
+std::vector<uint8_t> makeText(size_t numBytes, uint32_t seed)
+{
+  const char *words[] = { "mesh ", "vertex ", "index ", "texture ",
+                          "instance ", "object ", "material ", "\n" };
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> data;
+  while (data.size() < numBytes) {
+    const char *word = words[rng()%8];
+    data.insert(data.end(),word,word+strlen(word));
+  }
+  data.resize(numBytes);
+  return data;
+}
+
+std::vector<uint8_t> makeRandom(size_t numBytes, uint32_t seed)
+{
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> data(numBytes);
+  for (auto &b : data) b = uint8_t(rng());
+  return data;
+}
+
+// ------------------------------------------------------------------
+// LZ codec
+// ------------------------------------------------------------------
+
+/*! compresses and decompresses 'in', checks that gives the same, and
+    returns the compressed size */
+size_t checkLZRoundTrip(const std::vector<uint8_t> &in)
+{
+  std::vector<uint8_t> compressed;
+  codecs::lzCompress(compressed,in.data(),in.size());
+  std::vector<uint8_t> decompressed(in.size());
+  codecs::lzDecompress(decompressed.data(),decompressed.size(),
+                       compressed.data(),compressed.data()+compressed.size());
+  MINI_CHECK(decompressed == in);
+  return compressed.size();
+}
+
+void testLZ()
+{
+  checkLZRoundTrip({});
+  checkLZRoundTrip({ 1 });
+  checkLZRoundTrip({ 1, 2, 3, 4, 5 });
+  // long runs (ie, matches that overlap their own output)
+  MINI_CHECK(checkLZRoundTrip(std::vector<uint8_t>(100000,7)) < 1000);
+  MINI_CHECK(checkLZRoundTrip(makeText(300000,1)) < 300000/2);
+  checkLZRoundTrip(makeRandom(100000,2));
+  // repeats that are just within, and just beyond, the 64K window
+  for (size_t distance : { size_t(65535), size_t(65536), size_t(70000) }) {
+    std::vector<uint8_t> data = makeRandom(distance+1000,3);
+    std::copy(data.begin(),data.begin()+1000,data.begin()+distance);
+    checkLZRoundTrip(data);
+  }
+
+  // invalid input
+  const std::vector<uint8_t> in = makeText(100000,4);
+  std::vector<uint8_t> valid;
+  codecs::lzCompress(valid,in.data(),in.size());
+  std::vector<uint8_t> out(in.size()+100);
+  auto decompress = [&](const std::vector<uint8_t> &compressed, size_t numBytes) {
+    codecs::lzDecompress(out.data(),numBytes,
+                         compressed.data(),compressed.data()+compressed.size());
+  };
+  // truncated
+  for (size_t size : { size_t(0), size_t(1), valid.size()/2, valid.size()-1 }) {
+    const std::vector<uint8_t> bad(valid.begin(),valid.begin()+size);
+    MINI_CHECK_THROWS(decompress(bad,in.size()));
+  }
+  // more or fewer bytes than were compressed
+  MINI_CHECK_THROWS(decompress(valid,in.size()+100));
+  MINI_CHECK_THROWS(decompress(valid,in.size()-100));
+  // a match that reaches back before the start of the output
+  MINI_CHECK_THROWS(decompress(std::vector<uint8_t>{ 0x00, 0x10, 0x00 },8));
+  // flipped bits may or may not get noticed, but must never make the
+  // decoder read (or write) out of bounds
+  std::mt19937 rng(5);
+  for (int i=0;i<1000;i++) {
+    std::vector<uint8_t> bad = valid;
+    bad[rng()%bad.size()] ^= uint8_t(1 << (rng()%8));
+    try { decompress(bad,in.size()); } catch (const std::exception &) {}
+  }
+}
+
+// ------------------------------------------------------------------
+// blocks
+// ------------------------------------------------------------------
+
+void testBlocks()
+{
+  const std::vector<uint8_t> text = makeText(100000,6);
+  const std::vector<uint8_t> noise = makeRandom(100000,7);
+  for (auto *data : { &text, &noise }) {
+    BlockCompression compression = BLOCK_COMPRESSION_LZ;
+    const std::vector<uint8_t> stored
+      = io::compressBlock(data->data(),data->size(),compression);
+    // incompressible blocks get stored as they are
+    MINI_CHECK(compression == (data == &text
+                               ? BLOCK_COMPRESSION_LZ
+                               : BLOCK_COMPRESSION_NONE));
+    std::vector<uint8_t> decompressed(data->size());
+    io::decompressBlock(decompressed.data(),decompressed.size(),
+                        stored.data(),stored.size(),compression);
+    MINI_CHECK(decompressed == *data);
+  }
+  uint8_t out[16];
+  MINI_CHECK_THROWS(io::decompressBlock(out,16,text.data(),8,BLOCK_COMPRESSION_NONE));
+  MINI_CHECK_THROWS(io::decompressBlock(out,16,text.data(),16,(BlockCompression)7));
+}
+
+// ------------------------------------------------------------------
+// the container
+// ------------------------------------------------------------------
+
+std::string writeContainer(const std::vector<uint8_t> &data,
+                           size_t blockSize, bool checksums=false)
+{
+  std::stringstream container;
+  io::BlockWriteBuffer blocks(container,BLOCK_COMPRESSION_LZ,blockSize,checksums);
+  std::ostream out(&blocks);
+  out.exceptions(std::ios::badbit);
+  // (in pieces of odd sizes, to get writes across block boundaries)
+  for (size_t begin=0;begin<data.size();begin+=777)
+    out.write((const char *)data.data()+begin,std::min<size_t>(777,data.size()-begin));
+  out.flush();
+  blocks.finish();
+  return container.str();
+}
+
+/*! reads all of the container's inner file; throws if that fails */
+std::vector<uint8_t> readContainer(const std::string &container)
+{
+  std::stringstream stream(container);
+  io::BlockReadBuffer blocks(stream);
+  std::istream in(&blocks);
+  in.exceptions(std::ios::badbit);
+  std::vector<uint8_t> data;
+  char buffer[1000];
+  while (in.read(buffer,sizeof(buffer)) || in.gcount())
+    data.insert(data.end(),buffer,buffer+in.gcount());
+  return data;
+}
+
+void testContainer()
+{
+  const size_t blockSize = 4096;
+  for (size_t numBytes : { size_t(0), size_t(1), blockSize, blockSize+1,
+                           size_t(100000) }) {
+    const std::vector<uint8_t> data = makeText(numBytes,(uint32_t)numBytes);
+    const std::string container = writeContainer(data,blockSize);
+    MINI_CHECK(readContainer(container) == data);
+
+    // the index covers the inner file, block by block
+    std::stringstream stream(container);
+    const std::vector<io::BlockInfo> index = io::readBlockIndex(stream);
+    MINI_CHECK(index.size() == (numBytes+blockSize-1)/blockSize);
+    uint64_t rawOffset = 0;
+    for (auto &info : index) {
+      MINI_CHECK(info.rawOffset == rawOffset);
+      rawOffset += info.rawSize;
+    }
+    MINI_CHECK(rawOffset == numBytes);
+  }
+
+  // random access
+  {
+    const std::vector<uint8_t> data = makeText(100000,8);
+    const std::string container = writeContainer(data,blockSize);
+    std::stringstream stream(container);
+    io::BlockReadBuffer blocks(stream);
+    std::istream in(&blocks);
+    in.exceptions(std::ios::badbit);
+    std::mt19937 rng(9);
+    for (int i=0;i<100;i++) {
+      const size_t pos = rng()%(data.size()-100);
+      char buffer[100];
+      in.seekg(pos);
+      in.read(buffer,sizeof(buffer));
+      MINI_CHECK(size_t(in.tellg()) == pos+sizeof(buffer));
+      MINI_CHECK(!memcmp(buffer,data.data()+pos,sizeof(buffer)));
+    }
+  }
+
+  // invalid containers
+  const std::vector<uint8_t> data = makeText(20000,10);
+  const std::string valid = writeContainer(data,blockSize);
+  // (the first block's header follows the 24-byte container header)
+  const size_t firstBlock = sizeof(size_t)+2*sizeof(uint32_t)+sizeof(uint64_t);
+  {
+    std::string bad = valid;
+    bad[0] ^= 1;
+    MINI_CHECK_THROWS(readContainer(bad));
+  }
+  {
+    std::string bad = valid;
+    bad[firstBlock+offsetof(io::BlockHeader,compression)] = 7;
+    MINI_CHECK_THROWS(readContainer(bad));
+  }
+  {
+    std::string bad = valid;
+    bad[firstBlock+offsetof(io::BlockHeader,storedSize)+6] = 1;
+    MINI_CHECK_THROWS(readContainer(bad));
+  }
+  for (size_t size : { firstBlock+4, firstBlock+100, valid.size()/2 })
+    MINI_CHECK_THROWS(readContainer(valid.substr(0,size)));
+}
+
+int main(int, char **)
+{
+  testLZ();
+  testBlocks();
+  testContainer();
+  return testing::testResult("block compression");
+}
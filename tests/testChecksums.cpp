@@ -0,0 +1,239 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "testing.h"
+#include "miniScene/Checksum.h"
+#include "miniScene/BlockCompression.h"
+#include "miniScene/Scene.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace mini;
+
+// ------------------------------------------------------------------
+// XXH64
+// ------------------------------------------------------------------
+
+void testXXHash64()
+{
+  // reference values, from the xxHash project
+  const char *text = "Nobody inspects the spammish repetition";
+  MINI_CHECK(XXHash64::hash("",0)   == 0xef46db3751d8e999ull);
+  MINI_CHECK(XXHash64::hash("a",1)  == 0xd24ec4f1a98c6e5bull);
+  MINI_CHECK(XXHash64::hash("abc",3) == 0x44bc2cf5ad770999ull);
+  MINI_CHECK(XXHash64::hash(text,strlen(text)) == 0xfbcea83c8a378bf1ull);
+
+  // streaming, in pieces of any size, gives the same as a single call
+  std::mt19937 rng(1);
+  std::vector<uint8_t> data(1000);
+  for (auto &b : data) b = uint8_t(rng());
+  const uint64_t expected = XXHash64::hash(data.data(),data.size(),42);
+  for (size_t pieceSize : { 1, 3, 31, 32, 33, 100, 1000 }) {
+    XXHash64 hash(42);
+    for (size_t begin=0;begin<data.size();begin+=pieceSize)
+      hash.update(data.data()+begin,std::min(pieceSize,data.size()-begin));
+    MINI_CHECK(hash.digest() == expected);
+  }
+  XXHash64 hash;
+  hash.update(data.data(),data.size());
+  hash.reset(42);
+  hash.update(data.data(),data.size());
+  MINI_CHECK(hash.digest() == expected);
+
+  MINI_CHECK(XXHash64::hash(data.data(),data.size()) != expected);
+  data[500] ^= 1;
+  MINI_CHECK(XXHash64::hash(data.data(),data.size(),42) != expected);
+}
+
+// ------------------------------------------------------------------
+// scenes
+// ------------------------------------------------------------------
+
+/*! a value we can find a mesh's vertex array by, in a saved file */
+const vec3f marker(1234.5f,-6789.25f,42.125f);
+
+/*! a scene with a textured material, and a mesh of random (ie,
+    incompressible) vertices, starting with 'marker' */
+Scene::SP makeScene()
+{
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<float> uniform(-1.f,1.f);
+
+  Texture::SP texture = Texture::create();
+  texture->format = Texture::RGBA_UINT8;
+  texture->size   = { 16, 16 };
+  texture->data.resize(16*16*4);
+  for (auto &b : texture->data) b = uint8_t(rng());
+
+  DisneyMaterial::SP material = DisneyMaterial::create();
+  material->colorTexture = texture;
+
+  Mesh::SP mesh = Mesh::create(material);
+  std::vector<vec3f> &vertices = mesh->vertices.edit();
+  std::vector<vec3i> &indices  = mesh->indices.edit();
+  vertices.push_back(marker);
+  for (int i=1;i<30000;i++)
+    vertices.push_back(vec3f(uniform(rng),uniform(rng),uniform(rng)));
+  for (int i=0;i<10000;i++)
+    indices.push_back(vec3i(3*i,3*i+1,3*i+2));
+
+  return Scene::create({ Instance::create(Object::create({ mesh })) });
+}
+
+std::string save(Scene::SP scene, const SaveOptions &options=SaveOptions())
+{
+  std::stringstream out;
+  scene->save(out,options);
+  return out.str();
+}
+
+Scene::SP load(const std::string &file, bool verify=true)
+{
+  LoadOptions options;
+  options.verifyChecksums = verify;
+  return Scene::load(file.data(),file.size(),options);
+}
+
+void writeFile(const std::string &fileName, const std::string &content)
+{
+  std::ofstream out(fileName,std::ios::binary);
+  out.write(content.data(),content.size());
+}
+
+std::string readFile(const std::string &fileName)
+{
+  std::ifstream in(fileName,std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+/*! flips a bit in the middle of the given file */
+void corruptFile(const std::string &fileName)
+{
+  std::string content = readFile(fileName);
+  content[content.size()/2] ^= 4;
+  writeFile(fileName,content);
+}
+
+void testSceneChecksums()
+{
+  Scene::SP scene = makeScene();
+  SaveOptions withChecksums;
+  withChecksums.checksums = true;
+  const std::string plain = save(scene);
+  const std::string file  = save(scene,withChecksums);
+  MINI_CHECK(file != plain);
+
+  // a file with checksums loads (and verifies) fine, and gives the
+  // same scene as one without
+  MINI_CHECK(save(load(file)) == plain);
+  MINI_CHECK(save(load(file,false)) == plain);
+
+  // a flipped bit in the mesh's vertices
+  const size_t vertexPos
+    = file.find(std::string((const char *)&marker,sizeof(marker)));
+  MINI_CHECK(vertexPos != std::string::npos);
+  std::string corrupt = file;
+  corrupt[vertexPos+100] ^= 1;
+  MINI_CHECK_THROWS(load(corrupt));
+  // (which only gets noticed if we ask for it)
+  MINI_CHECK(save(load(corrupt,false)) != plain);
+
+  // files, checked by Scene::verify
+  const std::string fileName = "miniTestChecksums.mini";
+  writeFile(fileName,plain);
+  MINI_CHECK_THROWS(Scene::verify(fileName));
+  writeFile(fileName,file);
+  MINI_CHECK(Scene::verify(fileName).empty());
+  writeFile(fileName,corrupt);
+  MINI_CHECK(!Scene::verify(fileName).empty());
+
+  // block-compressed files, whose blocks have checksums, too
+  SaveOptions blocks = withChecksums;
+  blocks.blockCompression = BLOCK_COMPRESSION_LZ;
+  blocks.blockSize        = 64*1024;
+  scene->save(fileName,blocks);
+  MINI_CHECK(Scene::verify(fileName).empty());
+  corruptFile(fileName);
+  MINI_CHECK(!Scene::verify(fileName).empty());
+  MINI_CHECK_THROWS(load(readFile(fileName),false));
+
+  // striped scenes, where each stripe file has checksums of its own
+  SaveOptions stripes = withChecksums;
+  stripes.numStripes = 2;
+  scene->save(fileName,stripes);
+  MINI_CHECK(Scene::verify(fileName).empty());
+  LoadOptions verify;
+  verify.verifyChecksums = true;
+  MINI_CHECK(save(Scene::load(fileName,verify)) == plain);
+  corruptFile(fileName+".stripe0");
+  MINI_CHECK(!Scene::verify(fileName).empty());
+  MINI_CHECK_THROWS(Scene::load(fileName,verify));
+
+  // (saving unstriped removes the stripe files again)
+  scene->save(fileName);
+  std::remove(fileName.c_str());
+}
+
+// ------------------------------------------------------------------
+// block containers
+// ------------------------------------------------------------------
+
+void testBlockChecksums()
+{
+  std::mt19937 rng(3);
+  std::vector<char> data(100000);
+  for (auto &c : data) c = char('a'+rng()%4);
+
+  std::stringstream container;
+  {
+    io::BlockWriteBuffer blocks(container,BLOCK_COMPRESSION_LZ,4096,true);
+    std::ostream out(&blocks);
+    out.write(data.data(),data.size());
+    out.flush();
+    blocks.finish();
+  }
+  auto read = [](const std::string &container) {
+    std::stringstream stream(container);
+    io::BlockReadBuffer blocks(stream);
+    MINI_CHECK(blocks.hasChecksums());
+    std::istream in(&blocks);
+    in.exceptions(std::ios::badbit);
+    std::vector<char> data(100000);
+    in.read(data.data(),data.size());
+    return data;
+  };
+  MINI_CHECK(read(container.str()) == data);
+
+  // a flipped bit in any block's data has to get noticed
+  std::stringstream stream(container.str());
+  for (auto &info : io::readBlockIndex(stream)) {
+    std::string corrupt = container.str();
+    corrupt[info.fileOffset+sizeof(io::BlockHeader)+info.storedSize/2] ^= 1;
+    MINI_CHECK_THROWS(read(corrupt));
+  }
+}
+
+int main(int, char **)
+{
+  testXXHash64();
+  testSceneChecksums();
+  testBlockChecksums();
+  return testing::testResult("checksums");
+}
@@ -0,0 +1,290 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "testing.h"
+#include "miniScene/Codecs.h"
+#include <cstring>
+#include <limits>
+
+using namespace mini;
+using codecs::CompressedFloats;
+
+// ------------------------------------------------------------------
+// entropy coder
+// ------------------------------------------------------------------
+
+/*! encodes 'in', decodes it again, and checks that it's the same and
+    that the decoder consumed exactly the encoded bytes; returns the
+    size of the encoding */
+size_t checkEntropyRoundTrip(const std::vector<uint8_t> &in)
+{
+  std::vector<uint8_t> encoded;
+  codecs::entropyEncode(encoded,in.data(),in.size());
+  MINI_CHECK(encoded.size() <= in.size()+1);
+  std::vector<uint8_t> decoded(in.size());
+  const uint8_t *end
+    = codecs::entropyDecode(decoded.data(),decoded.size(),
+                            encoded.data(),encoded.data()+encoded.size());
+  MINI_CHECK(end == encoded.data()+encoded.size());
+  MINI_CHECK(decoded == in);
+  return encoded.size();
+}
+
+/*! 'numBytes' bytes, each of which is 0 with given probability, and
+    else random */
+std::vector<uint8_t> makeSkewed(size_t numBytes, float probZero, uint32_t seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.f,1.f);
+  std::vector<uint8_t> bytes(numBytes);
+  for (auto &b : bytes)
+    b = uniform(rng) < probZero ? 0 : uint8_t(rng());
+  return bytes;
+}
+
+void testEntropyRoundTrips()
+{
+  checkEntropyRoundTrip({});
+  checkEntropyRoundTrip({ 42 });
+  checkEntropyRoundTrip(std::vector<uint8_t>(100000,7));
+  // sizes around the number of interleaved states
+  for (size_t numBytes=1;numBytes<20;numBytes++)
+    checkEntropyRoundTrip(makeSkewed(numBytes,.9f,(uint32_t)numBytes));
+  // skewed data has to compress; random data gets stored as is
+  MINI_CHECK(checkEntropyRoundTrip(makeSkewed(100000,.9f,1)) < 100000/2);
+  MINI_CHECK(checkEntropyRoundTrip(makeSkewed(100000,0.f,2)) == 100000+1);
+  // all 256 symbols, one of them very rare
+  {
+    std::vector<uint8_t> bytes = makeSkewed(70000,.99f,3);
+    for (int s=0;s<256;s++) bytes[s] = uint8_t(s);
+    checkEntropyRoundTrip(bytes);
+  }
+  // streams can get concatenated, and decoded one after another
+  {
+    const std::vector<uint8_t> a = makeSkewed(5000,.8f,4);
+    const std::vector<uint8_t> b(300,1);
+    std::vector<uint8_t> encoded;
+    codecs::entropyEncode(encoded,a.data(),a.size());
+    codecs::entropyEncode(encoded,b.data(),b.size());
+    std::vector<uint8_t> decodedA(a.size()), decodedB(b.size());
+    const uint8_t *in = encoded.data(), *in_end = encoded.data()+encoded.size();
+    in = codecs::entropyDecode(decodedA.data(),a.size(),in,in_end);
+    in = codecs::entropyDecode(decodedB.data(),b.size(),in,in_end);
+    MINI_CHECK(in == in_end);
+    MINI_CHECK(decodedA == a && decodedB == b);
+  }
+}
+
+void testEntropyInvalidInput()
+{
+  const std::vector<uint8_t> in = makeSkewed(10000,.9f,5);
+  std::vector<uint8_t> valid;
+  codecs::entropyEncode(valid,in.data(),in.size());
+  std::vector<uint8_t> out(in.size());
+  auto decode = [&](const std::vector<uint8_t> &encoded, size_t numBytes) {
+    codecs::entropyDecode(out.data(),std::min(numBytes,out.size()),
+                          encoded.data(),encoded.data()+encoded.size());
+  };
+
+  // (layout of an rANS stream: mode byte, 32-byte symbol mask, one
+  // uint16 frequency per symbol in the mask, uint32 payload size,
+  // payload)
+  size_t numSymbols = 0;
+  for (int i=0;i<32;i++)
+    for (int bit=0;bit<8;bit++)
+      if (valid[1+i] & (1<<bit)) numSymbols++;
+  const size_t payloadSizeOfs = 1+32+2*numSymbols;
+  MINI_CHECK(valid[0] == 2 /* rANS */);
+
+  // invalid stream mode
+  {
+    std::vector<uint8_t> bad = valid;
+    bad[0] = 3;
+    MINI_CHECK_THROWS(decode(bad,in.size()));
+  }
+  // frequencies that don't add up
+  {
+    std::vector<uint8_t> bad = valid;
+    bad[1+32] ^= 1;
+    MINI_CHECK_THROWS(decode(bad,in.size()));
+  }
+  // payload size beyond the end of the data, or odd
+  {
+    std::vector<uint8_t> bad = valid;
+    bad[payloadSizeOfs] += 2;
+    MINI_CHECK_THROWS(decode(bad,in.size()));
+    bad = valid;
+    bad[payloadSizeOfs] ^= 1;
+    MINI_CHECK_THROWS(decode(bad,in.size()));
+  }
+  // truncated at any point
+  for (size_t size : { size_t(0), size_t(1), size_t(20), payloadSizeOfs+2, valid.size()-1 }) {
+    std::vector<uint8_t> bad(valid.begin(),valid.begin()+size);
+    MINI_CHECK_THROWS(decode(bad,in.size()));
+  }
+  // truncated raw and constant streams
+  MINI_CHECK_THROWS(decode(std::vector<uint8_t>{ 0, 1, 2 },4));
+  MINI_CHECK_THROWS(decode(std::vector<uint8_t>{ 1 },4));
+  // decoding more bytes than were encoded runs out of data
+  {
+    std::vector<uint8_t> more(in.size()+100);
+    MINI_CHECK_THROWS(codecs::entropyDecode(more.data(),more.size(),
+                                            valid.data(),valid.data()+valid.size()));
+  }
+  // flipped bits may or may not get noticed, but must never make the
+  // decoder read (or write) out of bounds
+  std::mt19937 rng(6);
+  for (int i=0;i<1000;i++) {
+    std::vector<uint8_t> bad = valid;
+    bad[rng()%bad.size()] ^= uint8_t(1 << (rng()%8));
+    try { decode(bad,in.size()); } catch (const std::exception &) {}
+  }
+}
+
+// ------------------------------------------------------------------
+// float codec
+// ------------------------------------------------------------------
+
+/*! checks that encoding and decoding gives the exact same bits
+    (including for NaNs, infinities, and signed zeroes); returns the
+    encoded size */
+size_t checkFloatRoundTrip(const std::vector<float> &values, int numComponents)
+{
+  const size_t numElements = values.size()/numComponents;
+  const CompressedFloats encoded
+    = CompressedFloats::encode(values.data(),numElements,numComponents);
+  MINI_CHECK(encoded.numElements == numElements);
+  MINI_CHECK(encoded.numComponents == numComponents);
+  std::vector<float> decoded(values.size());
+  encoded.decode(decoded.data());
+  MINI_CHECK(values.empty()
+             || !memcmp(decoded.data(),values.data(),values.size()*sizeof(float)));
+  return encoded.sizeInBytes();
+}
+
+/*! vertices of a (finely tessellated) sphere, in scanline order */
+std::vector<float> makeSphereVertices(int res)
+{
+  std::vector<float> values;
+  for (int i=0;i<=res;i++)
+    for (int j=0;j<2*res;j++) {
+      const float u = j*float(M_PI)/res;
+      const float v = i*float(M_PI)/res;
+      values.push_back(10.f+cosf(u)*sinf(v));
+      values.push_back(20.f+sinf(u)*sinf(v));
+      values.push_back(30.f+cosf(v));
+    }
+  return values;
+}
+
+void testFloatRoundTrips()
+{
+  checkFloatRoundTrip({},3);
+  checkFloatRoundTrip({ 1.f, 2.f, 3.f },3);
+  checkFloatRoundTrip({ .5f, .25f },2);
+  // coherent data, over several chunks; has to compress
+  const std::vector<float> sphere = makeSphereVertices(200);
+  MINI_CHECK(sphere.size()/3 > 2*CompressedFloats::ELEMENTS_PER_CHUNK);
+  MINI_CHECK(checkFloatRoundTrip(sphere,3) < sphere.size()*sizeof(float));
+  // the same data, seen as scalars and as pairs
+  checkFloatRoundTrip(sphere,1);
+  checkFloatRoundTrip(std::vector<float>(sphere.begin(),sphere.end()-(sphere.size()%2)),2);
+  // special values, and random bit patterns
+  {
+    std::vector<float> values
+      = { 0.f, -0.f,
+          std::numeric_limits<float>::infinity(),
+          -std::numeric_limits<float>::infinity(),
+          std::numeric_limits<float>::quiet_NaN(),
+          std::numeric_limits<float>::denorm_min(),
+          std::numeric_limits<float>::max(),
+          std::numeric_limits<float>::lowest() };
+    std::mt19937 rng(7);
+    for (int i=0;i<30000;i++) {
+      const uint32_t bits = (uint32_t)rng();
+      float f;
+      memcpy(&f,&bits,sizeof(f));
+      values.push_back(f);
+    }
+    checkFloatRoundTrip(values,1);
+    checkFloatRoundTrip(std::vector<float>(values.begin(),values.begin()+30000),3);
+  }
+  // exactly one chunk, and one element more
+  for (size_t numElements : { size_t(CompressedFloats::ELEMENTS_PER_CHUNK),
+                              size_t(CompressedFloats::ELEMENTS_PER_CHUNK+1) })
+    checkFloatRoundTrip(std::vector<float>(sphere.begin(),sphere.begin()+3*numElements),3);
+}
+
+void testFloatInvalidInput()
+{
+  const std::vector<float> sphere = makeSphereVertices(100);
+  const CompressedFloats valid
+    = CompressedFloats::encode(sphere.data(),sphere.size()/3,3);
+  std::vector<float> decoded(sphere.size()+3);
+
+  {
+    CompressedFloats bad = valid;
+    bad.numComponents = 0;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  // inconsistent chunk tables
+  {
+    CompressedFloats bad = valid;
+    bad.chunkOffsets.back()++;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  {
+    CompressedFloats bad = valid;
+    bad.numElements += CompressedFloats::ELEMENTS_PER_CHUNK;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  // invalid predictor
+  {
+    CompressedFloats bad = valid;
+    bad.bytes[bad.chunkOffsets[0]] = 0xff;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  // truncated chunk, and chunk with data left over
+  {
+    CompressedFloats bad = valid;
+    bad.bytes.pop_back();
+    bad.chunkOffsets.back()--;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  {
+    CompressedFloats bad = valid;
+    bad.bytes.push_back(0);
+    bad.chunkOffsets.back()++;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  // flipped bits may or may not get noticed, but must never make the
+  // decoder read (or write) out of bounds
+  std::mt19937 rng(8);
+  for (int i=0;i<1000;i++) {
+    CompressedFloats bad = valid;
+    bad.bytes[rng()%bad.bytes.size()] ^= uint8_t(1 << (rng()%8));
+    try { bad.decode(decoded.data()); } catch (const std::exception &) {}
+  }
+}
+
+int main(int, char **)
+{
+  testEntropyRoundTrips();
+  testEntropyInvalidInput();
+  testFloatRoundTrips();
+  testFloatInvalidInput();
+  return testing::testResult("float codec");
+}
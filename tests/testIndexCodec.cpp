@@ -0,0 +1,172 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "testing.h"
+#include "miniScene/Codecs.h"
+#include <cstring>
+
+using namespace mini;
+using codecs::CompressedIndices;
+
+/*! a regular grid of quads, two triangles each, in scanline order -
+    about what a (vertex-cache-optimized) exporter would produce */
+std::vector<vec3i> makeGrid(int nx, int ny)
+{
+  std::vector<vec3i> triangles;
+  for (int iy=0;iy<ny;iy++)
+    for (int ix=0;ix<nx;ix++) {
+      const int i00 = iy*(nx+1)+ix;
+      const int i01 = i00+1;
+      const int i10 = i00+(nx+1);
+      const int i11 = i10+1;
+      triangles.push_back(vec3i(i00,i01,i11));
+      triangles.push_back(vec3i(i00,i11,i10));
+    }
+  return triangles;
+}
+
+std::vector<vec3i> makeRandom(size_t numTriangles, int maxIndex, uint32_t seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> index(0,maxIndex);
+  std::vector<vec3i> triangles(numTriangles);
+  for (auto &tri : triangles)
+    tri = vec3i(index(rng),index(rng),index(rng));
+  return triangles;
+}
+
+bool decodesTo(const CompressedIndices &encoded,
+               const std::vector<vec3i> &expected)
+{
+  std::vector<vec3i> decoded(encoded.numTriangles);
+  encoded.decode(decoded.data());
+  return decoded.size() == expected.size()
+    && (expected.empty()
+        || !memcmp(decoded.data(),expected.data(),expected.size()*sizeof(vec3i)));
+}
+
+void testRoundTrips()
+{
+  // empty
+  {
+    const CompressedIndices encoded = CompressedIndices::encode(nullptr,0);
+    MINI_CHECK(encoded.numTriangles == 0);
+    MINI_CHECK(decodesTo(encoded,{}));
+  }
+  // a single triangle, and some degenerate ones
+  {
+    const std::vector<vec3i> triangles
+      = { vec3i(0,1,2), vec3i(2,2,2), vec3i(0,0,0), vec3i(5,3,1) };
+    MINI_CHECK(decodesTo(CompressedIndices::encode(triangles.data(),1),
+                         { triangles[0] }));
+    MINI_CHECK(decodesTo(CompressedIndices::encode(triangles.data(),triangles.size()),
+                         triangles));
+  }
+  // a coherent mesh that spans several blocks; also has to actually
+  // compress
+  {
+    const std::vector<vec3i> triangles = makeGrid(300,100);
+    MINI_CHECK(triangles.size() > 2*CompressedIndices::TRIANGLES_PER_BLOCK);
+    const CompressedIndices encoded
+      = CompressedIndices::encode(triangles.data(),triangles.size());
+    MINI_CHECK(decodesTo(encoded,triangles));
+    MINI_CHECK(encoded.sizeInBytes() < triangles.size()*sizeof(vec3i)/2);
+  }
+  // incoherent ones, with (very) large indices; also exactly one
+  // block, and one triangle more
+  for (int maxIndex : { 10, 100000, (1<<30) }) {
+    const std::vector<vec3i> triangles = makeRandom(50000,maxIndex,maxIndex);
+    MINI_CHECK(decodesTo(CompressedIndices::encode(triangles.data(),triangles.size()),
+                         triangles));
+  }
+  for (size_t numTriangles : { size_t(CompressedIndices::TRIANGLES_PER_BLOCK),
+                               size_t(CompressedIndices::TRIANGLES_PER_BLOCK+1) }) {
+    const std::vector<vec3i> triangles = makeRandom(numTriangles,1000,7);
+    MINI_CHECK(decodesTo(CompressedIndices::encode(triangles.data(),numTriangles),
+                         triangles));
+  }
+}
+
+void testInvalidInput()
+{
+  // negative indices can't get encoded
+  const vec3i negative(0,-1,2);
+  MINI_CHECK_THROWS(CompressedIndices::encode(&negative,1));
+
+  const std::vector<vec3i> triangles = makeGrid(200,100);
+  const CompressedIndices valid
+    = CompressedIndices::encode(triangles.data(),triangles.size());
+  std::vector<vec3i> decoded(triangles.size()+1);
+
+  // inconsistent block tables
+  {
+    CompressedIndices bad = valid;
+    bad.blockBases.pop_back();
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  {
+    CompressedIndices bad = valid;
+    bad.blockOffsets.back()++;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  {
+    CompressedIndices bad = valid;
+    std::swap(bad.blockOffsets[0],bad.blockOffsets[1]);
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  {
+    CompressedIndices bad = valid;
+    bad.numTriangles++;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  // a truncated block
+  {
+    CompressedIndices bad = valid;
+    bad.bytes.pop_back();
+    bad.blockOffsets.back()--;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  // a block with data left over
+  {
+    CompressedIndices bad = valid;
+    bad.bytes.push_back(0);
+    bad.blockOffsets.back()++;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  // a block whose last varint doesn't end
+  {
+    CompressedIndices bad = valid;
+    bad.bytes.back() = 0x80;
+    MINI_CHECK_THROWS(bad.decode(decoded.data()));
+  }
+  // flipped bits may or may not get noticed, but must never make the
+  // decoder read (or write) out of bounds
+  std::mt19937 rng(42);
+  for (int i=0;i<1000;i++) {
+    CompressedIndices bad = valid;
+    bad.bytes[rng()%bad.bytes.size()] ^= uint8_t(1 << (rng()%8));
+    try {
+      bad.decode(decoded.data());
+    } catch (const std::exception &) {}
+  }
+}
+
+int main(int, char **)
+{
+  testRoundTrips();
+  testInvalidInput();
+  return testing::testResult("index codec");
+}
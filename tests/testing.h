@@ -0,0 +1,79 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+/*! minimal helpers for the unit tests in this directory: every check
+    that fails gets reported (with file and line), and a test's
+    main() returns testResult(), which is non-zero if any failed */
+
+#include "miniScene/common.h"
+#include <random>
+
+namespace mini {
+  namespace testing {
+
+    inline int &numFailedChecks()
+    {
+      static int numFailed = 0;
+      return numFailed;
+    }
+
+    inline void check(bool passed, const char *what,
+                      const char *file, int line)
+    {
+      if (passed) return;
+      std::cerr << MINI_TERMINAL_RED
+                << file << ":" << line << ": check failed: " << what
+                << MINI_TERMINAL_DEFAULT << std::endl;
+      numFailedChecks()++;
+    }
+
+    /*! whether calling 'fn' throws a std::exception */
+    template<typename Fn>
+    bool throws(const Fn &fn)
+    {
+      try {
+        fn();
+      } catch (const std::exception &) {
+        return true;
+      }
+      return false;
+    }
+
+    /*! prints a summary, and returns what main() should return */
+    inline int testResult(const std::string &testName)
+    {
+      if (numFailedChecks()) {
+        std::cout << MINI_TERMINAL_RED << testName << ": "
+                  << numFailedChecks() << " check(s) failed"
+                  << MINI_TERMINAL_DEFAULT << std::endl;
+        return 1;
+      }
+      std::cout << MINI_TERMINAL_GREEN << testName << ": all checks passed"
+                << MINI_TERMINAL_DEFAULT << std::endl;
+      return 0;
+    }
+
+  } // ::mini::testing
+} // ::mini
+
+#define MINI_CHECK(cond)                                                \
+  mini::testing::check((cond),#cond,__FILE__,__LINE__)
+
+#define MINI_CHECK_THROWS(expr)                                         \
+  mini::testing::check(mini::testing::throws([&]() { expr; }),          \
+                       #expr " throws",__FILE__,__LINE__)
@@ -43,8 +43,16 @@ namespace mini {
     return bounds;
   }
 
+  /*! the arrays of a mesh that's being extracted */
+  struct ExtractedArrays {
+    std::vector<vec3f> vertices;
+    std::vector<vec3f> normals;
+    std::vector<vec2f> texcoords;
+    std::vector<vec3i> indices;
+  };
+  
   uint32_t findOrExtractVertex(Mesh::SP inMesh,
-                               Mesh::SP outMesh,
+                               ExtractedArrays &out,
                                uint32_t vtxID,
                                std::map<uint32_t,uint32_t> &alreadyExtracted)
   {
@@ -52,12 +60,12 @@ namespace mini {
     if (it != alreadyExtracted.end())
       return it->second;
 
-    size_t newID = outMesh->vertices.size();
-    outMesh->vertices.push_back(inMesh->vertices[vtxID]);
+    size_t newID = out.vertices.size();
+    out.vertices.push_back(inMesh->vertices[vtxID]);
     if (!inMesh->normals.empty())
-      outMesh->normals.push_back(inMesh->normals[vtxID]);
+      out.normals.push_back(inMesh->normals[vtxID]);
     if (!inMesh->texcoords.empty())
-      outMesh->texcoords.push_back(inMesh->texcoords[vtxID]);
+      out.texcoords.push_back(inMesh->texcoords[vtxID]);
     
     alreadyExtracted[vtxID] = newID;
     return newID;
@@ -66,13 +74,20 @@ namespace mini {
   Mesh::SP extractMesh(Mesh::SP in, const std::vector<vec3i> &indices)
   {
     std::map<uint32_t,uint32_t> alreadyExtracted;
-    Mesh::SP out = Mesh::create(in->material);
+    // (build the arrays in plain vectors, and move them into the
+    // mesh once complete)
+    ExtractedArrays arrays;
     for (auto idx : indices) {
-      idx.x = findOrExtractVertex(in,out,idx.x,alreadyExtracted);
-      idx.y = findOrExtractVertex(in,out,idx.y,alreadyExtracted);
-      idx.z = findOrExtractVertex(in,out,idx.z,alreadyExtracted);
-      out->indices.push_back(idx);
+      idx.x = findOrExtractVertex(in,arrays,idx.x,alreadyExtracted);
+      idx.y = findOrExtractVertex(in,arrays,idx.y,alreadyExtracted);
+      idx.z = findOrExtractVertex(in,arrays,idx.z,alreadyExtracted);
+      arrays.indices.push_back(idx);
     }
+    Mesh::SP out = Mesh::create(in->material);
+    out->vertices  = std::move(arrays.vertices);
+    out->normals   = std::move(arrays.normals);
+    out->texcoords = std::move(arrays.texcoords);
+    out->indices   = std::move(arrays.indices);
     return out;
   }
 
@@ -104,11 +119,19 @@ namespace mini {
       int dim = arg_max(centBounds.size());
       float pos = centBounds.center()[dim];
       std::cout << " -> splitting at " << ('x'+dim) << " = " << pos << std::endl;
-      for (auto idx : mesh->indices)
-        if (getBounds(mesh,idx).center()[dim] < pos)
-          lIndices.push_back(idx);
-        else
-          rIndices.push_back(idx);
+      std::vector<vec3i> indices = mesh->indices;
+      auto mid = parallel_partition
+        (indices.begin(),indices.end(),
+         [&](const vec3i idx) {
+           box3f bounds;
+           bounds.extend(mesh->vertices[idx.x]);
+           bounds.extend(mesh->vertices[idx.y]);
+           bounds.extend(mesh->vertices[idx.z]);
+           return bounds.center()[dim] < pos;
+         });
+      rIndices.assign(mid,indices.end());
+      indices.erase(mid,indices.end());
+      lIndices = std::move(indices);
     }
     Mesh::SP lMesh = extractMesh(mesh,lIndices);
     Mesh::SP rMesh = extractMesh(mesh,rIndices);
@@ -160,7 +183,8 @@ namespace mini {
     return out;
   }
   
-  Scene::SP breakLargeMeshes(Scene::SP in, size_t maxMeshSize)
+  Scene::SP breakLargeMeshes(Scene::SP in, size_t maxMeshSize,
+                             const Progress &progress)
   {
     Scene::SP out = Scene::create();
 
@@ -172,8 +196,12 @@ namespace mini {
     for (auto inst : in->instances) 
       brokenObjects[inst->object] = {};
 
-    for (auto &pair : brokenObjects)
+    ProgressStage stage(progress,"breaking objects",brokenObjects.size());
+    for (auto &pair : brokenObjects) {
+      progress.checkCancelled();
       pair.second = breakObject(pair.first,maxMeshSize);
+      stage.advance();
+    }
 
     for (auto inst : in->instances) {
       auto &fragments = brokenObjects[inst->object];
@@ -209,16 +237,22 @@ namespace mini {
     std::cout << MINI_TERMINAL_LIGHT_BLUE
               << "loading mini file from " << inFileName 
               << MINI_TERMINAL_DEFAULT << std::endl;
-    Scene::SP scene = Scene::load(inFileName);
+    Progress progress;
+    progress.callback = Progress::printToConsole();
+    LoadOptions loadOptions;
+    loadOptions.progress = progress;
+    Scene::SP scene = Scene::load(inFileName,loadOptions);
     std::cout << MINI_TERMINAL_LIGHT_GREEN
               << "#miniSeparateRootMeshes: scene loaded."
               << MINI_TERMINAL_DEFAULT << std::endl;
     
-    Scene::SP separated = breakLargeMeshes(scene,maxMeshSize);
+    Scene::SP separated = breakLargeMeshes(scene,maxMeshSize,progress);
     std::cout << MINI_TERMINAL_LIGHT_BLUE
               << "done separating; saving to " << outFileName 
               << MINI_TERMINAL_DEFAULT << std::endl;
-    separated->save(outFileName);
+    SaveOptions saveOptions;
+    saveOptions.progress = progress;
+    separated->save(outFileName,saveOptions);
     std::cout << MINI_TERMINAL_LIGHT_GREEN
               << "#miniSeparateRootMeshes: scene saved."
               << MINI_TERMINAL_DEFAULT << std::endl;
@@ -0,0 +1,74 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Scene.h"
+#include "miniScene/Dedup.h"
+
+using namespace mini;
+
+void usage(const std::string &msg)
+{
+  if (!msg.empty()) std::cerr << std::endl << "***Error***: " << msg << std::endl << std::endl;
+  std::cout << "Usage: ./miniDedupMaterials in.mini -o out.mini [options]" << std::endl;
+  std::cout << "merges all materials that have the same type, parameters, and textures\n"
+            << "(e.g., the one-material-per-mesh that some importers create)\n";
+  std::cout << "Options:\n";
+  std::cout << "  --progress             : print progress\n";
+  exit(msg != "");
+}
+
+int main(int ac, char **av)
+{
+  std::string inFileName = "";
+  std::string outFileName = "";
+  Progress progress;
+
+  for (int i=1;i<ac;i++) {
+    const std::string arg = av[i];
+    if (arg == "-o") {
+      outFileName = av[++i];
+    } else if (arg == "--progress") {
+      progress.callback = Progress::printToConsole();
+    } else if (arg[0] != '-')
+      inFileName = arg;
+    else
+      usage("unknown cmd line arg '"+arg+"'");
+  }
+
+  if (inFileName.empty()) usage("no input file name specified");
+  if (outFileName.empty()) usage("no output file name specified");
+
+  std::cout << MINI_TERMINAL_BLUE
+            << "loading mini file from " << inFileName
+            << MINI_TERMINAL_DEFAULT << std::endl;
+  LoadOptions loadOptions;
+  loadOptions.progress = progress;
+  Scene::SP scene = Scene::load(inFileName,loadOptions);
+
+  DedupMaterialsStats stats = dedupMaterials(scene,progress);
+  std::cout << "merged " << prettyNumber(stats.numMaterialsBefore) << " materials into "
+            << prettyNumber(stats.numMaterialsAfter) << " ("
+            << prettyNumber(stats.numMeshesRewired) << " meshes rewired)" << std::endl;
+
+  std::cout << MINI_TERMINAL_BLUE
+            << "saving deduplicated scene to " << outFileName
+            << MINI_TERMINAL_DEFAULT << std::endl;
+  SaveOptions saveOptions;
+  saveOptions.progress = progress;
+  scene->save(outFileName,saveOptions);
+  std::cout << MINI_TERMINAL_GREEN << "done." << MINI_TERMINAL_DEFAULT << std::endl;
+  return 0;
+}
@@ -55,6 +55,11 @@ namespace mini {
     material->baseColor    = rng3f();
     material->colorTexture = makeTexture();
     Mesh::SP mesh = Mesh::create(material);
+    // (get the arrays for writing once, rather than per element)
+    std::vector<vec3f> &vertices  = mesh->vertices.edit();
+    std::vector<vec3f> &normals   = mesh->normals.edit();
+    std::vector<vec2f> &texcoords = mesh->texcoords.edit();
+    std::vector<vec3i> &indices   = mesh->indices.edit();
     for (int i=0;i<=sphereRes;i++)
       for (int j=0;j<2*sphereRes;j++) {
         float fu = j/(2.f*sphereRes);
@@ -65,9 +70,9 @@ namespace mini {
         n.x = cos(u)*sin(v);
         n.y = sin(u)*sin(v);
         n.z = cos(v);
-        mesh->normals.push_back(n);
-        mesh->texcoords.push_back({fu,fv});
-        mesh->vertices.push_back(center + n*radius);
+        normals.push_back(n);
+        texcoords.push_back({fu,fv});
+        vertices.push_back(center + n*radius);
       }
     for (int j=0;j<sphereRes;j++)
       for (int i=0;i<2*sphereRes;i++) {
@@ -78,8 +83,8 @@ namespace mini {
           : j*(2*sphereRes) + ((i+1)%(2*sphereRes));
         int i10 = i00 + 2*sphereRes;
         int i11 = i01 + 2*sphereRes;
-        mesh->indices.push_back({i00,i01,i11});
-        mesh->indices.push_back({i00,i11,i10});
+        indices.push_back({i00,i01,i11});
+        indices.push_back({i00,i11,i10});
       }
     return mesh;
   }
@@ -16,6 +16,7 @@
 
 #include "miniScene/Scene.h"
 #include "miniScene/Serialized.h"
+#include "miniScene/Memory.h"
 
 namespace mini {
 
@@ -36,16 +37,20 @@ namespace mini {
     size_t numUniqueMeshes = 0;
     size_t numUniqueTriangles = 0;
     size_t numUniqueVertices = 0;
+    size_t numUniqueIndex16Meshes = 0;
     
-    for (auto mesh : serialized.meshes.list) {
+    for (const auto &mesh : serialized.meshes.list) {
       numUniqueMeshes++;
-      numUniqueTriangles += mesh->indices.size();
+      numUniqueTriangles += mesh->getNumPrims();
       numUniqueVertices  += mesh->vertices.size();
+      if (mesh->canUseCompactIndices())
+        numUniqueIndex16Meshes++;
     }
     std::cout << "----" << std::endl;
     std::cout << "num *unique* meshes\t: "    << myPretty(numUniqueMeshes) << std::endl;
     std::cout << "num *unique* triangles\t: " << myPretty(numUniqueTriangles) << std::endl;
     std::cout << "num *unique* vertices\t: "  << myPretty(numUniqueVertices) << std::endl;
+    std::cout << "  (meshes w/ 16-bit idx\t: "  << myPretty(numUniqueIndex16Meshes) << ")" << std::endl;
 
     size_t numActualMeshes = 0;
     size_t numActualTriangles = 0;
@@ -53,14 +58,14 @@ namespace mini {
     size_t numActualNormals = 0;
     size_t numActualTexcoords = 0;
     
-    for (auto inst : scene->instances)
+    for (const auto &inst : scene->instances)
       if (inst && inst->object)
-        for (auto mesh : inst->object->meshes) {
+        for (const auto &mesh : inst->object->meshes) {
           numActualMeshes++;
-          numActualTriangles += mesh->indices.size();
+          numActualTriangles += mesh->getNumPrims();
           numActualVertices  += mesh->vertices.size();
-          numActualNormals  += mesh->normals.size();
-          numActualTexcoords  += mesh->texcoords.size();
+          numActualNormals  += mesh->getNumNormals();
+          numActualTexcoords  += mesh->getNumTexcoords();
         }
     
     std::cout << "----" << std::endl;
@@ -77,7 +82,7 @@ namespace mini {
     size_t numPtex = 0;
     size_t bytesPtex = 0;
     size_t bytesTexels = 0;
-    for (auto tex : serialized.textures.list)
+    for (const auto &tex : serialized.textures.list)
       if (tex) {
         numTextures++;
         switch (tex->format) {
@@ -109,16 +114,42 @@ namespace mini {
       std::cout << "has env-map light?\t: no"  << std::endl;
 
     std::cout << "bounding box\t: " << scene->getBounds() << std::endl;
+
+    MemoryStats mem = memory::getStats();
+    std::cout << "----" << std::endl;
+    std::cout << "num huge-page arrays\t: " << myPretty(mem.numHugePageArrays) << std::endl;
+    std::cout << " - #bytes advised\t: " << myPretty(mem.hugePageAdvisedBytes) << std::endl;
+    std::cout << " - #bytes backed\t: " << myPretty(mem.hugePageBackedBytes) << std::endl;
+    std::cout << "num numa nodes\t\t: " << myPretty(memory::getNumaNodes().size()) << std::endl;
+    std::cout << "num numa-placed arrays\t: " << myPretty(mem.numNumaPlacedArrays) << std::endl;
+    std::cout << " - #bytes placed\t: " << myPretty(mem.numaPlacedBytes) << std::endl;
+    for (size_t node=0;node<mem.bytesOnNumaNode.size();node++)
+      std::cout << " - #bytes on node " << node << "\t: "
+                << myPretty(mem.bytesOnNumaNode[node]) << std::endl;
   }
     
   void miniInfo(int ac, char **av)
   {
     std::string inFileName = "";
+    LoadOptions options;
     for (int i=1;i<ac;i++) {
       std::string arg = av[i];
       if (arg[0] != '-')
         inFileName = arg;
-      else
+      else if (arg == "--numa") {
+        std::string mode = av[++i];
+        if (mode == "default")
+          options.numaPlacement = NUMA_DEFAULT;
+        else if (mode == "interleave")
+          options.numaPlacement = NUMA_INTERLEAVE;
+        else if (mode == "round-robin")
+          options.numaPlacement = NUMA_ROUND_ROBIN;
+        else if (mode == "partitioned")
+          options.numaPlacement = NUMA_PARTITIONED;
+        else
+          throw std::runtime_error("unknown numa placement '"+mode+"'"
+                                   " (must be default, interleave, round-robin, or partitioned)");
+      } else
         throw std::runtime_error("unknown cmdline argument '"+arg+"'");
     }
     if (inFileName.empty())
@@ -127,7 +158,7 @@ namespace mini {
     std::cout << MINI_TERMINAL_LIGHT_BLUE
               << "loading mini file from " << inFileName 
               << MINI_TERMINAL_DEFAULT << std::endl;
-    Scene::SP scene = Scene::load(inFileName);
+    Scene::SP scene = Scene::load(inFileName,options);
     std::cout << MINI_TERMINAL_LIGHT_GREEN
               << "#miniInfo: scene loaded."
               << MINI_TERMINAL_DEFAULT << std::endl;
@@ -58,27 +58,70 @@ int main(int ac, char **av)
             << "loading binmesh file from " << inFileName
             << MINI_TERMINAL_DEFAULT << std::endl;
 
-  Scene::SP scene = Scene::load(inFileName);
+  LoadOptions loadOptions;
+  loadOptions.progress.callback = Progress::printToConsole();
+  Scene::SP scene = Scene::load(inFileName,loadOptions);
   std::cout << MINI_TERMINAL_GREEN
             << "scene loaded; now flattening into a single mesh... "
             << std::endl;
-  std::vector<vec3f> vertices;
-  std::vector<vec3i> indices;
-  std::set<Object::SP> alreadyEmittedInstances;
-  for (auto inst : scene->instances) {
+  const InstanceArrays instances = scene->getInstanceArrays();
+
+  // first, figure out which instances to emit ...
+  std::vector<size_t> emittedInstances;
+  std::vector<bool> alreadyEmittedObjects(instances.objects.size(),false);
+  for (size_t instID=0;instID<instances.size();instID++) {
+    uint32_t objID = instances.objectIDs[instID];
+    if (objID == InstanceArrays::INVALID_ID) continue;
     if (firstInstOnly) {
-      if (alreadyEmittedInstances.find(inst->object) !=
-          alreadyEmittedInstances.end()) continue;
-      alreadyEmittedInstances.insert(inst->object);
-    }
-    for (auto mesh : inst->object->meshes) {
-      int idxOfs = (int)vertices.size();
-      for (auto vtx : mesh->vertices)
-        vertices.push_back(xfmPoint(inst->xfm,vtx));
-      for (auto idx : mesh->indices)
-        indices.push_back(idxOfs+idx);
+      if (alreadyEmittedObjects[objID]) continue;
+      alreadyEmittedObjects[objID] = true;
     }
+    emittedInstances.push_back(instID);
   }
+
+  // ... then where in the output each of them goes ...
+  std::vector<size_t> objectNumVertices(instances.objects.size(),0);
+  std::vector<size_t> objectNumIndices(instances.objects.size(),0);
+  for (size_t objID=0;objID<instances.objects.size();objID++)
+    for (auto &mesh : instances.objects[objID]->meshes) {
+      objectNumVertices[objID] += mesh->vertices.size();
+      objectNumIndices[objID]  += mesh->indices.size();
+    }
+  std::vector<size_t> vertexOffsets(emittedInstances.size());
+  std::vector<size_t> indexOffsets(emittedInstances.size());
+  parallel_for
+    (emittedInstances.size(),
+     [&](size_t i) {
+       uint32_t objID = instances.objectIDs[emittedInstances[i]];
+       vertexOffsets[i] = objectNumVertices[objID];
+       indexOffsets[i]  = objectNumIndices[objID];
+     },16*1024);
+  const size_t numVertices = parallel_exclusive_scan(vertexOffsets);
+  const size_t numIndices  = parallel_exclusive_scan(indexOffsets);
+
+  // ... and finally, let all instances write their part in parallel
+  std::vector<vec3f> vertices(numVertices);
+  std::vector<vec3i> indices(numIndices);
+  Progress progress;
+  progress.callback = Progress::printToConsole();
+  parallel_for_blocked
+    (progress,"flattening instances",
+     (size_t)0,emittedInstances.size(),1,
+     [&](size_t begin, size_t end) {
+       for (size_t i=begin;i<end;i++) {
+         const size_t   instID = emittedInstances[i];
+         const affine3f &xfm   = instances.xfms[instID];
+         const Object   &obj   = *instances.objects[instances.objectIDs[instID]];
+         size_t vtxOfs = vertexOffsets[i];
+         size_t idxOfs = indexOffsets[i];
+         for (auto &mesh : obj.meshes) {
+           for (auto idx : mesh->indices)
+             indices[idxOfs++] = int(vtxOfs)+idx;
+           for (auto vtx : mesh->vertices)
+             vertices[vtxOfs++] = xfmPoint(xfm,vtx);
+         }
+       }
+     });
   
   std::cout << MINI_TERMINAL_BLUE
             << "done flattening into a single mesh; saving to " << outFileName
@@ -93,8 +93,9 @@ namespace mini {
 #if 1
             for (auto mesh : org->object->meshes) {
               Object::SP newObj = std::make_shared<Object>();
-              Mesh::SP newMesh = std::make_shared<Mesh>();
-              *newMesh = *mesh;
+              // the mesh's arrays are copy-on-write, so this doesn't
+              // actually copy any vertices or indices
+              Mesh::SP newMesh = std::make_shared<Mesh>(*mesh);
               newObj->meshes.push_back(newMesh);
               Instance::SP newInst = std::make_shared<Instance>(newObj,
                                                                 xfm*org->xfm);
@@ -103,8 +104,7 @@ namespace mini {
 #else
             Object::SP newObj = std::make_shared<Object>();
             for (auto mesh : org->object->meshes) {
-              Mesh::SP newMesh = std::make_shared<Mesh>();
-              *newMesh = *mesh;
+              Mesh::SP newMesh = std::make_shared<Mesh>(*mesh);
               newObj->meshes.push_back(newMesh);
             }
             out->instances.push_back(std::make_shared<Instance>(newObj,
@@ -0,0 +1,132 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Scene.h"
+#include <fstream>
+
+using namespace mini;
+
+void usage(const std::string &msg)
+{
+  if (!msg.empty()) std::cerr << std::endl << "***Error***: " << msg << std::endl << std::endl;
+  std::cout << "Usage: ./miniRecode in.mini -o out.mini [options]" << std::endl;
+  std::cout << "loads a mini scene, and saves it again with the given encoding options\n";
+  std::cout << "Options:\n";
+  std::cout << "  --xfm-palette          : store instance transforms as a palette of unique\n"
+            << "                           linear parts plus per-instance translations (lossless)\n";
+  std::cout << "  --xfm-quantize <err>   : like --xfm-palette, but also quantize rotation+uniform\n"
+            << "                           scale transforms whose max (relative) error is <= err\n";
+  std::cout << "  --index16              : store indices of meshes with <= 64K vertices as 16-bit\n";
+  std::cout << "  --compress-indices     : store indices delta/varint-compressed (lossless)\n";
+  std::cout << "  --compress-floats      : store vertices, normals, and texcoords compressed\n"
+            << "                           (lossless)\n";
+  std::cout << "  --blocks <lz|zstd>     : write the file as independently compressed blocks\n";
+  std::cout << "  --block-size <MB>      : uncompressed size of these blocks (default 2)\n";
+  std::cout << "  --checksums            : store checksums, for verifying the file (see miniVerify)\n";
+  std::cout << "  --stripes <N>          : save as a manifest plus N stripe files (<out>.stripe<i>)\n";
+  std::cout << "  --quantize-positions <err>\n"
+            << "                         : store vertex positions as 16- or 21-bit values relative\n"
+            << "                           to each mesh's bounds, with (object-space) error <= err\n";
+  std::cout << "  --quantize-attributes  : store normals octahedral-encoded, and texcoords as\n"
+            << "                           16-bit values (lossy)\n";
+  exit(msg != "");
+}
+
+size_t fileSize(const std::string &fileName)
+{
+  std::ifstream in(fileName,std::ios::binary|std::ios::ate);
+  return in.good() ? (size_t)in.tellg() : 0;
+}
+
+int main(int ac, char **av)
+{
+  std::string inFileName = "";
+  std::string outFileName = "";
+  SaveOptions options;
+
+  for (int i=1;i<ac;i++) {
+    const std::string arg = av[i];
+    if (arg == "-o") {
+      outFileName = av[++i];
+    } else if (arg == "--xfm-palette") {
+      options.compactTransforms = true;
+    } else if (arg == "--xfm-quantize") {
+      options.compactTransforms = true;
+      options.transformQuantizationError = std::stof(av[++i]);
+    } else if (arg == "--index16") {
+      options.compactIndices = true;
+    } else if (arg == "--compress-indices") {
+      options.compressIndices = true;
+    } else if (arg == "--compress-floats") {
+      options.compressFloats = true;
+    } else if (arg == "--blocks") {
+      const std::string codec = av[++i];
+      if (codec == "lz")
+        options.blockCompression = BLOCK_COMPRESSION_LZ;
+      else if (codec == "zstd")
+        options.blockCompression = BLOCK_COMPRESSION_ZSTD;
+      else
+        usage("unknown block compression '"+codec+"'");
+      if (!isBlockCompressionAvailable(options.blockCompression))
+        usage("block compression '"+codec+"' is not available in this build");
+    } else if (arg == "--block-size") {
+      options.blockSize = size_t(std::stof(av[++i])*(1<<20));
+    } else if (arg == "--checksums") {
+      options.checksums = true;
+    } else if (arg == "--stripes") {
+      options.numStripes = std::stoi(av[++i]);
+    } else if (arg == "--quantize-positions") {
+      options.positionQuantizationError = std::stof(av[++i]);
+    } else if (arg == "--quantize-attributes") {
+      options.quantizeAttributes = true;
+    } else if (arg[0] != '-')
+      inFileName = arg;
+    else
+      usage("unknown cmd line arg '"+arg+"'");
+  }
+
+  if (inFileName.empty()) usage("no input file name specified");
+  if (outFileName.empty()) usage("no output file name specified");
+
+  std::cout << MINI_TERMINAL_BLUE
+            << "loading mini file from " << inFileName
+            << MINI_TERMINAL_DEFAULT << std::endl;
+  Scene::SP scene = Scene::load(inFileName);
+
+  std::cout << MINI_TERMINAL_BLUE
+            << "saving recoded scene to " << outFileName
+            << MINI_TERMINAL_DEFAULT << std::endl;
+  CompressionStats stats;
+  options.compressionStats = &stats;
+  scene->save(outFileName,options);
+  for (auto &it : stats.arrays)
+    std::cout << "  " << it.first << ": "
+              << it.second.numCompressed << " of " << it.second.numArrays
+              << " arrays compressed, "
+              << prettyBytes(it.second.rawBytes) << " -> "
+              << prettyBytes(it.second.storedBytes)
+              << " (ratio " << it.second.ratio() << ")" << std::endl;
+
+  size_t outSize = fileSize(outFileName);
+  if (options.numStripes > 1)
+    for (int stripeID=0;stripeID<options.numStripes;stripeID++)
+      outSize += fileSize(stripeFileName(outFileName,stripeID));
+  std::cout << MINI_TERMINAL_GREEN
+            << "done; file size " << prettyBytes(fileSize(inFileName))
+            << " -> " << prettyBytes(outSize)
+            << MINI_TERMINAL_DEFAULT << std::endl;
+  return 0;
+}
@@ -32,56 +32,101 @@ namespace mini {
     exit(error.empty() ? 0 : 1);
   }
 
-  int addMidpoint(std::map<std::pair<int, int>, int> &alreadyAddedVertices,
-                  Mesh::SP oldMesh,
-                  int v0, int v1,
-                  Mesh::SP newMesh)
-  {
-    // Add midpoint to new vertices, if not added already
-    std::pair<int, int> pair = std::make_pair(std::min(v0, v1),std::max(v0, v1));
-    if (alreadyAddedVertices.find(pair) != alreadyAddedVertices.end())
-      return alreadyAddedVertices[pair];
-    
-    alreadyAddedVertices[pair] = newMesh->vertices.size();
-    
-    vec3f midpoint = .5f* (oldMesh->vertices[v0] + oldMesh->vertices[v1]);
-    newMesh->vertices.push_back(midpoint);
-    
-    if (!oldMesh->normals.empty()) {
-      vec3f midpoint = .5f* (oldMesh->normals[v0] + oldMesh->normals[v1]);
-      newMesh->normals.push_back(midpoint);
-    }
-    
-    if (!oldMesh->texcoords.empty()) {
-      vec2f midpoint = .5f* (oldMesh->texcoords[v0] + oldMesh->texcoords[v1]);
-      newMesh->texcoords.push_back(midpoint);
-    }
-    // Return the index of midpoint
-    return alreadyAddedVertices[pair];
-  }
-
+  /*! one triangle edge, identified by its (sorted) vertex pair, and
+      the 'slot' (3*triangle+edge) it was found in */
+  struct Edge {
+    uint64_t key;
+    size_t   slot;
+    inline bool operator<(const Edge &other) const
+    { return key < other.key || (key == other.key && slot < other.slot); }
+  };
+  
   Mesh::SP subdivide(Mesh::SP in)
   {
     Mesh::SP out = Mesh::create(in->material);
-
-    // Put original vertices to new mesh
-    out->vertices  = in->vertices;
-    out->normals   = in->normals;
-    out->texcoords = in->texcoords;
-    // Mapping between original vertices and midpoints vs new vertices
-    std::map<std::pair<int, int>, int> alreadyAddedVertices;
-    // Iterate each triangle
-    for (auto index : in->indices) {
-      int A = index.x, B = index.y, C = index.z;
-      int AB = addMidpoint(alreadyAddedVertices, in, A, B, out);
-      int BC = addMidpoint(alreadyAddedVertices, in, B, C, out);
-      int CA = addMidpoint(alreadyAddedVertices, in, C, A, out);
-      out->indices.push_back({ A, AB, CA });
-      out->indices.push_back({ B, BC, AB });
-      out->indices.push_back({ C, CA, BC });
-      out->indices.push_back({ AB, BC, CA });
-    }
-    
+    const Mesh &mesh = *in;
+    const size_t numTriangles = mesh.indices.size();
+    const size_t numVertices  = mesh.vertices.size();
+
+    // gather all edges (AB, BC, CA of each triangle), and sort them,
+    // so all slots sharing an edge end up next to each other
+    std::vector<Edge> edges(3*numTriangles);
+    parallel_for
+      (numTriangles,
+       [&](size_t triID) {
+         const vec3i index = mesh.indices[triID];
+         for (int e=0;e<3;e++) {
+           uint64_t v0 = (uint32_t)index[e];
+           uint64_t v1 = (uint32_t)index[(e+1)%3];
+           edges[3*triID+e] = { (std::min(v0,v1)<<32) | std::max(v0,v1), 3*triID+e };
+         }
+       },16*1024);
+    parallel_sort(edges.begin(),edges.end());
+
+    // each edge gets one midpoint; number them in order of the slot
+    // they first appear in, which is the order in which a serial
+    // pass over the triangles would create them
+    std::vector<size_t> midpointID(3*numTriangles,0);
+    parallel_for
+      (edges.size(),
+       [&](size_t i) {
+         if (i == 0 || edges[i].key != edges[i-1].key)
+           midpointID[edges[i].slot] = 1;
+       },16*1024);
+    const size_t numMidpoints = parallel_exclusive_scan(midpointID);
+    // ... and let all other slots of the same edge refer to it
+    parallel_for
+      (edges.size(),
+       [&](size_t i) {
+         if (i > 0 && edges[i].key == edges[i-1].key) return;
+         const size_t ID = midpointID[edges[i].slot];
+         for (size_t j=i+1;j<edges.size() && edges[j].key == edges[i].key;j++)
+           midpointID[edges[j].slot] = ID;
+       },16*1024);
+
+    // Put original vertices to new mesh, followed by the midpoints
+    std::vector<vec3f> vertices(numVertices+numMidpoints);
+    std::vector<vec3f> normals(mesh.normals.empty() ? 0 : vertices.size());
+    std::vector<vec2f> texcoords(mesh.texcoords.empty() ? 0 : vertices.size());
+    std::copy(mesh.vertices.begin(),mesh.vertices.end(),vertices.begin());
+    std::copy(mesh.normals.begin(),mesh.normals.end(),normals.begin());
+    std::copy(mesh.texcoords.begin(),mesh.texcoords.end(),texcoords.begin());
+    parallel_for
+      (edges.size(),
+       [&](size_t i) {
+         if (i > 0 && edges[i].key == edges[i-1].key) return;
+         const size_t slot = edges[i].slot;
+         const vec3i index = mesh.indices[slot/3];
+         const int v0 = index[slot%3];
+         const int v1 = index[(slot+1)%3];
+         const size_t newID = numVertices+midpointID[slot];
+         vertices[newID] = .5f* (mesh.vertices[v0] + mesh.vertices[v1]);
+         if (!normals.empty())
+           normals[newID] = .5f* (mesh.normals[v0] + mesh.normals[v1]);
+         if (!texcoords.empty())
+           texcoords[newID] = .5f* (mesh.texcoords[v0] + mesh.texcoords[v1]);
+       },16*1024);
+    edges.clear();
+
+    std::vector<vec3i> indices(4*numTriangles);
+    parallel_for
+      (numTriangles,
+       [&](size_t triID) {
+         const vec3i index = mesh.indices[triID];
+         int A = index.x, B = index.y, C = index.z;
+         int AB = int(numVertices+midpointID[3*triID+0]);
+         int BC = int(numVertices+midpointID[3*triID+1]);
+         int CA = int(numVertices+midpointID[3*triID+2]);
+         indices[4*triID+0] = { A, AB, CA };
+         indices[4*triID+1] = { B, BC, AB };
+         indices[4*triID+2] = { C, CA, BC };
+         indices[4*triID+3] = { AB, BC, CA };
+       },16*1024);
+
+    out->vertices  = std::move(vertices);
+    out->normals   = std::move(normals);
+    out->texcoords = std::move(texcoords);
+    out->indices   = std::move(indices);
     return out;
   }
   
@@ -111,7 +156,11 @@ namespace mini {
               << "loading mini file from " << inFileName
               << MINI_TERMINAL_DEFAULT << std::endl;
 
-    Scene::SP scene = Scene::load(inFileName);
+    Progress progress;
+    progress.callback = Progress::printToConsole();
+    LoadOptions loadOptions;
+    loadOptions.progress = progress;
+    Scene::SP scene = Scene::load(inFileName,loadOptions);
     std::set<Object::SP> objects;
     std::map<Mesh::SP, Mesh::SP> meshSubstitutions;
     // create list of all input objects
@@ -122,8 +171,12 @@ namespace mini {
         meshSubstitutions[mesh] = {};
     
     // now, compute 'replacement' for each input mesh, by subdividing it.
-    for (auto meshesIt : meshSubstitutions)
-      meshSubstitutions[meshesIt.first] = subdivide(meshesIt.first);
+    ProgressStage stage(progress,"subdividing meshes",meshSubstitutions.size());
+    for (auto &meshesIt : meshSubstitutions) {
+      progress.checkCancelled();
+      meshesIt.second = subdivide(meshesIt.first);
+      stage.advance();
+    }
     
     // now go over all objects, and do the substitution
     for (auto obj : objects)
@@ -133,7 +186,9 @@ namespace mini {
     // nothing to do for objects or instances; they've got their old
     // content swapped out by now.
     std::cout << "saving scene" << std::endl;
-    scene->save(outFileName);
+    SaveOptions saveOptions;
+    saveOptions.progress = progress;
+    scene->save(outFileName,saveOptions);
     
     std::cout << MINI_TERMINAL_LIGHT_GREEN
               << "#miniInfo: subdivided scene saved."
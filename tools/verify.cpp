@@ -0,0 +1,97 @@
+// ======================================================================== //
+// Copyright 2018-2024 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "miniScene/Scene.h"
+
+using namespace mini;
+
+void usage(const std::string &msg)
+{
+  if (!msg.empty()) std::cerr << std::endl << "***Error***: " << msg << std::endl << std::endl;
+  std::cout << "Usage: ./miniVerify in.mini [options]" << std::endl;
+  std::cout << "verifies the checksums of a mini file that was saved with checksums\n"
+            << "(e.g., with miniRecode --checksums), without loading it\n";
+  std::cout << "Options:\n";
+  std::cout << "  --load                 : also load the scene (verifying checksums while\n"
+            << "                           loading), which also checks the file's structure\n";
+  std::cout << "  --progress             : print progress\n";
+  exit(msg != "");
+}
+
+int main(int ac, char **av)
+{
+  std::string inFileName = "";
+  bool alsoLoad = false;
+  Progress progress;
+
+  for (int i=1;i<ac;i++) {
+    const std::string arg = av[i];
+    if (arg == "--load") {
+      alsoLoad = true;
+    } else if (arg == "--progress") {
+      progress.callback = Progress::printToConsole();
+    } else if (arg[0] != '-')
+      inFileName = arg;
+    else
+      usage("unknown cmd line arg '"+arg+"'");
+  }
+
+  if (inFileName.empty()) usage("no input file name specified");
+
+  std::cout << MINI_TERMINAL_BLUE
+            << "verifying mini file " << inFileName
+            << MINI_TERMINAL_DEFAULT << std::endl;
+  std::vector<std::string> problems;
+  try {
+    double t0 = getCurrentTime();
+    problems = Scene::verify(inFileName,progress);
+    double t1 = getCurrentTime();
+    std::cout << "checked all checksums in " << prettyDouble(t1-t0) << "s" << std::endl;
+  } catch (const std::exception &e) {
+    std::cout << MINI_TERMINAL_RED
+              << "could not verify file: " << e.what()
+              << MINI_TERMINAL_DEFAULT << std::endl;
+    return 1;
+  }
+  for (auto &problem : problems)
+    std::cout << MINI_TERMINAL_RED << "  " << problem
+              << MINI_TERMINAL_DEFAULT << std::endl;
+
+  if (problems.empty() && alsoLoad) {
+    LoadOptions options;
+    options.verifyChecksums = true;
+    options.progress = progress;
+    try {
+      Scene::load(inFileName,options);
+    } catch (const std::exception &e) {
+      problems.push_back(e.what());
+      std::cout << MINI_TERMINAL_RED
+                << "  could not load file: " << e.what()
+                << MINI_TERMINAL_DEFAULT << std::endl;
+    }
+  }
+
+  if (!problems.empty()) {
+    std::cout << MINI_TERMINAL_RED
+              << "file is corrupt (" << problems.size() << " problem(s) found)"
+              << MINI_TERMINAL_DEFAULT << std::endl;
+    return 1;
+  }
+  std::cout << MINI_TERMINAL_GREEN
+            << "file is intact"
+            << MINI_TERMINAL_DEFAULT << std::endl;
+  return 0;
+}